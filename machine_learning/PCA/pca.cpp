@@ -1,10 +1,40 @@
 #include <iostream>
 #include <iostream>
 #include <stdio.h>
+#include <math.h>
 #include "mat.h"
 #include "rand.h"
 using namespace std;
 
+// Dual PCA for when there are fewer samples (rows) than columns.
+// The principal axes lie in the span of the rows of the centered data
+// X so instead of the cols X cols covariance X^T X / rows diagonalize the
+// much smaller rows X rows Gram matrix G = X X^T.  If G u = l u then
+// X^T u is an axis with covariance eigenvalue l / rows and length
+// sqrt(l).  Returns false (and does nothing) when the covariance
+// should be used instead: more rows than columns, k not less than the
+// number of rows, or a kept axis with an eigenvalue too small to
+// recover its direction from.
+static bool dualAxes(Matrix &x, int k, Matrix &eigenvalues, Matrix &axes)
+{
+  if (x.maxRows() >= x.maxCols() || k >= x.maxRows()) return false;
+
+  Matrix gram, values;
+  gram = x.dotT(x);
+  values = gram.eigenSystemTopK(k);   // gram becomes the k vectors u in rows
+  if (!(values.get(0, k-1) > 1e-12*values.get(0, 0))) return false;
+
+  Matrix lengths(k, 1, 0.0);
+  for (int i=0; i<k; i++) lengths.set(i, 0, sqrt(values.get(0, i)));
+
+  axes = gram.dot(x);                 // row i is (X^T u_i)^T
+  axes.divColVector(lengths);
+  eigenvalues = values.scalarMult(1.0/x.maxRows());
+
+  return true;
+}
+
+
 int main()
 {
   Matrix sample_org;
@@ -18,33 +48,41 @@ int main()
   sample_center = sample_org;
   //double const mean = sample_org.mean();
   //printf("mean: %f\n",mean);
+  // one pass over the picture for the mean and standard deviation of each column
+  Matrix stats;
+  stats = sample_org.columnStats();
   Matrix mean;  
-  mean = sample_org.meanVec();
+  mean = stats.extract(Matrix::STAT_MEAN,0,1,0);
   sample_center.subRowVector(mean);
   Matrix stddevs;
-  stddevs = sample_org.stddevVec();
+  stddevs = stats.extract(Matrix::STAT_VARIANCE,0,1,0);
+  stddevs.map(sqrt);
   sample_center.divRowVector(stddevs);
   //sample_center.print();
   
-  // computer covariance matrix
-  Matrix covariaance_center;
-  covariaance_center = sample_center.cov();
-  //covariaance_center.print();
-  
-  // computer eigenvalues and eigenvectors pf covariaance_center matrix
-  Matrix eigenvalue_v, eigenvector_w;
-  eigenvector_w=covariaance_center; 
-  //eigenvetor_w destroys self by replacing self with eigenvectors in rows
-  //also return a new matrix constant eigenvalues;
-  eigenvalue_v = eigenvector_w.eigenSystem();
+  // computer eigenvalues and eigenvectors of the covariance matrix
+  // K_vectors gets the top k eigenvectors in rows sorted by eigenvalue
+  Matrix eigenvalue_v, K_vectors;
+  if (!dualAxes(sample_center, k, eigenvalue_v, K_vectors)) {
+    // computer covariance matrix
+    Matrix covariaance_center;
+    covariaance_center = sample_center.cov();
+    //covariaance_center.print();
+
+    Matrix eigenvector_w;
+    eigenvector_w=covariaance_center; 
+    //eigenvetor_w destroys self by replacing self with the top k eigenvectors in rows
+    //also return a new matrix constant eigenvalues;
+    //only the k we keep are computed rather than all of them
+    eigenvalue_v = eigenvector_w.eigenSystemTopK(k);
+    // normalize eigenvector_w
+    //eigenvector_w.normalizeCols();
+
+    //sort eigenvectors by eigenvalu, and pick k
+    // eigenvector_w already be sorted by eigenSystemTopK()
+    K_vectors = eigenvector_w.extract(0,0,k,0);
+  }
   eigenvalue_v.printSize("Eigenvalues");
-  // normalize eigenvector_w
-  //eigenvector_w.normalizeCols();
-  
-  //sort eigenvectors by eigenvalu, and pick k
-  // eigenvector_w already be sorted by eigenSystem()
-  Matrix K_vectors;
-  K_vectors = eigenvector_w.extract(0,0,k,0);
   //new data matrix
   Matrix new_matrix;
   new_matrix= sample_center.dotT(K_vectors);
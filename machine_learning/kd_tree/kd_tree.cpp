@@ -19,7 +19,7 @@ void build_kdtrees(Matrix &trees,int feature ,int start, int end){
 //    cout <<"end: "<<end<<endl;
     if (feature == features+1)
         feature = 1;
-    trees.sortRowsByCol(feature,start,end);    
+    trees.selectRowsByCol(feature,mid_point,start,end);
     feature++;
     if (end -start > 1){
         build_kdtrees(trees,feature,start,mid_point-1);
@@ -27,7 +27,7 @@ void build_kdtrees(Matrix &trees,int feature ,int start, int end){
     }
 }
 
-double dis(Matrix trees, Matrix others, int pick_point ){
+double dis(const Matrix &trees, const Matrix &others, int pick_point ){
 	double sum=0;
 	double tem=0;
 	for (int i=0; i < others.maxCols();i++ )
@@ -38,7 +38,7 @@ double dis(Matrix trees, Matrix others, int pick_point ){
 	return sqrt(sum);
 }
 
-void nearest(Matrix trees, Matrix item,int rowstart, int rowend,int feature, double &best, int &bestex){
+void nearest(const Matrix &trees, const Matrix &item,int rowstart, int rowend,int feature, double &best, int &bestex){
 	// for single node
 	if (rowstart == rowend){
 		cout<<"RANGE: "<<rowstart<<"  to  "<<rowend<<endl;
@@ -0,0 +1,8893 @@
+// // // // // // // // // // // // // // // // 
+//
+// Some simple matrix operators
+//
+// These routines are self contained except for random number
+// generation.   Comment these out if you want completely stand-alone
+// functionality.  Uses some code from Numerical Recipes (see comments).
+//
+// Author: Robert B. Heckendorn, University of Idaho, 2018
+// Version: 2.5
+// Date: Apr 7, 2018
+
+#include "mat.h"
+#ifdef WINDOWS
+#include <malloc.h>    // _aligned_malloc
+#define NOMINMAX
+#include <windows.h>   // mapping binary matrix files
+#else
+#include <sys/mman.h>  // mapping binary matrix files
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>   // std::min
+#include <string.h>    // memcpy
+#include <limits.h>    // INT_MAX
+#include <limits>      // std::numeric_limits
+#include <map>         // the profile by name and by operation
+#include <unordered_map>
+#include <chrono>      // timing for the profile
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>    // std::from_chars: strtod without the locale
+#endif
+#endif
+
+// the followin are routines taken from the book Numerical Recipes in C
+template <class T> static void householder(T **a, int n, double d[], double e[]);
+template <class T> static void eigen(double *d, double *e, int n, T **z);
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+//  class MatrixRowIter
+//
+//  a friend class to Matrix that iterates through a Matrix: a row iterator
+//
+//  Note: although it uses std::string it uses printf because I hate cout's
+//  awkwardness. :-)
+//  Note: errors are reported to stdout
+//
+
+// this allocates the space for the row
+template <class T>
+MatrixRowIterT<T>::MatrixRowIterT(MatrixT<T> *newmat)
+{
+    mat = newmat;
+    r = 0;
+    arow = new MatrixT<T>(1, mat->maxc, "row of " + newmat->name);  // allocate the space for the row matrix
+    more = true;
+}
+
+
+// this deallocates the row space
+template <class T>
+MatrixRowIterT<T>::~MatrixRowIterT()
+{
+    mat = NULL;
+    r = 0;
+    delete arow;                  // deallocate the row pointed to by arow
+    more = false;
+}
+
+
+
+// by row iterator
+template <class T>
+MatrixT<T> *MatrixRowIterT<T>::rowBegin()
+{
+    mat->assertDefined("MatrixRowIter");
+
+    r = 0;
+    for (int i=0; i<mat->maxc; i++) arow->m[0][i] = mat->m[r][i];
+    more = true;
+    arow->defined = true;
+    arow->submatrix = false;
+
+    return arow;
+}
+
+
+template <class T>
+MatrixT<T> *MatrixRowIterT<T>::rowNext()
+{
+    if (r < mat->maxr-1) {
+        r++;
+        for (int i=0; i<mat->maxc; i++) arow->m[0][i] = mat->m[r][i];
+        arow->defined = true;
+        arow->submatrix = false;
+    }
+    else {
+        more = false;
+    }
+    return arow;
+}
+
+
+template <class T>
+bool MatrixRowIterT<T>::rowNotEnd()
+{
+    return more;
+}
+
+
+template <class T>
+int MatrixRowIterT<T>::row()
+{
+    return r;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+//  Threads
+//
+// One pool of worker threads is shared by the whole library.  Its size
+// comes from Matrix::setThreads(n) or, if that has not been called, from
+// the environment variable MAT_THREADS or else the number of cores.  The
+// threads are started the first time a big enough job comes along.
+//
+// Work is split into independent pieces (blocks of rows or columns of
+// the answer) and each piece is computed exactly as the serial loop
+// would, so the answers do not depend on the number of threads.  Jobs
+// smaller than parallelMinWork (roughly in flops) are run serially.
+// A parallel region started from inside a worker or while another
+// thread is using the pool also just runs serially.
+//
+
+static const double parallelMinWork = 65536;
+
+class MatThreadPool {
+private:
+    struct Job {
+        const std::function<void(int)> *task;
+        int numTasks;
+        std::atomic<int> next;          // next task to hand out
+        std::atomic<int> pending;       // tasks not yet finished
+    };
+
+    int size;                           // number of threads including the caller
+    std::vector<std::thread> workers;
+    std::mutex lock;                    // protects everything below
+    std::mutex busy;                    // held by the thread running a job
+    std::condition_variable wake;       // workers wait on this for a job
+    std::condition_variable done;       // caller waits on this for the job to finish
+    Job *job;
+    unsigned long long generation;      // bumped for each job
+    int active;                         // workers currently looking at job
+    bool stop;
+
+    static thread_local bool inWorker;
+
+public:
+    static bool onWorker() { return inWorker; }
+
+private:
+    void doTasks(Job *j)
+    {
+        int i;
+
+        while ((i = j->next.fetch_add(1)) < j->numTasks) {
+            (*j->task)(i);
+            if (j->pending.fetch_sub(1)==1) {
+                std::lock_guard<std::mutex> g(lock);
+                done.notify_all();
+            }
+        }
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen;
+
+        inWorker = true;
+        std::unique_lock<std::mutex> g(lock);
+        seen = generation;
+        for (;;) {
+            wake.wait(g, [&]{ return stop || generation!=seen; });
+            if (stop) return;
+            seen = generation;
+            Job *j = job;
+            if (j==NULL) continue;
+            active++;
+            g.unlock();
+            doTasks(j);
+            g.lock();
+            if (--active==0) done.notify_all();
+        }
+    }
+
+    void stopWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> g(lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for (size_t i=0; i<workers.size(); i++) workers[i].join();
+        workers.clear();
+        stop = false;
+    }
+
+public:
+    MatThreadPool() : size(0), job(NULL), generation(0), active(0), stop(false) {}
+    ~MatThreadPool() { stopWorkers(); }
+
+    int threads()
+    {
+        if (size<=0) {
+            const char *env = getenv("MAT_THREADS");
+            int n = 0;
+
+            if (env) n = atoi(env);
+            if (n<=0) n = std::thread::hardware_concurrency();
+            size = (n<=0) ? 1 : n;
+        }
+
+        return size;
+    }
+
+    void setThreads(int n)
+    {
+        std::lock_guard<std::mutex> b(busy);
+
+        stopWorkers();
+        size = n;
+        threads();
+    }
+
+    // run task(0) ... task(numTasks-1) spread over the pool and wait for all of them
+    void run(int numTasks, const std::function<void(int)> &task)
+    {
+        if (inWorker || threads()<=1 || numTasks<=1 || !busy.try_lock()) {
+            for (int i=0; i<numTasks; i++) task(i);
+            return;
+        }
+
+        while ((int)workers.size() < size-1) {
+            workers.push_back(std::thread(&MatThreadPool::workerLoop, this));
+        }
+
+        Job j;
+        j.task = &task;
+        j.numTasks = numTasks;
+        j.next = 0;
+        j.pending = numTasks;
+        {
+            std::lock_guard<std::mutex> g(lock);
+            job = &j;
+            generation++;
+        }
+        wake.notify_all();
+
+        doTasks(&j);
+
+        {
+            std::unique_lock<std::mutex> g(lock);
+            done.wait(g, [&]{ return j.pending==0 && active==0; });
+            job = NULL;
+        }
+        busy.unlock();
+    }
+};
+
+thread_local bool MatThreadPool::inWorker = false;
+
+static MatThreadPool matPool;
+
+
+void MatrixBase::setThreads(int n)
+{
+    matPool.setThreads(n);
+}
+
+
+int MatrixBase::numThreads()
+{
+    return matPool.threads();
+}
+
+
+// Call body(lo, hi) on pieces that cover 0..n-1.  work is an estimate
+// of the total work and decides whether threads are worth using.  With
+// chunksPerThread>1 the pieces are smaller so uneven pieces balance out.
+// body is a template rather than a std::function so a call that stays on
+// this thread does not allocate.
+template <class Body>
+static void parallelFor(int n, double work, const Body &body, int chunksPerThread=4)
+{
+    int chunks;
+
+    if (n<=0) return;
+
+    chunks = matPool.threads() * chunksPerThread;
+    if (chunks>n) chunks = n;
+    if (work<parallelMinWork || chunks<=1) {
+        body(0, n);
+        return;
+    }
+
+    matPool.run(chunks, [&body, n, chunks](int i) {    // small enough for std::function to hold without allocating
+        body((int)((long long)n*i/chunks), (int)((long long)n*(i+1)/chunks));
+    });
+}
+
+
+// Matrix expressions are evaluated in the header so they use the pool through this
+void MatrixBase::parallelRows(int n, double work, const std::function<void(int lo, int hi)> &body)
+{
+    parallelFor(n, work, body);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+//  class Matrix
+//
+// A simple class for matrix operations.   It has some nice debugging features like
+// trying hard to check that the proper dimensions are used.   It is very draconian
+// about this so there is an important difference between row vectors and column vectors.
+// I find this helps students get the math to work out correctly if you pay attention to
+// this difference.   The routines allow you to name a matrix.  The name is then used
+// in debug output.   Other things checked include referencing out of bounds.
+// If a row is a nonnegative number then r row pointers will be allocated.
+// If a row and col are nonnegative numbers then c columns will be allocated for each row.
+// If a row is nonnegative but col is negative then only row pointers allocated which is used
+// for submatrices.
+// Note: if row<0 no space at all will be allocated.
+//
+// Default: isSubMatrix=false
+//
+// If Matrix::contiguous is true the rows all live in one block of
+// memory aligned to matAlign bytes.  Each row is padded out to a whole
+// number of alignment units so that every row starts aligned.  The row
+// pointers in m still point at each row, so routines that swap row
+// pointers (sorting, subMatrices) work in either storage mode.
+//
+bool MatrixBase::debug = false;
+bool MatrixBase::contiguous = true;
+unsigned long long MatrixBase::allocations = 0;
+unsigned long long MatrixBase::copies = 0;
+unsigned long long MatrixBase::moves = 0;
+
+static const int matAlign = 64;                                // bytes (one cache line)
+
+// allocate an aligned block of n elements
+template <class T>
+static T *alignedAlloc(size_t n)
+{
+    void *p;
+
+    if (n==0) n = 1;     // always return a real block
+#ifdef WINDOWS
+    p = _aligned_malloc(n*sizeof(T), matAlign);
+    if (p==NULL) {
+#else
+    if (posix_memalign(&p, matAlign, n*sizeof(T))!=0) {
+#endif
+        printf("ERROR(allocate): unable to allocate %lu bytes\n", (unsigned long)(n*sizeof(T)));
+        exit(1);
+    }
+
+    return (T *)p;
+}
+
+
+static void alignedFree(void *p)
+{
+#ifdef WINDOWS
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Workspaces
+//
+// The storage of a contiguous matrix is one block: a header, the rows and
+// then the row pointers.  The header says which workspace the block goes
+// back to when the matrix is freed (NULL means back to the heap).  A
+// workspace keeps its free blocks in lists by size and when it goes out
+// of scope frees those and lets the blocks still in use go to the heap.
+//
+
+struct alignas(matAlign) MatBlock {
+    MatrixWorkspace *owner;      // the workspace it goes back to or NULL
+    MatBlock *next;              // the next free block of the same size
+    size_t bytes;                // size of the block with this header
+    bool free;                   // waiting to be reused
+};
+
+static thread_local MatrixWorkspace *workspaceInScope = NULL;
+
+
+MatrixWorkspace::MatrixWorkspace()
+{
+    outer = workspaceInScope;
+    workspaceInScope = this;
+    hits = misses = 0;
+    bytes = peakBytes = 0;
+}
+
+
+MatrixWorkspace::~MatrixWorkspace()
+{
+    for (size_t i=0; i<held.size(); i++) {
+        MatBlock *b = (MatBlock *)held[i];
+
+        if (b->free) alignedFree(b);
+        else b->owner = NULL;            // its matrix frees it later
+    }
+    workspaceInScope = outer;
+}
+
+
+void MatrixWorkspace::resetStats()
+{
+    hits = misses = 0;
+    peakBytes = bytes;
+}
+
+
+void MatrixWorkspace::printStats(std::string msg)
+{
+    if (msg.length()) printf("%s ", msg.c_str());
+    printf("(workspace hits: %llu  misses: %llu  bytes: %llu  peak bytes: %llu)\n", hits, misses,
+           (unsigned long long)bytes, (unsigned long long)peakBytes);
+    fflush(stdout);
+}
+
+
+// n aligned bytes
+void *MatrixWorkspace::take(size_t n)
+{
+    MatrixWorkspace *ws = workspaceInScope;
+    MatBlock *b;
+
+    n += sizeof(MatBlock);
+    if (ws!=NULL) {
+        for (size_t i=0; i<ws->spare.size(); i++) {
+            b = (MatBlock *)ws->spare[i];
+            if (b->bytes==n) {
+                if (b->next!=NULL) ws->spare[i] = b->next;
+                else {
+                    ws->spare[i] = ws->spare.back();
+                    ws->spare.pop_back();
+                }
+                b->free = false;
+                ws->hits++;
+
+                return b + 1;
+            }
+        }
+        ws->misses++;
+    }
+
+    b = alignedAlloc<MatBlock>((n + sizeof(MatBlock) - 1)/sizeof(MatBlock));
+    b->owner = ws;
+    b->next = NULL;
+    b->bytes = n;
+    b->free = false;
+    if (ws!=NULL) {
+        ws->held.push_back(b);
+        ws->bytes += n;
+        if (ws->bytes>ws->peakBytes) ws->peakBytes = ws->bytes;
+    }
+
+    return b + 1;
+}
+
+
+void MatrixWorkspace::give(void *p)
+{
+    MatBlock *b = (MatBlock *)p - 1;
+    MatrixWorkspace *ws = b->owner;
+
+    if (ws==NULL) {
+        alignedFree(b);
+        return;
+    }
+
+    b->free = true;
+    for (size_t i=0; i<ws->spare.size(); i++) {
+        if (((MatBlock *)ws->spare[i])->bytes==b->bytes) {
+            b->next = (MatBlock *)ws->spare[i];
+            ws->spare[i] = b;
+            return;
+        }
+    }
+    b->next = NULL;
+    ws->spare.push_back(b);
+}
+
+
+static void unmapFile(void *p, size_t bytes);
+
+
+// free the space for the rows of a matrix in either storage mode.
+// If it is a submatrix the row content belongs to someone else and
+// only the row pointers are freed.  If the rows are in a mapped file
+// the file is unmapped.  Contiguous rows and their row pointers are one
+// block from MatrixWorkspace::take.
+template <class T>
+static void freeRows(T **m, T *data, int maxr, bool submatrix, void *mapping, size_t mappingBytes)
+{
+    if (!submatrix && mapping==NULL && data!=NULL) {
+        MatrixWorkspace::give(data);
+        return;
+    }
+
+    if (!submatrix) {
+        if (mapping!=NULL) unmapFile(mapping, mappingBytes);
+        else for (int i=0; i<maxr; i++) delete [] m[i];
+    }
+    delete [] m;
+}
+
+
+template <class T>
+void MatrixT<T>::allocate(int r, int c, std::string namex, bool isSubMatrix) 
+{
+    if (isSubMatrix) c=-1;
+    maxr = r;
+    maxc = c;
+    name = namex;
+    m = NULL;
+    data = NULL;
+    mapping = NULL;
+    mappingBytes = 0;
+    stride = 0;
+
+    if (maxr < 0 || maxc < 0) {
+        if (maxr != -1 && maxc !=-1) {
+            if (name.length()==0)
+                printf("ERROR(allocate): Trying to create a matrix of size %d X %d\n", r, c);
+            else
+                printf("ERROR(allocate): Trying to create matrix \"%s\" of size %d X %d\n",
+                       name.c_str(), r, c);
+            exit(1);
+        }
+    }
+
+    if (maxr>=0) {
+        if (maxc>=0 && contiguous) {
+            const int align = matAlign/sizeof(T);    // elements per alignment unit
+
+            stride = (maxc + align - 1)/align*align;
+            data = (T *)MatrixWorkspace::take((size_t)maxr*stride*sizeof(T) + maxr*sizeof(T *));
+            m = (T **)(data + (size_t)maxr*stride);  // the row pointers follow the rows
+            for (int i=0; i<maxr; i++) m[i] = data + (size_t)i*stride;
+        }
+        else {
+            m = new T * [maxr];
+            if (maxc>=0) {
+                for (int i=0; i<maxr; i++) m[i] = new T [maxc];
+            }
+        }
+        if (maxc>=0) {
+            allocations++;
+            if (profile) {
+                profileAlloc(m, name, data!=NULL ? (size_t)maxr*stride*sizeof(T) + maxr*sizeof(T *)
+                                                 : (size_t)maxr*(sizeof(T *) + maxc*sizeof(T)));
+            }
+        }
+    }
+
+    defined = false;
+    submatrix = isSubMatrix;
+    if (debug) printf("DEBUG(  allocate): name \"%s\", size %d X %d\n", name.c_str(), r, c);
+}
+
+
+template <class T>
+bool MatrixT<T>::deallocate()
+{
+    bool allocated;
+
+    allocated = (m!=NULL);
+    if (allocated) {
+        if (profile) profileFree(m);
+        freeRows(m, data, maxr, submatrix, mapping, mappingBytes);
+        m = NULL;   // to be sure
+    }
+    data = NULL;
+    mapping = NULL;
+    mappingBytes = 0;
+    stride = 0;
+
+    if (debug) printf("DEBUG(deallocate): name \"%s\", size %d X %d\n", name.c_str(), maxr, maxc);
+
+    defined = false;
+    submatrix = false;
+
+    return allocated;
+}
+
+
+template <class T>
+void MatrixT<T>::reallocate(int otherMaxr, int otherMaxc, std::string namex)
+{
+    if (maxr!=otherMaxr || maxc!=otherMaxc) {
+        deallocate();
+        allocate(otherMaxr, otherMaxc, namex);
+    }
+}
+
+
+// take over the storage of other leaving other an empty undefined
+// matrix.   Self must not own any storage when this is called.
+// The name is not moved.
+template <class T>
+void MatrixT<T>::stealStorage(MatrixT &other)
+{
+    defined = other.defined;
+    submatrix = other.submatrix;
+    maxr = other.maxr;
+    maxc = other.maxc;
+    stride = other.stride;
+    data = other.data;
+    m = other.m;
+    mapping = other.mapping;
+    mappingBytes = other.mappingBytes;
+
+    other.defined = false;
+    other.submatrix = false;
+    other.maxr = other.maxc = -1;
+    other.stride = 0;
+    other.data = NULL;
+    other.m = NULL;
+    other.mapping = NULL;
+    other.mappingBytes = 0;
+}
+
+
+void MatrixBase::resetCounts()
+{
+    allocations = copies = moves = 0;
+}
+
+
+void MatrixBase::printCounts(std::string msg)
+{
+    if (msg.length()) printf("%s ", msg.c_str());
+    printf("(allocations: %llu  copies: %llu  moves: %llu)\n", allocations, copies, moves);
+    fflush(stdout);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Profile
+//
+// Storage is charged to the name the matrix had when it was allocated
+// and copies to the name of the matrix copied from.  The storage of each
+// matrix is found again when it is freed by its row pointers.  Times are
+// for the outermost operation on each thread; operations run inside a
+// worker of the thread pool are part of the operation that started them.
+//
+
+struct ProfileName {
+    unsigned long long allocations;
+    unsigned long long copies;
+    double bytes;               // all storage ever allocated
+    double liveBytes;           // storage allocated and not yet freed
+    double peakBytes;           // the most live storage at one time
+};
+
+struct ProfileOp {
+    unsigned long long calls;
+    double seconds;
+};
+
+struct ProfileData {
+    std::mutex lock;
+    std::map<std::string, ProfileName> names;
+    std::map<std::pair<std::string, std::string>, ProfileOp> ops;   // by (operation, name)
+    std::unordered_map<const void *, std::pair<ProfileName *, double> > live;  // by row pointers
+    double start;
+};
+
+static double profileNow()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// never freed so it can be used while other statics are destroyed at exit
+static ProfileData *profileData()
+{
+    static ProfileData *p = NULL;
+    static std::once_flag once;
+
+    std::call_once(once, []{ p = new ProfileData; p->start = profileNow(); });
+
+    return p;
+}
+
+static thread_local int profileDepth = 0;
+
+static void profileAtExit()
+{
+    const char *env = getenv("MAT_PROFILE");
+
+    MatrixBase::printProfile(env!=NULL && strcmp(env, "json")==0, stderr);
+}
+
+static bool profileFromEnvironment()
+{
+    const char *env = getenv("MAT_PROFILE");
+
+    if (env==NULL || (strcmp(env, "text")!=0 && strcmp(env, "json")!=0)) return false;
+    profileData();
+    atexit(profileAtExit);
+
+    return true;
+}
+
+bool MatrixBase::profile = profileFromEnvironment();
+
+
+void MatrixBase::profileAlloc(const void *block, const std::string &name, size_t bytes)
+{
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+    ProfileName &n = p->names[name];
+
+    n.allocations++;
+    n.bytes += bytes;
+    n.liveBytes += bytes;
+    if (n.liveBytes > n.peakBytes) n.peakBytes = n.liveBytes;
+    p->live[block] = std::make_pair(&n, (double)bytes);
+}
+
+
+// storage allocated before profiling was turned on is not found and ignored
+void MatrixBase::profileFree(const void *block)
+{
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+    auto i = p->live.find(block);
+
+    if (i==p->live.end()) return;
+    i->second.first->liveBytes -= i->second.second;
+    p->live.erase(i);
+}
+
+
+void MatrixBase::profileCopy(const std::string &name)
+{
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+
+    p->names[name].copies++;
+}
+
+
+// only the outermost operation on a thread is counted and timed
+void MatrixBase::ProfileScope::begin(const char *opx, const std::string &namex)
+{
+    op = opx;
+    name = &namex;
+    start = (profileDepth++ > 0 || MatThreadPool::onWorker()) ? -1 : profileNow();
+    started = true;
+}
+
+
+void MatrixBase::ProfileScope::end()
+{
+    profileDepth--;
+    if (start<0) return;
+
+    double seconds = profileNow() - start;
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+    ProfileOp &o = p->ops[std::make_pair(std::string(op), *name)];
+
+    o.calls++;
+    o.seconds += seconds;
+}
+
+
+// the storage still live stays live and becomes the new peak
+void MatrixBase::resetProfile()
+{
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+
+    for (auto &i : p->names) {
+        i.second.allocations = i.second.copies = 0;
+        i.second.bytes = 0;
+        i.second.peakBytes = i.second.liveBytes;
+    }
+    p->ops.clear();
+    p->start = profileNow();
+}
+
+
+// a matrix name as a JSON string
+static void profileJsonString(FILE *fp, const std::string &s)
+{
+    fputc('"', fp);
+    for (size_t i=0; i<s.length(); i++) {
+        unsigned char c = s[i];
+
+        if (c=='"' || c=='\\') fprintf(fp, "\\%c", c);
+        else if (c<0x20) fprintf(fp, "\\u%04x", c);
+        else fputc(c, fp);
+    }
+    fputc('"', fp);
+}
+
+
+// operations sorted by time and then matrix names sorted by bytes allocated
+void MatrixBase::printProfile(bool json, FILE *fp)
+{
+    ProfileData *p = profileData();
+    std::lock_guard<std::mutex> g(p->lock);
+    double elapsed = profileNow() - p->start;
+    std::vector<std::pair<const std::pair<std::string, std::string>, ProfileOp> *> ops;
+    std::vector<std::pair<const std::string, ProfileName> *> names;
+
+    for (auto &i : p->ops) ops.push_back(&i);
+    std::stable_sort(ops.begin(), ops.end(), [](const std::pair<const std::pair<std::string, std::string>, ProfileOp> *a,
+                                                const std::pair<const std::pair<std::string, std::string>, ProfileOp> *b) {
+        return a->second.seconds > b->second.seconds;
+    });
+    for (auto &i : p->names) names.push_back(&i);
+    std::stable_sort(names.begin(), names.end(), [](const std::pair<const std::string, ProfileName> *a,
+                                                    const std::pair<const std::string, ProfileName> *b) {
+        return a->second.bytes > b->second.bytes;
+    });
+
+    if (json) {
+        fprintf(fp, "{\"elapsed\": %.6f,\n \"operations\": [", elapsed);
+        for (size_t i=0; i<ops.size(); i++) {
+            fprintf(fp, "%s\n  {\"op\": \"%s\", \"name\": ", i ? "," : "", ops[i]->first.first.c_str());
+            profileJsonString(fp, ops[i]->first.second);
+            fprintf(fp, ", \"calls\": %llu, \"seconds\": %.6f}", ops[i]->second.calls, ops[i]->second.seconds);
+        }
+        fprintf(fp, "],\n \"matrices\": [");
+        for (size_t i=0; i<names.size(); i++) {
+            const ProfileName &n = names[i]->second;
+
+            fprintf(fp, "%s\n  {\"name\": ", i ? "," : "");
+            profileJsonString(fp, names[i]->first);
+            fprintf(fp, ", \"allocations\": %llu, \"copies\": %llu, \"bytes\": %.0f, \"liveBytes\": %.0f, \"peakBytes\": %.0f}",
+                    n.allocations, n.copies, n.bytes, n.liveBytes, n.peakBytes);
+        }
+        fprintf(fp, "]}\n");
+    }
+    else {
+        fprintf(fp, "PROFILE (elapsed: %.3f sec)\n", elapsed);
+        fprintf(fp, "%12s %6s %10s  %-16s %s\n", "seconds", "%", "calls", "operation", "matrix");
+        for (size_t i=0; i<ops.size(); i++) {
+            fprintf(fp, "%12.6f %6.1f %10llu  %-16s \"%s\"\n", ops[i]->second.seconds,
+                    elapsed>0 ? 100.0*ops[i]->second.seconds/elapsed : 0.0,
+                    ops[i]->second.calls, ops[i]->first.first.c_str(), ops[i]->first.second.c_str());
+        }
+        fprintf(fp, "%12s %10s %14s %14s %14s  %s\n", "allocations", "copies", "bytes", "live", "peak", "matrix");
+        for (size_t i=0; i<names.size(); i++) {
+            const ProfileName &n = names[i]->second;
+
+            fprintf(fp, "%12llu %10llu %14.0f %14.0f %14.0f  \"%s\"\n", n.allocations, n.copies,
+                    n.bytes, n.liveBytes, n.peakBytes, names[i]->first.c_str());
+        }
+    }
+    fflush(fp);
+}
+
+
+template <class T>
+MatrixT<T>::MatrixT(std::string namex)
+{
+    allocate(-1, -1, namex);   // allocate no size
+    m = NULL;
+}
+
+
+
+// This creates a subMatrix!
+template <class T>
+MatrixT<T>::MatrixT(int r, std::string namex)
+{
+    allocate(r, -1, namex, true);       // WARNING: allocate as subMatrix!!!
+}
+
+
+template <class T>
+MatrixT<T>::MatrixT(int r, int c, std::string namex)
+{
+    allocate(r, c, namex);
+}
+
+
+template <class T>
+MatrixT<T>::MatrixT(int r, int c, double value, std::string namex)
+{
+    allocate(r, c, namex);
+    constant(value);
+}
+
+
+
+template <class T>
+MatrixT<T>::MatrixT(int r, int c, double *data, std::string namex)
+{
+    allocate(r, c, namex);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = *data++;
+        }
+    }
+
+    defined = true;
+}
+
+
+// copy constructor
+template <class T>
+MatrixT<T>::MatrixT(const MatrixT &other, std::string namex)
+{
+    allocate(other.maxr, other.maxc, namex);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = other.m[r][c];
+        }
+    }
+
+    defined = true;
+    copies++;
+    if (profile) profileCopy(other.name);
+}
+
+
+// pointer version
+template <class T>
+MatrixT<T>::MatrixT(MatrixT *other)
+{
+    allocate(other->maxr, other->maxc, "");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = other->m[r][c];
+        }
+    }
+
+    defined = true;
+    copies++;
+    if (profile) profileCopy(other->name);
+}
+
+
+// move constructor.  The new matrix takes the storage of other (including
+// being a subMatrix if other is one) and other is left empty.
+template <class T>
+MatrixT<T>::MatrixT(MatrixT &&other)
+{
+    allocate(-1, -1, other.name);   // allocate no size
+    stealStorage(other);
+    moves++;
+}
+
+
+// convert from a matrix with another element type, e.g. MatrixF f(d).
+// Going from double to float rounds each element to the nearest float.
+template <class T>
+template <class U>
+MatrixT<T>::MatrixT(const MatrixT<U> &other, std::string namex)
+{
+    allocate(other.maxr, other.maxc, namex);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = (T)other.m[r][c];
+        }
+    }
+
+    defined = other.defined;
+    copies++;
+    if (profile) profileCopy(other.name);
+}
+
+
+
+template <class T>
+MatrixT<T>::~MatrixT()
+{
+    deallocate();
+}
+
+
+
+// WARNING: as written allows direct access to matrix name (not copy)
+template <class T>
+const std::string &MatrixT<T>::getName(const std::string &defaultName) const
+{
+    if (name.length()==0) return defaultName;
+    else return name;
+}
+
+
+// get the value of an element of the matrix
+template <class T>
+double MatrixT<T>::get(int r, int c) const
+{
+//    printf("GET:  %llu @  %d %d %lf\n", (unsigned long long int)this, r, c, m[r][c]);
+
+    return m[r][c];
+}
+
+
+// increment a given element returning new value
+template <class T>
+double MatrixT<T>::inc(int r, int c)
+{
+    if (r<0 || r>=maxr || c<0 || c>=maxc) {
+        printf("ERROR(get): index out of bounds: asking for (%d, %d) but size is %d X %d\n",
+               r, c, maxr, maxc);
+        exit(1);
+    }
+
+    return ++m[r][c];
+}
+
+
+// decrement a given element returning new value
+template <class T>
+double MatrixT<T>::dec(int r, int c)
+{
+    if (r<0 || r>=maxr || c<0 || c>=maxc) {
+        printf("ERROR(get): index out of bounds: asking for (%d, %d) but size is %d X %d\n",
+               r, c, maxr, maxc);
+        exit(1);
+    }
+
+    return --m[r][c];
+}
+
+
+// set the value of an element of the matrix
+template <class T>
+double MatrixT<T>::set(int r, int c, double v)
+{
+    if (r<0 || r>=maxr || c<0 || c>=maxc) {
+        printf("ERROR(set): index out of bounds: asking for (%d, %d) but size is %d X %d\n",
+               r, c, maxr, maxc);
+        exit(1);
+    }
+//    printf("SET: %llu @ %d %d %lf\n", (unsigned long long int)this, r, c, v);
+    m[r][c] = v;
+
+    return m[r][c];
+}
+
+
+// true if the rows are in order in a single block with a fixed stride.
+// This can stop being true if rows are swapped (e.g. sorting) or if
+// this is a subMatrix that picks out rows.
+template <class T>
+bool MatrixT<T>::isContiguous() const
+{
+    if (data==NULL) return false;
+
+    for (int r=0; r<maxr; r++) {
+        if (m[r] != data + (size_t)r*stride) return false;
+    }
+
+    return true;
+}
+
+
+// set the value of an element of the matrix  (use this carefully)
+template <class T>
+void MatrixT<T>::setDefined()
+{
+    defined = true;
+}
+
+
+// set the name of a matrix
+template <class T>
+void MatrixT<T>::setName(std::string newName)
+{
+    name = newName;
+}
+
+
+// do bounds checking
+template <class T>
+void MatrixT<T>::checkBounds(int r, int c, const char *msg) const
+{
+    assertIndexOK(r, c, msg);  // zzz fix this so it reads nicer
+    if (r>=maxr  || r<0) {
+        printf("ERROR(%s): asking for row %d but size is %d X %d\n", msg, r, maxr, maxc);
+        exit(1);
+     }
+    if (c>=maxc  || c<0) {
+        printf("ERROR(%s): asking for col %d but size is %d X %d\n", msg, c, maxr, maxc);
+        exit(1);
+    }
+}
+
+
+
+// remove trailing columns without actually giving up the space.
+template <class T>
+void MatrixT<T>::narrow(int newc)
+{
+    checkBounds(0, newc-1, "narrow");  // allow newc to equal maxc
+
+    maxc = newc;
+}
+
+
+// remove trailing rows without actually giving up the space.
+// The argument give is the new number of rows in the matrix.
+// DANGER: this trims rows.   Not a memory leak but old row length
+// not "visibibly" saved.
+template <class T>
+void MatrixT<T>::shorten(int newr)
+{
+    checkBounds(newr-1, 0, "shorten");   // allow newr to equal maxr
+
+    maxr = newr;
+}
+
+
+template <class T>
+void MatrixT<T>::assertDefined(std::string msg) const
+{
+    if (!defined) {
+        if (name.length()==0)
+            printf("ERROR(%s): matrix is undefined\n", msg.c_str());
+        else
+            printf("ERROR(%s): matrix \"%s\" is undefined\n", msg.c_str(), name.c_str());
+        exit(1);
+    }
+}
+
+
+// assert matrix doesn't have negative dimensions
+template <class T>
+void MatrixT<T>::assertUsableSize(std::string msg) const
+{
+    if (maxr < 0 || maxc < 0) {
+        if (name.length()==0)
+            printf("ERROR(%s): Matrix is of unusable size %d X %d\n", msg.c_str(), maxr, maxc);
+        else
+            printf("ERROR(%s): Matrix \"%s\" is of unusable size %d X %d\n",
+                   msg.c_str(), name.c_str(), maxr, maxc);
+        exit(1);
+    }
+}
+
+
+
+template <class T>
+void MatrixT<T>::assertSquare(std::string msg) const
+{
+    assertDefined(msg);
+
+    if (maxr != maxc) {
+        if (name.length()==0)
+            printf("ERROR(%s): the matrix is %dX%d and not square as expected!\n",
+               msg.c_str(), maxr, maxc);
+        else
+            printf("ERROR(%s): the matrix \"%s\" is %dX%d and not square as expected!\n",
+               msg.c_str(), name.c_str(), maxr, maxc);
+        exit(1);
+    }
+}
+
+
+
+// assert size is rxc
+template <class T>
+void MatrixT<T>::assertSize(int r, int c, std::string msg) const
+{
+    assertDefined(msg);
+    if (maxr != r || maxc != c) {
+        if (name.length()==0)
+            printf("ERROR(%s): the matrix is %dX%d and not %dX%d as expected!\n",
+               msg.c_str(), maxr, maxc, r, c);
+        else
+            printf("ERROR(%s): matrix \"%s\" is %dX%d and not %dX%d as expected!\n",
+               msg.c_str(), name.c_str(), maxr, maxc, r, c);
+        exit(1);
+    }
+}
+
+
+// the two sides of an operator in a matrix expression are different sizes
+void MatrixBase::exprSizeError(const char *op, int lr, int lc, int rr, int rc)
+{
+    printf("ERROR(matrix expression): the sides of %s are different sizes: %d X %d and %d X %d\n",
+           op, lr, lc, rr, rc);
+    exit(1);
+}
+
+
+// assert the row is in bounds for matrix
+template <class T>
+void MatrixT<T>::assertRowIndexOK(int r, std::string msg) const
+{
+    if (r<0 || r>=maxr) {
+        if (name.length()==0) {
+            printf("ERROR(%s): row index %d out of bounds.  Matrix size is %d X %d\n",
+                   msg.c_str(), r, maxr, maxc);
+        }
+        else {
+            printf("ERROR(%s): row index %d out of bounds.  Matrix \"%s\" is %d X %d\n",
+                   msg.c_str(), r, name.c_str(), maxr, maxc);
+        }
+        exit(1);
+    }
+}
+
+// assert the column is in bounds for matrix
+template <class T>
+void MatrixT<T>::assertColIndexOK(int c, std::string msg) const
+{
+    if (c<0 || c>=maxc) {
+        if (name.length()==0) {
+            printf("ERROR(%s): column index %d out of bounds.  Matrix size is %d X %d\n",
+                   msg.c_str(), c, maxr, maxc);
+        }
+        else {
+            printf("ERROR(%s): column index %d out of bounds.  Matrix \"%s\" is %d X %d\n",
+                   msg.c_str(), c, name.c_str(), maxr, maxc);
+        }
+        exit(1);
+    }
+}
+
+
+// assert r,c is in matrix
+template <class T>
+void MatrixT<T>::assertIndexOK(int r, int c, std::string msg) const
+{
+    if (r<0 || r>=maxr || c<0 || c>=maxc) {
+        if (name.length()==0) {
+            printf("ERROR(%s): index out of bounds: asking for (%d, %d) but size is %d X %d\n",
+                   msg.c_str(), r, c, maxr, maxc);
+        }
+        else {
+            printf("ERROR(%s): index out of bounds: asking for (%d, %d) but size of matrix \"%s\" is %d X %d\n",
+                   msg.c_str(), r, c, name.c_str(), maxr, maxc);
+        }
+        exit(1);
+    }
+}
+
+
+
+// assert other is the same size
+// assert other can be lhs of mult op
+template <class T>
+void MatrixT<T>::assertOtherLhs(const MatrixT &other, std::string msg) const
+{
+    if (maxc!=other.maxr) {
+        printf("ERROR(%s): Dimensions do not match: self \"%s\": %d X %d other \"%s\": %d X %d\n", msg.c_str(), name.c_str(), maxr, maxc, other.name.c_str(), other.maxr, other.maxc);
+        exit(1);
+    }
+}
+
+
+// assert other can be lhs of mult op
+template <class T>
+void MatrixT<T>::assertRowsEqual(const MatrixT &other, std::string msg) const
+{
+    if (maxr!=other.maxr) {
+        printf("ERROR(%s): Row dimensions do not match: self \"%s\": %d X %d other \"%s\": %d X %d\n", msg.c_str(), name.c_str(), maxr, maxc, other.name.c_str(), other.maxr, other.maxc);
+        exit(1);
+    }
+}
+
+
+// assert other can be lhs of mult op
+template <class T>
+void MatrixT<T>::assertColsEqual(const MatrixT &other, std::string msg) const
+{
+    if (maxc!=other.maxc) {
+        printf("ERROR(%s): Column dimensions do not match: self \"%s\": %d X %d other \"%s\": %d X %d\n", msg.c_str(), name.c_str(), maxr, maxc, other.name.c_str(), other.maxr, other.maxc);
+        exit(1);
+    }
+}
+
+
+// assert two matrices have the same size
+template <class T>
+void MatrixT<T>::assertOtherSizeMatch(const MatrixT &other, std::string msg) const
+{
+    assertRowsEqual(other, msg);
+    assertColsEqual(other, msg);
+}
+
+
+// assert is a row vector
+template <class T>
+void MatrixT<T>::assertRowVector(std::string msg) const
+{
+    if (maxr!=1) {
+        if (name.length()==0) {
+            printf("ERROR(%s): expecting matrix is row vector but size is %d X %d\n",
+                   msg.c_str(), maxr, maxc);
+        }
+        else {
+            printf("ERROR(%s): expecting matrix %s is row vector but size is %d X %d\n",
+                   msg.c_str(), name.c_str(), maxr, maxc);
+        }
+        exit(1);
+    }
+}
+
+
+// assert is a column vector
+template <class T>
+void MatrixT<T>::assertColVector(std::string msg) const
+{
+    if (maxc!=1) {
+        if (name.length()==0) {
+            printf("ERROR(%s): expecting matrix is column vector but size is %d X %d\n",
+                   msg.c_str(), maxr, maxc);
+        }
+        else {
+            printf("ERROR(%s): expecting matrix %s is column vector but size is %d X %d\n",
+                   msg.c_str(), name.c_str(), maxr, maxc);
+        }
+        exit(1);
+    }
+}
+
+
+// helper function that swaps two rows and does not check matrix for validity
+template <class T>
+void MatrixT<T>::swapRows(int i, int j)
+{
+    T *tmp;
+    
+    tmp = m[i]; m[i] = m[j]; m[j] = tmp;
+}
+
+
+// helper function that compares two rows and does not assertions
+template <class T>
+bool MatrixT<T>::lessRows(int i, int j) const
+{
+//    assertDefined("lessRows");
+
+    for (int c=0; c<maxc; c++) {
+        if (m[i][c] > m[j][c]) return false;
+        if (m[i][c] < m[j][c]) return true;
+    }
+
+    return false;
+}
+
+
+
+
+// assign a matrix.   Size does NOT have to match
+template <class T>
+MatrixT<T> &MatrixT<T>::operator=(const MatrixT &other)
+{
+    other.assertDefined("operator=");
+
+    if (this==&other) return *this;       // avoid self copy
+
+    // allocate if a new size
+    reallocate(other.maxr, other.maxc, name);
+
+    // copy
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = other.m[r][c];
+        }
+    }
+    defined = true;
+    copies++;
+    if (profile) profileCopy(other.name);
+
+    return *this;
+}
+
+
+// move assignment.  Self gives up its storage and takes that of other.
+// The name of self is kept just as in the copy assignment.
+// If either is a subMatrix the elements are still copied: a subMatrix on
+// the right points into someone else's storage and self should not
+// silently become a view, and a subMatrix on the left must write through
+// to the matrix it points into.
+template <class T>
+MatrixT<T> &MatrixT<T>::operator=(MatrixT &&other)
+{
+    other.assertDefined("operator=");
+
+    if (this==&other) return *this;       // avoid self move
+    if (submatrix || other.submatrix) return *this = (const MatrixT &)other;
+
+    deallocate();
+    stealStorage(other);
+    moves++;
+
+    return *this;
+}
+
+
+// extracts a matrix from another starting at (minr, minc) and of
+// the size given.
+// NOTE: zero size means "to the end of row or column"!
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::extract(int minr, int minc, int sizer, int sizec)
+{
+    if (sizer==0) sizer = maxr - minr;
+    if (sizec==0) sizec = maxc - minc;
+
+    checkBounds(minr, minc, "lower bounds extract");
+    checkBounds(minr+sizer-1, minc+sizec-1, "upper bounds extract");
+
+    MatrixT out(sizer, sizec);
+
+    for (int r=minr; r<minr+sizer; r++) {
+        for (int c=minc; c<minc+sizec; c++) {
+            out.m[r-minr][c-minc] = m[r][c];
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+// extracts a matrix from another starting at (minr, minc) and of
+// the stride length given for rows and cols.
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::extractStride(int minr, int minc, int stepr, int stepc)
+{
+    int newr, newc;
+    checkBounds(minr, minc, "lower bounds extract");
+
+    newr = (maxr-minr + (stepr - 1))/stepr + 1;
+    newc = (maxc-minc + (stepc - 1))/stepc + 1;
+    MatrixT out(newr, newc);
+
+    for (int r=minr; r<maxr; r+=stepr) {
+        for (int c=minc; c<maxc; c+=stepc) {
+            out.m[(r-minr)/stepr][(c-minc)/stepc] = m[r][c];
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+// does the same extraction as above but requires that the out Matrix
+// be correctly allocated beforehand!  <--- WARNING!
+template <class T>
+MatrixT<T> &MatrixT<T>::extract(int minr, int minc, int sizer, int sizec, MatrixT &out)
+{
+    if (sizer==0) sizer = maxr - minr;
+    if (sizec==0) sizec = maxc - minc;
+
+    for (int r=minr; r<minr+sizer; r++) {
+        for (int c=minc; c<minc+sizec; c++) {
+            out.m[r-minr][c-minc] = m[r][c];
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+// insert Matrix other at location (minr, minc) in self
+// NOTE: anything outside of allocated space will issue a warning but
+// not be copied!
+template <class T>
+MatrixT<T> &MatrixT<T>::insert(const MatrixT &other, int minr, int minc)
+{
+    assertIndexOK(minr, minc, "insert");
+    
+    for (int r=0; r<other.maxr; r++) {
+        if (r>=maxr) break;
+        for (int c=0; c<other.maxc; c++) {
+            if (c>=maxc) break;
+            m[r+minr][c+minc] = other.m[r][c];
+        }
+    }
+
+    return *this;
+}
+
+
+// insert at the specified row the other matrix which is a row vector matrix
+template <class T>
+MatrixT<T> &MatrixT<T>::insertRowVector(int loc, const MatrixT &other)
+{
+    other.assertRowVector("insertRowVector");
+    assertColsEqual(other, "insertRowVector");
+    checkBounds(loc, 0, "insertRowVector");
+
+    for (int c=0; c<other.maxc; c++) {
+        m[loc][c] = other.m[0][c];
+    }
+
+    return *this;
+}
+
+
+// returns answer in arguments
+template <class T>
+void MatrixT<T>::argMax(int &rr, int &cc) const
+{
+    double max;
+
+    assertDefined("argMax");
+
+    max = m[0][0];
+    rr = cc = 0;
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] > max) {
+                max = m[r][c];
+                rr = r;
+                cc = c;
+            }
+        }
+    }
+}
+
+
+// returns answer in arguments
+template <class T>
+void MatrixT<T>::argMin(int &rr, int &cc) const
+{
+    double min;
+
+    assertDefined("argMin");
+
+    min = m[0][0];
+    rr = cc = 0;
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] < min) {
+                min = m[r][c];
+                rr = r;
+                cc = c;
+            }
+        }
+    }
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::argMinRow() const
+{
+    int cc;
+    double min;
+    assertDefined("argMinRow");
+
+    MatrixT out(maxr, 1);
+
+    min = m[0][0];
+    for (int r=0; r<maxr; r++) {
+        min = m[r][0];
+        cc = 0;
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] < min) {
+                min = m[r][c];
+                cc = c;
+            }
+        }
+        out.m[r][0] = cc;
+    }
+
+    out.defined = true;
+
+    return out;
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::minRow() const
+{
+    double min;
+    assertDefined("minRow");
+
+    MatrixT out(maxr, 1);
+
+    min = m[0][0];
+    for (int r=0; r<maxr; r++) {
+        min = m[r][0];
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] < min) {
+                min = m[r][c];
+            }
+        }
+        out.m[r][0] = min;
+    }
+
+    out.defined = true;
+
+    return out;
+}
+
+
+template <class T>
+double MatrixT<T>::max() const
+{
+    double max;
+
+    assertDefined("max");
+
+    max = m[0][0];
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] > max) max = m[r][c];
+        }
+    }
+
+    return max;
+}
+
+
+template <class T>
+double MatrixT<T>::min() const
+{
+    double min;
+
+    assertDefined("min");
+
+    min = m[0][0];
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] < min) min = m[r][c];
+        }
+    }
+
+    return min;
+}
+
+
+
+template <class T>
+double MatrixT<T>::mean() const
+{
+    double sum;
+
+    assertDefined("mean");
+
+    sum = 0;
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            sum += m[r][c];
+        }
+    }
+
+    return sum/maxr/maxc;
+}
+
+
+
+template <class T>
+double MatrixT<T>::minCol(int c) const
+{
+    double min;
+
+    assertDefined("min");
+    assertColIndexOK(c, "minCol");
+
+    min = m[0][c];
+    for (int r=1; r<maxr; r++) {
+        if (m[r][c] < min) min = m[r][c];
+    }
+
+    return min;
+}
+
+
+template <class T>
+double MatrixT<T>::maxCol(int c) const
+{
+    double max;
+
+    assertDefined("max");
+    assertColIndexOK(c, "maxCol");
+
+    max = m[0][c];
+    for (int r=1; r<maxr; r++) {
+        if (m[r][c] > max) max = m[r][c];
+    }
+
+    return max;
+}
+
+
+template <class T>
+double MatrixT<T>::meanCol(int c) const
+{
+    double sum;
+
+    assertDefined("sum");
+    assertColIndexOK(c, "meanCol");
+
+    sum = 0.0;
+    for (int r=0; r<maxr; r++) sum += m[r][c];
+
+    return sum/maxr;
+}
+
+
+// should do in a more numerically stable way
+template <class T>
+double MatrixT<T>::stddevCol(int c) const
+{
+    double sum, sum2;
+
+    assertDefined("sum");
+    assertColIndexOK(c, "stddevCol");
+
+    sum = sum2 = 0.0;
+    for (int r=0; r<maxr; r++) {
+        sum += m[r][c];
+        sum2 += m[r][c]*m[r][c];
+    }
+
+    return sqrt(sum2/maxr - (sum*sum)/(maxr*maxr));  // not the most stable way to compute!!
+}
+
+
+// count number of items in column c equal to value
+template <class T>
+int MatrixT<T>::countEqCol(int c, double value) const
+{
+    int count;
+
+    count = 0;
+    for (int r=0; r<maxr; r++) {
+        if (m[r][c]==value) count++;
+    }
+
+    return count;
+}
+
+
+// count number of items in column c not equal to value
+template <class T>
+int MatrixT<T>::countNeqCol(int c, double value) const
+{
+    int count;
+
+    count = 0;
+    for (int r=0; r<maxr; r++) {
+        if (m[r][c]!=value) count++;
+    }
+
+    return count;
+}
+
+
+
+
+
+// returns new matrix for a matrix of min and max of each column
+// normalizes within each column according to the min and max in that column
+// so the range is now between 0 and 1 in each column
+// NOTE: it will not rescale a column that is a constant!!
+// WARNING: allocates new matrix for answer and alters matrix self
+template <class T>
+MatrixT<T> MatrixT<T>::normalizeCols()
+{
+    ProfileScope prof("normalizeCols", name);
+
+    assertDefined("normalize");
+
+    MatrixT stats = columnStats();    // one pass along the rows for the min and max
+    MatrixT minMax(2, maxc, "minMax for " + name);
+
+    for (int c=0; c<maxc; c++) {
+        minMax.m[0][c] = stats.m[STAT_MIN][c];
+        minMax.m[1][c] = stats.m[STAT_MAX][c];
+    }
+    minMax.defined = true;
+
+    normalizeCols(minMax);
+
+    return minMax;
+}
+
+
+// normalizes within each column according to the min and max in that
+// column supplied in the minMax matrix.  NOTE: This is used to scale
+// two matrices the same way in the same columns.   This is useful
+// for scaling training data and testing data.
+template <class T>
+MatrixT<T> &MatrixT<T>::normalizeCols(MatrixT &minMax)
+{
+    ProfileScope prof("normalizeCols", name);
+
+    const T *min = minMax.m[0], *max = minMax.m[1];
+
+    // along the rows so memory is read in order
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            T *x = m[r];
+
+            for (int c=0; c<maxc; c++) {
+                // rescale unless the column is a constant
+                if (min[c] != max[c]) x[c] = (x[c] - (double)min[c])/((double)max[c] - min[c]);
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+template <class T>
+bool MatrixT<T>::equal(const MatrixT &other) const
+{
+    assertDefined("lhs of equal");
+    other.assertDefined("rhs of equal");
+    assertOtherSizeMatch(other, "equal");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] != other.m[r][c]) return false;
+        }
+    }
+
+    return true;
+}
+
+
+
+
+// Return true if the differnce function is less than epsilon.
+// WARNING: nearness is relative and ranges between 0 and 2 as x
+// ranges between y and -y.   See the differnce function in the code.
+#define max(a, b) ((a)>(b) ? (a) : (b))
+template <class T>
+bool MatrixT<T>::nearEqual(double epsilon, const MatrixT &other) const
+{
+    assertDefined("lhs of nearEqual");
+    other.assertDefined("rhs of nearEqual");
+    assertOtherSizeMatch(other, "nearEqual");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if ((m[r][c] != other.m[r][c]) &&
+                (max(fabs(m[r][c]), fabs(other.m[r][c]))==0 ||
+                  (fabs(m[r][c] - other.m[r][c])/
+                   max(fabs(m[r][c]), fabs(other.m[r][c]))
+                   > epsilon
+                  )
+                )
+               ) return false;
+        }
+    }
+
+    return true;
+}
+
+
+template <class T>
+int MatrixT<T>::countGreater(const MatrixT &other) const
+{
+    int count;
+
+    assertDefined("lhs of equal");
+    other.assertDefined("rhs of equal");
+    assertOtherSizeMatch(other, "equal");
+
+    count = 0;
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] > other.m[r][c]) count++;
+        }
+    }
+
+    return count;
+}
+
+
+// square of distance between two matrices
+// this is an element by element operation and not like matrix multiply
+template <class T>
+double MatrixT<T>::dist2(const MatrixT &other) const
+{
+    double sum;
+
+    assertDefined("lhs of dist2");
+    other.assertDefined("rhs of dist2");
+    assertOtherSizeMatch(other, "dist2");
+
+    sum = 0;
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            double tmp;
+
+            tmp = m[r][c] - other.m[r][c];
+            sum += tmp * tmp;
+        }
+    }
+
+    return sum;
+}
+
+
+// dist squared of row of this with col of other -> double
+template <class T>
+double MatrixT<T>::dist2(int r, int c, const MatrixT &other) const
+{
+    double sum;
+
+    assertDefined("lhs of dist2");
+    other.assertDefined("rhs of dist2");
+    assertOtherLhs(other, "dist2");
+
+    sum = 0;
+    for (int i=0; i<maxc; i++) {
+        double tmp;
+
+        tmp = m[r][i] - other.m[i][c];
+        sum += tmp * tmp;
+    }
+
+    return sum;
+}
+
+
+
+// matrix multiply
+// dot of row of this with col of other -> double
+template <class T>
+double MatrixT<T>::dot(int r, int c, const MatrixT &other) const
+{
+    double sum;
+
+    assertDefined("lhs of rowdot");
+    other.assertDefined("rhs of rowdot");
+    assertOtherLhs(other, "dot of row by col");
+
+    sum = 0;
+    for (int i=0; i<maxc; i++) {
+        sum += m[r][i] * other.m[i][c];
+    }
+
+    return sum;
+}
+
+
+
+// +=
+template <class T>
+MatrixT<T> &MatrixT<T>::add(const MatrixT &other)
+{
+    ProfileScope prof("add", name);
+
+    assertDefined("lhs of add");
+    other.assertDefined("rhs of add");
+    assertOtherSizeMatch(other, "add");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] += other.m[r][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// -=
+template <class T>
+MatrixT<T> &MatrixT<T>::sub(const MatrixT &other)
+{
+    ProfileScope prof("sub", name);
+
+    assertDefined("lhs of sub");
+    other.assertDefined("rhs of sub");
+    assertOtherSizeMatch(other, "sub");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] -= other.m[r][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// IMPORTANT: this is x - self   not   self - x
+// can be used to negate
+template <class T>
+MatrixT<T> &MatrixT<T>::scalarPreSub(double x)
+{
+    assertDefined("scalarPreSub");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = x - m[r][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// IMPORTANT: this  self - x
+template <class T>
+MatrixT<T> &MatrixT<T>::scalarPostSub(double x)
+{
+    assertDefined("scalarPostSub");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = m[r][c] - x;
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// multiply each column by a column vector
+// the given default value.
+template <class T>
+MatrixT<T> &MatrixT<T>::multColVector(const MatrixT &other)
+{
+    assertDefined("lhs of multColVector");
+    other.assertDefined("rhs of multColVector");
+    other.assertColVector("multColVector");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] *= other.m[r][0];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// divide each column by a column vector
+template <class T>
+MatrixT<T> &MatrixT<T>::divColVector(const MatrixT &other)
+{
+    assertDefined("lhs of divColVector");
+    other.assertDefined("rhs of divColVector");
+    other.assertColVector("divColVector");
+
+    for (int r=0; r<maxr; r++) {
+        if (other.m[r][0]==0.0) {
+            if (name.length()==0) {
+                printf("ERROR(divColVector): Trying to divide by element [%d, %d] of a matrix which is zero\n", r, 0);
+            }
+            else {
+                printf("ERROR(divColVector): Trying to divide by element [%d, %d] of matrix named \"%s\" which is zero\n", r, 0, name.c_str());
+            }
+            exit(1);
+        }
+
+        for (int c=0; c<maxc; c++) {
+            m[r][c] /= other.m[r][0];
+        }
+    }
+
+    return *this;
+}
+
+
+
+// divide one matrix by another.  If denominator = 0 for an element use
+// the given default value.
+template <class T>
+MatrixT<T> &MatrixT<T>::divRowVector(const MatrixT &other)
+{
+    assertDefined("lhs of divRowVector");
+    other.assertDefined("rhs of divRowVector");
+    other.assertRowVector("divRowVector");
+
+    for (int c=0; c<maxc; c++) {
+        if (other.m[0][c]==0.0) {
+            if (name.length()==0) {
+                printf("ERROR(divRowVector): Trying to divide by element [%d, %d] of a matrix which is zero\n", 0, c);
+            }
+            else {
+                printf("ERROR(divRowVector): Trying to divide by element [%d, %d] of matrix named \"%s\" which is zero\n", 0, c, name.c_str());
+            }
+            exit(1);
+        }
+        
+        for (int r=0; r<maxr; r++) {
+            m[r][c] /= other.m[0][c];
+        }
+    }
+
+    return *this;
+}
+
+
+
+// multiply each row in self by row vector matrix in other
+template <class T>
+MatrixT<T> &MatrixT<T>::multRowVector(const MatrixT &other)
+{
+    assertDefined("multRowVector");
+    assertColsEqual(other, "multRowVector");
+    other.assertRowVector("multRowVector");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] *= other.m[0][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// add a row vector matrix in other to each row of self
+template <class T>
+MatrixT<T> &MatrixT<T>::addRowVector(const MatrixT &other)
+{
+    assertDefined("addRowVector");
+    assertColsEqual(other, "addRowVector");
+    other.assertRowVector("addRowVector");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] += other.m[0][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+// add a row vector matrix in other to the given row of self
+template <class T>
+MatrixT<T> &MatrixT<T>::addRowVector(int r, const MatrixT &other)
+{
+    assertDefined("addRowVector");
+    assertColsEqual(other, "addRowVector");
+    other.assertRowVector("addRowVector");
+
+    for (int c=0; c<maxc; c++) {
+        m[r][c] += other.m[0][c];
+    }
+
+    return *this;
+}
+
+
+
+// subtract row matrix to each row of self
+template <class T>
+MatrixT<T> &MatrixT<T>::subRowVector(const MatrixT &other)
+{
+    assertDefined("subRowVector");
+    assertColsEqual(other, "subRowVector");
+    other.assertRowVector("subRowVector");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] -= other.m[0][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// element by element absolute value in place
+template <class T>
+MatrixT<T> &MatrixT<T>::MatrixT::abs()
+{
+    assertDefined("abs");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = fabs(m[r][c]);
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+
+// element by element multiply
+template <class T>
+MatrixT<T> &MatrixT<T>::mult(const MatrixT &other)
+{
+    ProfileScope prof("mult", name);
+
+    assertDefined("lhs of mult");
+    other.assertDefined("rhs of mult");
+    assertOtherSizeMatch(other, "mult");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] *= other.m[r][c];
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// element by element divide
+template <class T>
+MatrixT<T> &MatrixT<T>::div(const MatrixT &other)
+{
+    assertDefined("lhs of div");
+    other.assertDefined("rhs of div");
+    assertOtherSizeMatch(other, "div");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (other.m[r][c]==0.0) {
+                if (name.length()==0) {
+                    printf("ERROR(div): Trying to divide by element [%d, %d] of a matrix which is zero\n", r, c);
+                }
+                else {
+                    printf("ERROR(div): Trying to divide by element [%d, %d] of matrix named \"%s\" which is zero\n", r, c, name.c_str());
+                }
+                exit(1);
+            }
+            m[r][c] /= other.m[r][c];
+        }
+    }
+
+    return *this;
+}
+
+
+// increment the values in a given row by 1
+template <class T>
+MatrixT<T> &MatrixT<T>::rowInc(int r)
+{
+    for (int c=0; c<maxc; c++) {
+        m[r][c]++;
+    }
+
+    return *this;
+}
+
+
+
+// swap two matrices
+// This exchanges the storage (not the names) of the two matrices so
+// either one may be undefined or they may be of different sizes.
+// If either is a subMatrix then the elements are swapped one by one
+// so that the matrices they point into see the change.
+template <class T>
+MatrixT<T> &MatrixT<T>::swap(MatrixT &other)
+{
+    if (!submatrix && !other.submatrix) {
+        MatrixT tmp;
+
+        tmp.stealStorage(*this);
+        stealStorage(other);
+        other.stealStorage(tmp);
+
+        return *this;
+    }
+
+    assertDefined("lhs of swap");
+    other.assertDefined("rhs of swap");
+    assertOtherSizeMatch(other, "swap");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            double tmp;
+
+            tmp = m[r][c];
+            m[r][c] = other.m[r][c];
+            other.m[r][c] = tmp;
+        }
+    }
+
+    return *this;
+}
+
+
+
+// pick from array those rows where list has an element equal to match.
+// can be used to do a complex selection from an array based on 1 and 0 in another array
+// or even a variety of values stored in column vector list
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::pickRows(int match, const MatrixT &list, int &num)
+{
+    assertDefined("lhs of pickRows");
+    list.assertDefined("rhs of pickRows");
+    list.assertColVector("rhs of pickRows");
+    assertRowsEqual(list, "pickRows");
+
+    num = 0;
+    for (int r=0; r<maxr; r++) if (list.m[r][0]==match) num++;
+
+    if (num==0) {
+        MatrixT out("Undefined");
+
+        return out;
+    }
+
+    MatrixT out(num, maxc);
+
+    { int rr=0;
+        for (int r=0; r<maxr; r++) {
+            if (list.m[r][0]==match) {
+                for (int c=0; c<maxc; c++) {
+                    out.m[rr][c] = m[r][c];
+                }       
+                rr++;
+                if (rr>=num) break;
+            }
+        }
+    }
+
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Matrix products (used by dot, dotT and Tdot)
+//
+// The products are done BLIS style.  The K dimension is cut into
+// blocks of gemmKC and for each block a panel of op(B) and a panel of
+// op(A) are packed into aligned buffers so the inner kernel reads both
+// linearly.  The inner (micro) kernel computes a gemmMR X gemmNR tile of
+// the answer holding it in registers.  Transposes are handled entirely
+// by the packing so the same kernel does dot, dotT and Tdot.
+//
+// Each element of the answer is still summed over k in order 0, 1, 2...
+// exactly as in the textbook triple loop and every kernel rounds the
+// product and the sum separately, so all of them give bit for bit the
+// same answer as the triple loop.  For MatrixF the sums are floats (in
+// the triple loop too) so the kernels can do twice as many at once.
+//
+// The kernel is chosen at run time from what the CPU supports (see
+// Matrix::simd).  Small products are not worth the packing and use the
+// triple loop directly (see gemmWorthIt).
+//
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAT_X86
+#include <immintrin.h>
+#endif
+
+int MatrixBase::simd = Matrix::SIMD_AUTO;
+
+static const int gemmKC = 256;     // depth of a packed panel
+static const int gemmMC = 72;      // rows of op(A) packed at once (multiple of every MR)
+static const int gemmNC = 2048;    // cols of op(B) packed at once (multiple of every NR)
+
+template <class T>
+struct GemmKernel {
+    int level;                     // one of Matrix::SIMD_*
+    const char *name;
+    int mr, nr;                    // size of the tile of the answer the kernel computes
+    void (*micro)(int kc, const T *a, const T *b, T **c, int c0, bool accumulate);
+};
+
+
+// portable kernel: a 4 X 4 tile
+template <class T>
+static void gemmMicroScalar(int kc, const T *a, const T *b, T **c, int c0, bool accumulate)
+{
+    T acc[4][4];
+
+    for (int i=0; i<4; i++) {
+        for (int j=0; j<4; j++) acc[i][j] = accumulate ? c[i][c0+j] : 0.0;
+    }
+
+    for (int k=0; k<kc; k++) {
+        for (int i=0; i<4; i++) {
+            for (int j=0; j<4; j++) acc[i][j] += a[i] * b[j];
+        }
+        a += 4;
+        b += 4;
+    }
+
+    for (int i=0; i<4; i++) {
+        for (int j=0; j<4; j++) c[i][c0+j] = acc[i][j];
+    }
+}
+
+
+#ifdef MAT_X86
+// SSE2 kernel: a 4 X 4 tile in 8 registers
+__attribute__((target("sse2")))
+static void gemmMicroSse2(int kc, const double *a, const double *b, double **c, int c0, bool accumulate)
+{
+    __m128d acc[4][2];
+
+    for (int i=0; i<4; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm_loadu_pd(c[i]+c0);
+            acc[i][1] = _mm_loadu_pd(c[i]+c0+2);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm_setzero_pd();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m128d b0, b1;
+
+        b0 = _mm_load_pd(b);
+        b1 = _mm_load_pd(b+2);
+        for (int i=0; i<4; i++) {
+            __m128d ai;
+
+            ai = _mm_set1_pd(a[i]);
+            acc[i][0] = _mm_add_pd(acc[i][0], _mm_mul_pd(ai, b0));
+            acc[i][1] = _mm_add_pd(acc[i][1], _mm_mul_pd(ai, b1));
+        }
+        a += 4;
+        b += 4;
+    }
+
+    for (int i=0; i<4; i++) {
+        _mm_storeu_pd(c[i]+c0, acc[i][0]);
+        _mm_storeu_pd(c[i]+c0+2, acc[i][1]);
+    }
+}
+
+
+// AVX2 kernel: a 6 X 8 tile in 12 registers.  Multiply and add are kept
+// separate (no fma) so the rounding is the same as the triple loop.
+__attribute__((target("avx2")))
+static void gemmMicroAvx2(int kc, const double *a, const double *b, double **c, int c0, bool accumulate)
+{
+    __m256d acc[6][2];
+
+    for (int i=0; i<6; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm256_loadu_pd(c[i]+c0);
+            acc[i][1] = _mm256_loadu_pd(c[i]+c0+4);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m256d b0, b1;
+
+        b0 = _mm256_load_pd(b);
+        b1 = _mm256_load_pd(b+4);
+        for (int i=0; i<6; i++) {
+            __m256d ai;
+
+            ai = _mm256_broadcast_sd(a+i);
+            acc[i][0] = _mm256_add_pd(acc[i][0], _mm256_mul_pd(ai, b0));
+            acc[i][1] = _mm256_add_pd(acc[i][1], _mm256_mul_pd(ai, b1));
+        }
+        a += 6;
+        b += 8;
+    }
+
+    for (int i=0; i<6; i++) {
+        _mm256_storeu_pd(c[i]+c0, acc[i][0]);
+        _mm256_storeu_pd(c[i]+c0+4, acc[i][1]);
+    }
+}
+
+
+// the same two kernels for floats hold twice as many columns
+__attribute__((target("sse2")))
+static void gemmMicroSse2Float(int kc, const float *a, const float *b, float **c, int c0, bool accumulate)
+{
+    __m128 acc[4][2];
+
+    for (int i=0; i<4; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm_loadu_ps(c[i]+c0);
+            acc[i][1] = _mm_loadu_ps(c[i]+c0+4);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm_setzero_ps();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m128 b0, b1;
+
+        b0 = _mm_load_ps(b);
+        b1 = _mm_load_ps(b+4);
+        for (int i=0; i<4; i++) {
+            __m128 ai;
+
+            ai = _mm_set1_ps(a[i]);
+            acc[i][0] = _mm_add_ps(acc[i][0], _mm_mul_ps(ai, b0));
+            acc[i][1] = _mm_add_ps(acc[i][1], _mm_mul_ps(ai, b1));
+        }
+        a += 4;
+        b += 8;
+    }
+
+    for (int i=0; i<4; i++) {
+        _mm_storeu_ps(c[i]+c0, acc[i][0]);
+        _mm_storeu_ps(c[i]+c0+4, acc[i][1]);
+    }
+}
+
+
+__attribute__((target("avx2")))
+static void gemmMicroAvx2Float(int kc, const float *a, const float *b, float **c, int c0, bool accumulate)
+{
+    __m256 acc[6][2];
+
+    for (int i=0; i<6; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm256_loadu_ps(c[i]+c0);
+            acc[i][1] = _mm256_loadu_ps(c[i]+c0+8);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m256 b0, b1;
+
+        b0 = _mm256_load_ps(b);
+        b1 = _mm256_load_ps(b+8);
+        for (int i=0; i<6; i++) {
+            __m256 ai;
+
+            ai = _mm256_broadcast_ss(a+i);
+            acc[i][0] = _mm256_add_ps(acc[i][0], _mm256_mul_ps(ai, b0));
+            acc[i][1] = _mm256_add_ps(acc[i][1], _mm256_mul_ps(ai, b1));
+        }
+        a += 6;
+        b += 16;
+    }
+
+    for (int i=0; i<6; i++) {
+        _mm256_storeu_ps(c[i]+c0, acc[i][0]);
+        _mm256_storeu_ps(c[i]+c0+8, acc[i][1]);
+    }
+}
+
+
+// AVX-512 kernels: an 8 X 16 tile of doubles (8 X 32 of floats) in 16
+// of the 32 registers.  As with AVX2 there is no fma: AVX-512 includes
+// fma instructions so the compiler must be told not to fuse a multiply
+// and an add itself.
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+__attribute__((target("avx512f")))
+static void gemmMicroAvx512(int kc, const double *a, const double *b, double **c, int c0, bool accumulate)
+{
+    __m512d acc[8][2];
+
+    for (int i=0; i<8; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm512_loadu_pd(c[i]+c0);
+            acc[i][1] = _mm512_loadu_pd(c[i]+c0+8);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m512d b0, b1;
+
+        b0 = _mm512_load_pd(b);
+        b1 = _mm512_load_pd(b+8);
+        for (int i=0; i<8; i++) {
+            __m512d ai;
+
+            ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_add_pd(acc[i][0], _mm512_mul_pd(ai, b0));
+            acc[i][1] = _mm512_add_pd(acc[i][1], _mm512_mul_pd(ai, b1));
+        }
+        a += 8;
+        b += 16;
+    }
+
+    for (int i=0; i<8; i++) {
+        _mm512_storeu_pd(c[i]+c0, acc[i][0]);
+        _mm512_storeu_pd(c[i]+c0+8, acc[i][1]);
+    }
+}
+
+
+__attribute__((target("avx512f")))
+static void gemmMicroAvx512Float(int kc, const float *a, const float *b, float **c, int c0, bool accumulate)
+{
+    __m512 acc[8][2];
+
+    for (int i=0; i<8; i++) {
+        if (accumulate) {
+            acc[i][0] = _mm512_loadu_ps(c[i]+c0);
+            acc[i][1] = _mm512_loadu_ps(c[i]+c0+16);
+        }
+        else {
+            acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+        }
+    }
+
+    for (int k=0; k<kc; k++) {
+        __m512 b0, b1;
+
+        b0 = _mm512_load_ps(b);
+        b1 = _mm512_load_ps(b+16);
+        for (int i=0; i<8; i++) {
+            __m512 ai;
+
+            ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_add_ps(acc[i][0], _mm512_mul_ps(ai, b0));
+            acc[i][1] = _mm512_add_ps(acc[i][1], _mm512_mul_ps(ai, b1));
+        }
+        a += 8;
+        b += 32;
+    }
+
+    for (int i=0; i<8; i++) {
+        _mm512_storeu_ps(c[i]+c0, acc[i][0]);
+        _mm512_storeu_ps(c[i]+c0+16, acc[i][1]);
+    }
+}
+#pragma GCC pop_options
+#endif
+
+
+static const GemmKernel<double> gemmKernelsDouble[] = {
+    { Matrix::SIMD_NONE, "scalar", 4, 4, gemmMicroScalar<double> },
+#ifdef MAT_X86
+    { Matrix::SIMD_SSE2, "sse2", 4, 4, gemmMicroSse2 },
+    { Matrix::SIMD_AVX2, "avx2", 6, 8, gemmMicroAvx2 },
+    { Matrix::SIMD_AVX512, "avx512", 8, 16, gemmMicroAvx512 },
+#endif
+};
+
+static const GemmKernel<float> gemmKernelsFloat[] = {
+    { Matrix::SIMD_NONE, "scalar", 4, 4, gemmMicroScalar<float> },
+#ifdef MAT_X86
+    { Matrix::SIMD_SSE2, "sse2", 4, 8, gemmMicroSse2Float },
+    { Matrix::SIMD_AVX2, "avx2", 6, 16, gemmMicroAvx2Float },
+    { Matrix::SIMD_AVX512, "avx512", 8, 32, gemmMicroAvx512Float },
+#endif
+};
+static const int gemmMaxMR = 8, gemmMaxNR = 32;    // no kernel has a bigger tile
+
+
+// the kernels for each element type
+static void gemmKernelTable(const GemmKernel<double> *&table, int &n)
+{
+    table = gemmKernelsDouble;
+    n = sizeof(gemmKernelsDouble)/sizeof(gemmKernelsDouble[0]);
+}
+
+static void gemmKernelTable(const GemmKernel<float> *&table, int &n)
+{
+    table = gemmKernelsFloat;
+    n = sizeof(gemmKernelsFloat)/sizeof(gemmKernelsFloat[0]);
+}
+
+
+// the best level this CPU can run
+static int simdSupported()
+{
+    static int level = -1;
+
+    if (level<0) {
+        level = Matrix::SIMD_NONE;
+#ifdef MAT_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse2")) level = Matrix::SIMD_SSE2;
+        if (__builtin_cpu_supports("avx2")) level = Matrix::SIMD_AVX2;
+        if (__builtin_cpu_supports("avx512f")) level = Matrix::SIMD_AVX512;
+#endif
+    }
+
+    return level;
+}
+
+
+// the SimdLevel to use: Matrix::simd if the CPU supports it else the best it can do
+static int simdLevel()
+{
+    int want;
+
+    want = simdSupported();
+    if (Matrix::simd>=0 && Matrix::simd<want) want = Matrix::simd;
+
+    return want;
+}
+
+
+// the kernel for the requested level or the best one below it that
+// this CPU (and this compile) supports
+template <class T>
+static const GemmKernel<T> &gemmKernel()
+{
+    const GemmKernel<T> *kernels;
+    int n, want;
+
+    gemmKernelTable(kernels, n);
+    want = simdLevel();
+
+    for (int i=n-1; i>0; i--) {
+        if (kernels[i].level<=want) return kernels[i];
+    }
+
+    return kernels[0];
+}
+
+
+const char *MatrixBase::simdName()
+{
+    return gemmKernel<double>().name;
+}
+
+
+// is a product of this size big enough to be worth packing?
+static bool gemmWorthIt(int M, int N, int K)
+{
+    return (double)M*N*K >= 32768.0 && M>=4 && N>=4;
+}
+
+
+// pack rows r0..r0+mr-1 and depth k0..k0+kc-1 of alpha op(A) so that for
+// each k the MR values of the rows are together.  Missing rows are zero.
+template <class T>
+static void gemmPackA(T **a, bool transA, T alpha, int r0, int mr, int k0, int kc, int MR, T *dst)
+{
+    if (transA) {                                  // op(A)(r, k) = a[k][r]
+        for (int k=0; k<kc; k++) {
+            const T *row = a[k0+k] + r0;
+
+            for (int i=0; i<mr; i++) dst[k*MR+i] = alpha*row[i];
+            for (int i=mr; i<MR; i++) dst[k*MR+i] = 0.0;
+        }
+    }
+    else {                                         // op(A)(r, k) = a[r][k]
+        for (int i=0; i<mr; i++) {
+            const T *row = a[r0+i] + k0;
+
+            for (int k=0; k<kc; k++) dst[k*MR+i] = alpha*row[k];
+        }
+        for (int i=mr; i<MR; i++) {
+            for (int k=0; k<kc; k++) dst[k*MR+i] = 0.0;
+        }
+    }
+}
+
+
+// pack cols c0..c0+nr-1 and depth k0..k0+kc-1 of op(B) so that for each k
+// the NR values of the cols are together.  Missing cols are zero.
+template <class T>
+static void gemmPackB(T **b, bool transB, int c0, int nr, int k0, int kc, int NR, T *dst)
+{
+    if (transB) {                                  // op(B)(k, c) = b[c][k]
+        for (int j=0; j<nr; j++) {
+            const T *row = b[c0+j] + k0;
+
+            for (int k=0; k<kc; k++) dst[k*NR+j] = row[k];
+        }
+        for (int j=nr; j<NR; j++) {
+            for (int k=0; k<kc; k++) dst[k*NR+j] = 0.0;
+        }
+    }
+    else {                                         // op(B)(k, c) = b[k][c]
+        for (int k=0; k<kc; k++) {
+            const T *row = b[k0+k] + c0;
+
+            for (int j=0; j<nr; j++) dst[k*NR+j] = row[j];
+            for (int j=nr; j<NR; j++) dst[k*NR+j] = 0.0;
+        }
+    }
+}
+
+
+// the packing space of a thread.  It is kept for the thread's next
+// product so a loop of products does not go to the heap.
+template <class T>
+struct GemmPacks {
+    T *a, *b;
+
+    GemmPacks()
+    {
+        a = alignedAlloc<T>((size_t)gemmMC*gemmKC);
+        b = alignedAlloc<T>((size_t)gemmNC*gemmKC);
+    }
+
+    ~GemmPacks()
+    {
+        alignedFree(a);
+        alignedFree(b);
+    }
+};
+
+
+// rows i0..i1-1 and cols j0..j1-1 of c = alpha op(a) op(b) + beta c (see gemm)
+template <class T>
+static void gemmBlock(const GemmKernel<T> &ker, int i0, int i1, int j0, int j1, int K,
+                      T alpha, T **a, bool transA, T **b, bool transB, T beta, T **c)
+{
+    static thread_local GemmPacks<T> packs;
+    const int MR = ker.mr, NR = ker.nr;
+    T *packA = packs.a, *packB = packs.b;
+
+    if (beta!=0 && beta!=1) {
+        for (int i=i0; i<i1; i++) {
+            for (int j=j0; j<j1; j++) c[i][j] *= beta;
+        }
+    }
+
+    for (int jc=j0; jc<j1; jc+=gemmNC) {
+        int nc = (j1-jc < gemmNC) ? j1-jc : gemmNC;
+
+        for (int pc=0; pc<K; pc+=gemmKC) {
+            int kc = (K-pc < gemmKC) ? K-pc : gemmKC;
+            bool accumulate = pc>0 || beta!=0;
+
+            for (int jr=0; jr<nc; jr+=NR) {
+                int nr = (nc-jr < NR) ? nc-jr : NR;
+                gemmPackB(b, transB, jc+jr, nr, pc, kc, NR, packB + (size_t)jr*kc);
+            }
+
+            for (int ic=i0; ic<i1; ic+=gemmMC) {
+                int mc = (i1-ic < gemmMC) ? i1-ic : gemmMC;
+
+                for (int ir=0; ir<mc; ir+=MR) {
+                    int mr = (mc-ir < MR) ? mc-ir : MR;
+                    gemmPackA(a, transA, alpha, ic+ir, mr, pc, kc, MR, packA + (size_t)ir*kc);
+                }
+
+                for (int jr=0; jr<nc; jr+=NR) {
+                    int nr = (nc-jr < NR) ? nc-jr : NR;
+
+                    for (int ir=0; ir<mc; ir+=MR) {
+                        int mr = (mc-ir < MR) ? mc-ir : MR;
+                        const T *pa = packA + (size_t)ir*kc;
+                        const T *pb = packB + (size_t)jr*kc;
+
+                        if (mr==MR && nr==NR) {
+                            ker.micro(kc, pa, pb, c+ic+ir, jc+jr, accumulate);
+                        }
+                        else {
+                            // partial tile: work in a scratch tile then copy the part that exists.
+                            // The kernel reads the whole tile when it accumulates so the rest is 0.
+                            T tile[gemmMaxMR*gemmMaxNR], *rows[gemmMaxMR];
+
+                            for (int i=0; i<MR; i++) rows[i] = tile + i*NR;
+                            if (accumulate) {
+                                for (int k=0; k<MR*NR; k++) tile[k] = 0;
+                                for (int i=0; i<mr; i++) {
+                                    for (int j=0; j<nr; j++) tile[i*NR+j] = c[ic+ir+i][jc+jr+j];
+                                }
+                            }
+                            ker.micro(kc, pa, pb, rows, 0, accumulate);
+                            for (int i=0; i<mr; i++) {
+                                for (int j=0; j<nr; j++) c[ic+ir+i][jc+jr+j] = tile[i*NR+j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+// c = alpha op(a) op(b) + beta c where op(a) is M X K and op(b) is K X N
+// and op() is an optional transpose.  c must already be allocated M X N.
+// If beta is 0 c is only written.  The answer is cut into bands of whole
+// tiles, one band per thread.
+template <class T>
+static void gemm(int M, int N, int K, T alpha, T **a, bool transA, T **b, bool transB, T beta, T **c)
+{
+    const GemmKernel<T> &ker = gemmKernel<T>();
+    double work;
+
+    if (K==0) {
+        for (int r=0; r<M; r++) for (int j=0; j<N; j++) c[r][j] = (beta==0) ? 0.0 : beta*c[r][j];
+        return;
+    }
+
+    work = 2.0*M*N*K;
+    if (M>=N) {
+        parallelFor((M+ker.mr-1)/ker.mr, work, [&](int lo, int hi) {
+            gemmBlock(ker, lo*ker.mr, (hi*ker.mr<M) ? hi*ker.mr : M, 0, N, K, alpha, a, transA, b, transB, beta, c);
+        }, 1);
+    }
+    else {
+        parallelFor((N+ker.nr-1)/ker.nr, work, [&](int lo, int hi) {
+            gemmBlock(ker, 0, M, lo*ker.nr, (hi*ker.nr<N) ? hi*ker.nr : N, K, alpha, a, transA, b, transB, beta, c);
+        }, 1);
+    }
+}
+
+
+// the triple loop for products too small to pack.  The sum starts from
+// beta c and adds (alpha a) b in the order the kernels do so both give
+// the same answer.
+template <class T, bool transA, bool transB>
+static void productLoop(int M, int N, int K, T alpha, T **a, T **b, T beta, T **c)
+{
+    for (int r=0; r<M; r++) {
+        for (int j=0; j<N; j++) {
+            T sum;
+
+            sum = (beta==0) ? 0 : beta*c[r][j];
+            if (alpha==1) {
+                for (int i=0; i<K; i++) {
+                    sum += (transA ? a[i][r] : a[r][i]) * (transB ? b[j][i] : b[i][j]);
+                }
+            }
+            else {
+                for (int i=0; i<K; i++) {
+                    sum += (alpha * (transA ? a[i][r] : a[r][i])) * (transB ? b[j][i] : b[i][j]);
+                }
+            }
+            c[r][j] = sum;
+        }
+    }
+}
+
+
+// c = alpha op(a) op(b) + beta c (see gemm) by whichever way suits the size
+template <class T>
+static void product(int M, int N, int K, double alpha, T **a, bool transA, T **b, bool transB, double beta, T **c)
+{
+    if (gemmWorthIt(M, N, K)) gemm<T>(M, N, K, alpha, a, transA, b, transB, beta, c);
+    else if (!transA && !transB) productLoop<T, false, false>(M, N, K, alpha, a, b, beta, c);
+    else if (!transA) productLoop<T, false, true>(M, N, K, alpha, a, b, beta, c);
+    else if (!transB) productLoop<T, true, false>(M, N, K, alpha, a, b, beta, c);
+    else productLoop<T, true, true>(M, N, K, alpha, a, b, beta, c);
+}
+
+
+
+// dot or inner product or classic matrix multiply
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::dot(const MatrixT &other)
+{
+    ProfileScope prof("dot", name);
+
+    assertDefined("lhs of dot");
+    other.assertDefined("rhs of dot");
+    assertOtherLhs(other, "dot");
+
+    MatrixT out(maxr, other.maxc);
+    product(maxr, other.maxc, maxc, 1.0, m, false, other.m, false, 0.0, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// dot or inner product or classic matrix multiply BUT
+// the SECOND argument is transposed!
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::dotT(const MatrixT &other)
+{
+    ProfileScope prof("dotT", name);
+
+    assertDefined("lhs of dotT");
+    other.assertDefined("rhs of dotT");
+    assertColsEqual(other, "dotT");
+
+    MatrixT out(maxr, other.maxr);
+    product(maxr, other.maxr, maxc, 1.0, m, false, other.m, true, 0.0, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// dot or inner product or classic matrix multiply BUT
+// the FIRST argument is transposed!
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::Tdot(const MatrixT &other)
+{
+    ProfileScope prof("Tdot", name);
+
+    assertDefined("lhs of Tdot");
+    other.assertDefined("rhs of Tdot");
+    assertRowsEqual(other, "Tdot");
+
+    MatrixT out(maxc, other.maxc);       // use columns from first
+    product(maxc, other.maxc, maxr, 1.0, m, true, other.m, false, 0.0, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// get out ready for out = alpha op(self) op(other) + beta out of size r X c
+template <class T>
+void MatrixT<T>::prepareInto(const MatrixT &other, MatrixT &out, int r, int c, double beta, const char *msg) const
+{
+    if (&out==this || &out==&other) {
+        printf("ERROR(%s): the answer can not also be a factor of the product\n", msg);
+        exit(1);
+    }
+    if (beta!=0.0 || out.submatrix) out.assertSize(r, c, msg);
+    else out.reallocate(r, c, out.name);
+}
+
+
+// out = alpha self other + beta out
+template <class T>
+MatrixT<T> &MatrixT<T>::dotInto(const MatrixT &other, MatrixT &out, double alpha, double beta) const
+{
+    ProfileScope prof("dotInto", name);
+
+    assertDefined("lhs of dotInto");
+    other.assertDefined("rhs of dotInto");
+    assertOtherLhs(other, "dotInto");
+    prepareInto(other, out, maxr, other.maxc, beta, "dotInto");
+
+    product(maxr, other.maxc, maxc, alpha, m, false, other.m, false, beta, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+// out = alpha self Transpose(other) + beta out
+template <class T>
+MatrixT<T> &MatrixT<T>::dotTInto(const MatrixT &other, MatrixT &out, double alpha, double beta) const
+{
+    ProfileScope prof("dotTInto", name);
+
+    assertDefined("lhs of dotTInto");
+    other.assertDefined("rhs of dotTInto");
+    assertColsEqual(other, "dotTInto");
+    prepareInto(other, out, maxr, other.maxr, beta, "dotTInto");
+
+    product(maxr, other.maxr, maxc, alpha, m, false, other.m, true, beta, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+// out = alpha Transpose(self) other + beta out
+template <class T>
+MatrixT<T> &MatrixT<T>::TdotInto(const MatrixT &other, MatrixT &out, double alpha, double beta) const
+{
+    ProfileScope prof("TdotInto", name);
+
+    assertDefined("lhs of TdotInto");
+    other.assertDefined("rhs of TdotInto");
+    assertRowsEqual(other, "TdotInto");
+    prepareInto(other, out, maxc, other.maxc, beta, "TdotInto");
+
+    product(maxc, other.maxc, maxr, alpha, m, true, other.m, false, beta, out.m);
+    out.defined = true;
+
+    return out;
+}
+
+
+
+
+// This computes the mean of every column and puts it into a row vector
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::meanVec()
+{
+    ProfileScope prof("meanVec", name);
+
+    MatrixT mean(1, maxc);
+
+    parallelFor(maxc, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int c=lo; c<hi; c++) {
+            double sum;
+
+            sum = 0;
+            for (int r=0; r<maxr; r++) {
+                sum += m[r][c];
+            }
+            mean.m[0][c] = sum/maxr;
+        }
+    });
+
+    mean.defined = true;
+
+    return mean;
+}
+
+
+// This computes the standard deviation (BIASED: divides by n) of every
+// column and puts it into a row vector
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::stddevVec() {
+    ProfileScope prof("stddevVec", name);
+
+    assertDefined("stddevVec");
+
+    MatrixT stats = columnStats();
+    MatrixT stddev(1, maxc);
+    for (int c=0; c<maxc; c++) stddev.m[0][c] = sqrt(stats.m[STAT_VARIANCE][c]);
+    stddev.defined = true;
+
+    return stddev;
+}
+
+
+// Statistics of the columns c0..c1-1 over rows taken a block at a time.
+// The block's sums, extremes and nonzero counts are gathered, then
+// (while the block is still in cache) its squared deviations from its
+// own mean, and the block is merged into the running mean and sum of
+// squared deviations (m2) by the pairwise update.  This is stable where
+// sum2/n - mean^2 is not.  The inner loops run along a row so the
+// compiler can use SIMD.  Each array is indexed by column; bsum and bm2
+// are c1-c0 long scratch.  seen is the rows already merged.
+static const int columnStatsBlockRows = 64;
+
+template <class T>
+static void columnStatsBlock(T *const *rows, int nb, long long seen, int c0, int c1, double *sum, double *mean,
+                             double *m2, double *min, double *max, double *nonZero, double *bsum, double *bm2)
+{
+    int w = c1 - c0;
+
+    if (seen==0) {
+        for (int c=c0; c<c1; c++) {
+            sum[c] = mean[c] = m2[c] = nonZero[c] = 0;
+            min[c] = max[c] = rows[0][c];
+        }
+    }
+
+    for (int i=0; i<w; i++) bsum[i] = bm2[i] = 0;
+    for (int r=0; r<nb; r++) {
+        const T *x = rows[r];
+
+        for (int c=c0; c<c1; c++) {
+            double v = x[c];
+
+            sum[c] += v;
+            bsum[c-c0] += v;
+            min[c] = v < min[c] ? v : min[c];
+            max[c] = v > max[c] ? v : max[c];
+            nonZero[c] += (v != 0);
+        }
+    }
+    for (int i=0; i<w; i++) bsum[i] /= nb;        // now the block's mean
+    for (int r=0; r<nb; r++) {
+        const T *x = rows[r];
+
+        for (int c=c0; c<c1; c++) {
+            double d = x[c] - bsum[c-c0];
+
+            bm2[c-c0] += d*d;
+        }
+    }
+
+    double f = (double)seen*nb/(seen + nb), g = (double)nb/(seen + nb);
+    for (int c=c0; c<c1; c++) {
+        double delta = bsum[c-c0] - mean[c];
+
+        m2[c] += bm2[c-c0] + f*delta*delta;
+        mean[c] += g*delta;
+    }
+}
+
+
+// columnStatsBlock over the rows r0..r1-1 of m
+template <class T>
+static void columnStatsRange(T **m, int r0, int r1, int c0, int c1, double *sum, double *mean,
+                             double *m2, double *min, double *max, double *nonZero)
+{
+    const int block = columnStatsBlockRows;
+    int w = c1 - c0;
+    double *bsum;
+
+    bsum = new double [2*w];      // indexed by c-c0
+    for (int b0=r0; b0<r1; b0+=block) {
+        columnStatsBlock(m + b0, std::min(block, r1-b0), b0 - r0, c0, c1, sum, mean, m2, min, max, nonZero, bsum, bsum + w);
+    }
+
+    delete [] bsum;
+}
+
+
+// The mean, variance (BIASED: divides by n like stddevVec), min, max and
+// number of nonzero elements of every column in one pass over the
+// matrix.  Row STAT_MEAN of the answer has the means and so on (see
+// MatrixBase::ColumnStat).  With enough columns each thread takes a
+// range of them and the means are exactly those of meanVec.  Otherwise
+// the rows are split among the threads and the pieces merged (so the
+// means may differ from meanVec in the last bit).
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::columnStats()
+{
+    ProfileScope prof("columnStats", name);
+
+    assertDefined("columnStats");
+
+    const int kinds = 6;          // sum, mean, m2, min, max, nonZero
+    int pieces;
+    double *part;
+
+    pieces = numThreads();
+    if (maxc >= 64*pieces || maxr < 1024*pieces) pieces = 1;
+
+    part = new double [(size_t)pieces*kinds*maxc];
+    auto slot = [&](int p, int kind) { return part + ((size_t)p*kinds + kind)*maxc; };
+
+    if (pieces==1) {
+        // split the columns: each thread still walks along the rows
+        parallelFor(maxc, 4.0*maxr*maxc, [&](int lo, int hi) {
+            columnStatsRange(m, 0, maxr, lo, hi, slot(0, 0), slot(0, 1), slot(0, 2), slot(0, 3), slot(0, 4), slot(0, 5));
+        });
+    }
+    else {
+        // too few columns to share out so split the rows and merge the pieces in order
+        parallelFor(pieces, 4.0*maxr*maxc, [&](int lo, int hi) {
+            for (int p=lo; p<hi; p++) {
+                columnStatsRange(m, (int)((long long)maxr*p/pieces), (int)((long long)maxr*(p+1)/pieces), 0, maxc,
+                                 slot(p, 0), slot(p, 1), slot(p, 2), slot(p, 3), slot(p, 4), slot(p, 5));
+            }
+        }, 1);
+
+        for (int p=1; p<pieces; p++) {
+            double na, nb;    // rows in pieces 0..p-1 (merged) and in piece p
+
+            na = (double)(int)((long long)maxr*p/pieces);
+            nb = (double)(int)((long long)maxr*(p+1)/pieces) - na;
+            for (int c=0; c<maxc; c++) {
+                double delta = slot(p, 1)[c] - slot(0, 1)[c];
+
+                slot(0, 0)[c] += slot(p, 0)[c];
+                slot(0, 2)[c] += slot(p, 2)[c] + delta*delta*na*nb/(na + nb);
+                slot(0, 1)[c] += delta*nb/(na + nb);
+                if (slot(p, 3)[c] < slot(0, 3)[c]) slot(0, 3)[c] = slot(p, 3)[c];
+                if (slot(p, 4)[c] > slot(0, 4)[c]) slot(0, 4)[c] = slot(p, 4)[c];
+                slot(0, 5)[c] += slot(p, 5)[c];
+            }
+        }
+    }
+
+    MatrixT stats(STAT_ROWS, maxc, "columnStats of " + name);
+    for (int c=0; c<maxc; c++) {
+        stats.m[STAT_MEAN][c] = slot(0, 0)[c]/maxr;
+        stats.m[STAT_VARIANCE][c] = slot(0, 2)[c]/maxr;
+        stats.m[STAT_MIN][c] = slot(0, 3)[c];
+        stats.m[STAT_MAX][c] = slot(0, 4)[c];
+        stats.m[STAT_NONZERO][c] = slot(0, 5)[c];
+    }
+    stats.defined = true;
+    delete [] part;
+
+    return stats;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Covariance
+//
+
+// out += Transpose(x) x for the n rows of x but only on and above the
+// diagonal.  The triangle is cut into tiles each done by the blocked
+// multiply and the tiles are spread over the threads.
+static void syrkUpper(int n, int cols, double **x, double **out)
+{
+    const int tile = 128;
+    int tiles = (cols + tile - 1)/tile;
+    std::vector<std::pair<int, int> > work;
+
+    for (int i=0; i<tiles; i++) {
+        for (int j=i; j<tiles; j++) work.push_back(std::make_pair(i*tile, j*tile));
+    }
+
+    parallelFor((int)work.size(), (double)n*cols*cols, [&](int lo, int hi) {
+        double **a, **b, **c;
+
+        a = new double *[n];
+        b = new double *[n];
+        c = new double *[tile];
+        for (int t=lo; t<hi; t++) {
+            int i0 = work[t].first, j0 = work[t].second;
+            int mi = std::min(tile, cols-i0), nj = std::min(tile, cols-j0);
+
+            for (int k=0; k<n; k++) {
+                a[k] = x[k] + i0;
+                b[k] = x[k] + j0;
+            }
+            for (int i=0; i<mi; i++) c[i] = out[i0+i] + j0;
+            product(mi, nj, n, 1.0, a, true, b, false, 1.0, c);
+        }
+        delete [] a;
+        delete [] b;
+        delete [] c;
+    }, 2);
+}
+
+
+template <class T>
+CovAccumulatorT<T>::CovAccumulatorT(int cols)
+{
+    maxc = 0;
+    n = 0;
+    mean = NULL;
+    m2 = NULL;
+    scratch = NULL;
+    if (cols>0) setCols(cols, "CovAccumulator");
+}
+
+
+template <class T>
+CovAccumulatorT<T>::~CovAccumulatorT()
+{
+    if (m2) delete [] m2[0];
+    delete [] m2;
+    delete [] mean;
+    delete [] scratch;
+}
+
+
+// the first rows seen fix the number of columns
+template <class T>
+void CovAccumulatorT<T>::setCols(int c, const char *msg)
+{
+    if (maxc==0 && c>0) {
+        maxc = c;
+        mean = new double [maxc];
+        scratch = new double [maxc];
+        m2 = new double *[maxc];
+        m2[0] = new double [(size_t)maxc*maxc];
+        for (int r=1; r<maxc; r++) m2[r] = m2[0] + (size_t)r*maxc;
+        clear();
+    }
+    else if (c!=maxc) {
+        printf("ERROR(CovAccumulator::%s): rows have %d columns but the accumulator has %d\n", msg, c, maxc);
+        exit(1);
+    }
+}
+
+
+template <class T>
+void CovAccumulatorT<T>::clear()
+{
+    n = 0;
+    for (int c=0; c<maxc; c++) mean[c] = 0;
+    for (size_t i=0; i<(size_t)maxc*maxc; i++) m2[0][i] = 0;
+}
+
+
+// Add rows a block at a time.  Each block is centered on its own mean and
+// then merged: with d the difference in the means the sums of products
+// grow by d d^T n nb / (n + nb) besides the block's own sums.
+template <class T>
+void CovAccumulatorT<T>::add(const MatrixT<T> &rows)
+{
+    rows.assertDefined("CovAccumulator::add");
+    setCols(rows.maxc, "add");
+
+    const int chunk = 1024;       // rows centered at a time
+    double *bmean;
+
+    MatrixT<double> cent(std::min(chunk, rows.maxr), maxc);
+    bmean = new double [maxc];
+    for (int r0=0; r0<rows.maxr; r0+=chunk) {
+        int nb = std::min(chunk, rows.maxr-r0);
+        T **x = rows.m + r0;
+
+        parallelFor(maxc, (double)nb*maxc, [&](int lo, int hi) {
+            for (int c=lo; c<hi; c++) bmean[c] = 0;
+            for (int i=0; i<nb; i++) {
+                for (int c=lo; c<hi; c++) bmean[c] += x[i][c];
+            }
+            for (int c=lo; c<hi; c++) bmean[c] /= nb;
+        });
+
+        parallelFor(nb, (double)nb*maxc, [&](int lo, int hi) {
+            for (int i=lo; i<hi; i++) {
+                for (int c=0; c<maxc; c++) cent.m[i][c] = x[i][c] - bmean[c];
+            }
+        });
+
+        if (n>0) {
+            double f = (double)n*nb/(n + nb), g = (double)nb/(n + nb);
+
+            for (int c=0; c<maxc; c++) scratch[c] = bmean[c] - mean[c];
+            parallelFor(maxc, (double)maxc*maxc, [&](int lo, int hi) {
+                for (int r=lo; r<hi; r++) {
+                    for (int c=r; c<maxc; c++) m2[r][c] += f*scratch[r]*scratch[c];
+                }
+            });
+            for (int c=0; c<maxc; c++) mean[c] += g*scratch[c];
+        }
+        else {
+            for (int c=0; c<maxc; c++) mean[c] = bmean[c];
+        }
+        syrkUpper(nb, maxc, cent.m, m2);
+        n += nb;
+    }
+    delete [] bmean;
+}
+
+
+// Welford's update for the single row r of rows
+template <class T>
+void CovAccumulatorT<T>::addRow(const MatrixT<T> &rows, int r)
+{
+    rows.assertDefined("CovAccumulator::addRow");
+    rows.checkBounds(r, 0, "CovAccumulator::addRow");
+    setCols(rows.maxc, "addRow");
+
+    const T *row = rows.m[r];
+
+    n++;
+    for (int c=0; c<maxc; c++) {
+        scratch[c] = row[c] - mean[c];
+        mean[c] += scratch[c]/n;
+    }
+    for (int i=0; i<maxc; i++) {
+        for (int c=i; c<maxc; c++) m2[i][c] += scratch[i]*(row[c] - mean[c]);
+    }
+}
+
+
+// add in the rows seen by other (which is left alone)
+template <class T>
+void CovAccumulatorT<T>::merge(const CovAccumulatorT &other)
+{
+    if (other.n==0) return;
+    setCols(other.maxc, "merge");
+
+    double f = (double)n*other.n/(n + other.n), g = (double)other.n/(n + other.n);
+
+    for (int c=0; c<maxc; c++) scratch[c] = other.mean[c] - mean[c];
+    parallelFor(maxc, (double)maxc*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=r; c<maxc; c++) m2[r][c] += other.m2[r][c] + f*scratch[r]*scratch[c];
+        }
+    });
+    for (int c=0; c<maxc; c++) mean[c] += g*scratch[c];
+    n += other.n;
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> CovAccumulatorT<T>::meanVec() const
+{
+    if (n==0) {
+        printf("ERROR(CovAccumulator::meanVec): no rows have been added\n");
+        exit(1);
+    }
+
+    MatrixT<T> out(1, maxc);
+    for (int c=0; c<maxc; c++) out.m[0][c] = mean[c];
+    out.defined = true;
+
+    return out;
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> CovAccumulatorT<T>::cov(bool unbiased) const
+{
+    if (n < (unbiased ? 2 : 1)) {
+        printf("ERROR(CovAccumulator::cov): %lld rows is too few for the %s covariance\n", n, unbiased ? "unbiased" : "biased");
+        exit(1);
+    }
+
+    double inv = 1.0/(unbiased ? n-1 : n);
+
+    MatrixT<T> out(maxc, maxc);
+    parallelFor(maxc, (double)maxc*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=r; c<maxc; c++) out.m[r][c] = out.m[c][r] = m2[r][c]*inv;
+        }
+    });
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// covariance matrix
+// WARNING: This is NOT the unbiased covariance in which
+// you divide by (n - 1)!  In this routine we divide by n.
+//
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::cov()
+{
+    ProfileScope prof("cov", name);
+
+    assertDefined("cov");
+
+    CovAccumulatorT<T> acc(maxc);
+    acc.add(*this);
+
+    return acc.cov();
+}
+
+
+// covariance matrix dividing by (n - 1)
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::covUnbiased()
+{
+    ProfileScope prof("covUnbiased", name);
+
+    assertDefined("covUnbiased");
+
+    CovAccumulatorT<T> acc(maxc);
+    acc.add(*this);
+
+    return acc.cov(true);
+}
+
+
+// the covariance of each column of self with each column of other
+// (divides by n).  Both are centered once and then multiplied.
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::cov(MatrixT &other)
+{
+    ProfileScope prof("cov", name);
+
+    assertDefined("cov");
+    other.assertDefined("cov");
+    assertRowsEqual(other, "cov");
+
+    MatrixT<double> a(maxr, maxc), b(maxr, other.maxc), sum(maxc, other.maxc);
+    T **x;
+    int cols;
+    MatrixT<double> *cent;
+
+    for (int pass=0; pass<2; pass++) {
+        double *mean;
+
+        x = pass==0 ? m : other.m;
+        cols = pass==0 ? maxc : other.maxc;
+        cent = pass==0 ? &a : &b;
+
+        mean = new double [cols];
+        parallelFor(cols, (double)maxr*cols, [&](int lo, int hi) {
+            for (int c=lo; c<hi; c++) mean[c] = 0;
+            for (int r=0; r<maxr; r++) {
+                for (int c=lo; c<hi; c++) mean[c] += x[r][c];
+            }
+            for (int c=lo; c<hi; c++) mean[c] /= maxr;
+        });
+        parallelFor(maxr, (double)maxr*cols, [&](int lo, int hi) {
+            for (int r=lo; r<hi; r++) {
+                for (int c=0; c<cols; c++) cent->m[r][c] = x[r][c] - mean[c];
+            }
+        });
+        delete [] mean;
+    }
+
+    product(maxc, other.maxc, maxr, 1.0/maxr, a.m, true, b.m, false, 0.0, sum.m);
+
+    MatrixT out(maxc, other.maxc);
+    for (int r=0; r<maxc; r++) {
+        for (int c=0; c<other.maxc; c++) out.m[r][c] = sum.m[r][c];
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+
+template <class T>
+MatrixT<T> &MatrixT<T>::identity()
+{
+    assertSquare("identity");
+
+    constant(0.0);
+    constantDiagonal(1.0);
+
+    return *this;
+}
+
+
+// scalar multiply
+template <class T>
+MatrixT<T> &MatrixT<T>::scalarMult(double x)
+{
+    ProfileScope prof("scalarMult", name);
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] *= x;
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// scalar add
+template <class T>
+MatrixT<T> &MatrixT<T>::scalarAdd(double x)
+{
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] += x;
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// performs the function over the cartesian product over the rows of the two matrices
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::cartesianRow(double (*f)(int size, T *x, T *y), MatrixT &other)
+{
+    assertDefined("cartesianRow");
+    other.assertDefined("cartesianRow");
+    assertColsEqual(other, "cartesianRow");
+
+    MatrixT out(maxr, other.maxr);
+
+    for (int r=0; r<out.maxr; r++) {
+        for (int c=0; c<out.maxc; c++) {
+            out.m[r][c] = f(maxc, m[r], other.m[c]);
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+// apply a function to every element
+// NOTE: on big matrices f is called from several threads at once
+// WARNING: overwrites self
+template <class T>
+MatrixT<T> &MatrixT<T>::map(double (*f)(double x))
+{
+    ProfileScope prof("map", name);
+
+    assertDefined("map");
+
+    parallelFor(maxr, 10.0*maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = f(m[r][c]);
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// apply a function to every element
+// WARNING: overwrites self
+template <class T>
+MatrixT<T> &MatrixT<T>::mapCol(int c, double (*f)(double x))
+{
+    assertDefined("mapCol");
+    assertColIndexOK(c, "mapCol");
+
+    for (int r=0; r<maxr; r++) {
+        m[r][c] = f(m[r][c]);
+    }
+
+    return *this;
+}
+
+
+
+// apply a function to every element and its index
+// NOTE: it does not check if the array is undefined or not
+// so the function is free to use only the index pair.
+template <class T>
+MatrixT<T> &MatrixT<T>::mapIndex(double (*f)(int r, int c, double x))
+{
+    assertDefined("mapIndex");
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = f(r, c, m[r][c]);
+        }
+    }
+
+    defined = true;  // this may not be true if function uses undefined values
+
+    return *this;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Activation functions
+//
+// mapLogistic, mapTanh and mapStep apply the usual neural network
+// activations to every element.  They do not call exp() but use
+// matExp() below which does the same operations one element at a time
+// or four at a time with AVX2, so the answer does not depend on the CPU.
+//
+// matExp(x): x = n ln(2) + r with |r| <= ln(2)/2, exp(r) from its Taylor
+// series to r^13 and 2^n put straight into the exponent bits.  Over
+// -708 <= x <= 709 the relative error is below 5e-16 (2 ulp).
+// Outside that x is clamped so the answer stays finite and positive.
+// From this mapLogistic and mapTanh are within 1e-15 absolute.
+//
+
+static const double expHi = 709.0;
+static const double expLo = -708.0;
+static const double expLog2e = 1.4426950408889634074;
+static const double expLn2Hi = 6.93145751953125e-1;      // ln(2) split so n*ln2Hi is exact
+static const double expLn2Lo = 1.42860682030941723212e-6;
+static const double expRound = 6755399441055744.0;       // 1.5*2^52: adding it rounds to an integer
+static const double expCoef[14] = {
+    1.0, 1.0, 1.0/2, 1.0/6, 1.0/24, 1.0/120, 1.0/720, 1.0/5040, 1.0/40320,
+    1.0/362880, 1.0/3628800, 1.0/39916800, 1.0/479001600, 1.0/6227020800.0
+};
+
+static inline double matExp(double x)
+{
+    double t, n, r, p, scale;
+    unsigned long long bits;
+
+    x = (x < expLo) ? expLo : x;
+    x = (x > expHi) ? expHi : x;
+
+    t = x * expLog2e + expRound;
+    n = t - expRound;
+    r = x - n * expLn2Hi;
+    r = r - n * expLn2Lo;
+
+    p = expCoef[13];
+    for (int i=12; i>=0; i--) p = p * r + expCoef[i];
+
+    memcpy(&bits, &t, sizeof(bits));
+    bits = (bits + 1023) << 52;
+    memcpy(&scale, &bits, sizeof(scale));
+
+    return p * scale;
+}
+
+
+#ifdef MAT_X86
+// four at a time: exactly the same operations as matExp
+__attribute__((target("avx2")))
+static inline __m256d matExp4(__m256d x)
+{
+    __m256d t, n, r, p;
+    __m256i bits;
+
+    x = _mm256_max_pd(_mm256_set1_pd(expLo), x);    // NaN passes through
+    x = _mm256_min_pd(_mm256_set1_pd(expHi), x);
+
+    t = _mm256_add_pd(_mm256_mul_pd(x, _mm256_set1_pd(expLog2e)), _mm256_set1_pd(expRound));
+    n = _mm256_sub_pd(t, _mm256_set1_pd(expRound));
+    r = _mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(expLn2Hi)));
+    r = _mm256_sub_pd(r, _mm256_mul_pd(n, _mm256_set1_pd(expLn2Lo)));
+
+    p = _mm256_set1_pd(expCoef[13]);
+    for (int i=12; i>=0; i--) p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(expCoef[i]));
+
+    bits = _mm256_slli_epi64(_mm256_add_epi64(_mm256_castpd_si256(t), _mm256_set1_epi64x(1023)), 52);
+
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(bits));
+}
+
+
+// 1/(1 + exp(-slope x)) on n values
+__attribute__((target("avx2")))
+static void logisticAvx2(double *v, int n, double slope)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d ms = _mm256_set1_pd(-slope);
+    int c;
+
+    for (c=0; c+4<=n; c+=4) {
+        __m256d x = _mm256_loadu_pd(v+c);
+        _mm256_storeu_pd(v+c, _mm256_div_pd(one, _mm256_add_pd(one, matExp4(_mm256_mul_pd(ms, x)))));
+    }
+    for (; c<n; c++) v[c] = 1.0/(1.0 + matExp(-slope * v[c]));
+}
+
+
+// 1 - 2/(1 + exp(2x)) on n values
+__attribute__((target("avx2")))
+static void tanhAvx2(double *v, int n)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    int c;
+
+    for (c=0; c+4<=n; c+=4) {
+        __m256d x = _mm256_loadu_pd(v+c);
+        _mm256_storeu_pd(v+c, _mm256_sub_pd(one, _mm256_div_pd(two, _mm256_add_pd(one, matExp4(_mm256_mul_pd(two, x))))));
+    }
+    for (; c<n; c++) v[c] = 1.0 - 2.0/(1.0 + matExp(2.0 * v[c]));
+}
+
+
+// floats are done in double and rounded once at the end, the same as
+// the scalar loops in mapLogistic and mapTanh
+__attribute__((target("avx2")))
+static void logisticAvx2(float *v, int n, double slope)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d ms = _mm256_set1_pd(-slope);
+    int c;
+
+    for (c=0; c+4<=n; c+=4) {
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(v+c));
+        _mm_storeu_ps(v+c, _mm256_cvtpd_ps(_mm256_div_pd(one, _mm256_add_pd(one, matExp4(_mm256_mul_pd(ms, x))))));
+    }
+    for (; c<n; c++) v[c] = 1.0/(1.0 + matExp(-slope * v[c]));
+}
+
+
+__attribute__((target("avx2")))
+static void tanhAvx2(float *v, int n)
+{
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    int c;
+
+    for (c=0; c+4<=n; c+=4) {
+        __m256d x = _mm256_cvtps_pd(_mm_loadu_ps(v+c));
+        _mm_storeu_ps(v+c, _mm256_cvtpd_ps(_mm256_sub_pd(one, _mm256_div_pd(two, _mm256_add_pd(one, matExp4(_mm256_mul_pd(two, x)))))));
+    }
+    for (; c<n; c++) v[c] = 1.0 - 2.0/(1.0 + matExp(2.0 * v[c]));
+}
+
+
+// eight at a time: the same operations again (again with no fma).  GCC
+// 12 warns about its own header for some of these intrinsics.
+#pragma GCC push_options
+#pragma GCC optimize("fp-contract=off")
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+static inline __m512d matExp8(__m512d x)
+{
+    __m512d t, n, r, p;
+    __m512i bits;
+
+    x = _mm512_max_pd(_mm512_set1_pd(expLo), x);    // NaN passes through
+    x = _mm512_min_pd(_mm512_set1_pd(expHi), x);
+
+    t = _mm512_add_pd(_mm512_mul_pd(x, _mm512_set1_pd(expLog2e)), _mm512_set1_pd(expRound));
+    n = _mm512_sub_pd(t, _mm512_set1_pd(expRound));
+    r = _mm512_sub_pd(x, _mm512_mul_pd(n, _mm512_set1_pd(expLn2Hi)));
+    r = _mm512_sub_pd(r, _mm512_mul_pd(n, _mm512_set1_pd(expLn2Lo)));
+
+    p = _mm512_set1_pd(expCoef[13]);
+    for (int i=12; i>=0; i--) p = _mm512_add_pd(_mm512_mul_pd(p, r), _mm512_set1_pd(expCoef[i]));
+
+    bits = _mm512_slli_epi64(_mm512_add_epi64(_mm512_castpd_si512(t), _mm512_set1_epi64(1023)), 52);
+
+    return _mm512_mul_pd(p, _mm512_castsi512_pd(bits));
+}
+
+
+__attribute__((target("avx512f")))
+static void logisticAvx512(double *v, int n, double slope)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d ms = _mm512_set1_pd(-slope);
+    int c;
+
+    for (c=0; c+8<=n; c+=8) {
+        __m512d x = _mm512_loadu_pd(v+c);
+        _mm512_storeu_pd(v+c, _mm512_div_pd(one, _mm512_add_pd(one, matExp8(_mm512_mul_pd(ms, x)))));
+    }
+    for (; c<n; c++) v[c] = 1.0/(1.0 + matExp(-slope * v[c]));
+}
+
+
+__attribute__((target("avx512f")))
+static void tanhAvx512(double *v, int n)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    int c;
+
+    for (c=0; c+8<=n; c+=8) {
+        __m512d x = _mm512_loadu_pd(v+c);
+        _mm512_storeu_pd(v+c, _mm512_sub_pd(one, _mm512_div_pd(two, _mm512_add_pd(one, matExp8(_mm512_mul_pd(two, x))))));
+    }
+    for (; c<n; c++) v[c] = 1.0 - 2.0/(1.0 + matExp(2.0 * v[c]));
+}
+
+
+__attribute__((target("avx512f")))
+static void logisticAvx512(float *v, int n, double slope)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d ms = _mm512_set1_pd(-slope);
+    int c;
+
+    for (c=0; c+8<=n; c+=8) {
+        __m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(v+c));
+        _mm256_storeu_ps(v+c, _mm512_cvtpd_ps(_mm512_div_pd(one, _mm512_add_pd(one, matExp8(_mm512_mul_pd(ms, x))))));
+    }
+    for (; c<n; c++) v[c] = 1.0/(1.0 + matExp(-slope * v[c]));
+}
+
+
+__attribute__((target("avx512f")))
+static void tanhAvx512(float *v, int n)
+{
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d two = _mm512_set1_pd(2.0);
+    int c;
+
+    for (c=0; c+8<=n; c+=8) {
+        __m512d x = _mm512_cvtps_pd(_mm256_loadu_ps(v+c));
+        _mm256_storeu_ps(v+c, _mm512_cvtpd_ps(_mm512_sub_pd(one, _mm512_div_pd(two, _mm512_add_pd(one, matExp8(_mm512_mul_pd(two, x)))))));
+    }
+    for (; c<n; c++) v[c] = 1.0 - 2.0/(1.0 + matExp(2.0 * v[c]));
+}
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+
+
+// logistic function with the given slope: 1/(1 + exp(-slope x))
+template <class T>
+MatrixT<T> &MatrixT<T>::mapLogistic(double slope)
+{
+    ProfileScope prof("mapLogistic", name);
+
+    assertDefined("mapLogistic");
+
+    int level = simdLevel();
+    parallelFor(maxr, 20.0*maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+#ifdef MAT_X86
+            if (level>=SIMD_AVX512) {
+                logisticAvx512(m[r], maxc, slope);
+                continue;
+            }
+            if (level>=SIMD_AVX2) {
+                logisticAvx2(m[r], maxc, slope);
+                continue;
+            }
+#endif
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = 1.0/(1.0 + matExp(-slope * m[r][c]));
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// hyperbolic tangent
+template <class T>
+MatrixT<T> &MatrixT<T>::mapTanh()
+{
+    ProfileScope prof("mapTanh", name);
+
+    assertDefined("mapTanh");
+
+    int level = simdLevel();
+    parallelFor(maxr, 20.0*maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+#ifdef MAT_X86
+            if (level>=SIMD_AVX512) {
+                tanhAvx512(m[r], maxc);
+                continue;
+            }
+            if (level>=SIMD_AVX2) {
+                tanhAvx2(m[r], maxc);
+                continue;
+            }
+#endif
+            for (int c=0; c<maxc; c++) {
+                m[r][c] = 1.0 - 2.0/(1.0 + matExp(2.0 * m[r][c]));
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+// step function: 0 below threshold and 1 at or above it
+template <class T>
+MatrixT<T> &MatrixT<T>::mapStep(double threshold)
+{
+    assertDefined("mapStep");
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            T *row = m[r];
+
+            for (int c=0; c<maxc; c++) {
+                row[c] = (row[c] < threshold) ? 0.0 : 1.0;
+            }
+        }
+    });
+
+    return *this;
+}
+
+
+
+// initializes the matrix to a constant
+template <class T>
+MatrixT<T> &MatrixT<T>::constant(double x)
+{
+    assertUsableSize("constant");
+    
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = x;
+        }
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+
+// initializes a column in a matrix to a constant
+template <class T>
+MatrixT<T> &MatrixT<T>::constantCol(int c, double x)
+{
+    assertColIndexOK(c, "constantCol");
+
+    for (int r=0; r<maxr; r++) {
+            m[r][c] = x;
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+// initializes a column in a matrix to a constant
+// WARNING: even though this only sets one column it marks the matrix as defined!
+//  This is because this is often used to init a matrix.
+template <class T>
+MatrixT<T> &MatrixT<T>::constantColRange(int c, double start, double step)
+{
+    assertColIndexOK(c, "constantColRange");
+
+    for (int r=0; r<maxr; r++) {
+            m[r][c] = start;
+            start += step;
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+
+// initializes the diagonal of a matrix to a constant
+template <class T>
+MatrixT<T> &MatrixT<T>::constantDiagonal(double x)
+{
+    int len;
+
+    len = maxr;
+    if (maxc<maxr) len = maxc;
+
+    for (int r=0; r<len; r++) {
+            m[r][r] = x;
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+// fill with random doubles in the given range: [min, max)
+template <class T>
+MatrixT<T> &MatrixT<T>::rand(double min, double max)
+{
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = randUnit()*(max-min) + min;
+        }
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+// fill the given column with random doubles in the given range: [min, max)
+// does not set the state of undefined
+template <class T>
+MatrixT<T> &MatrixT<T>::randCol(int c, double min, double max)
+{
+
+    for (int r=0; r<maxr; r++) {
+        m[r][c] = randUnit()*(max-min) + min;
+    }
+
+    return *this;
+}
+
+
+// fill with random integers in the given range: [min, max)
+template <class T>
+MatrixT<T> &MatrixT<T>::rand(int min, int max)
+{
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            m[r][c] = randMod(max-min) + min;
+        }
+    }
+
+    defined = true;
+
+    return *this;
+}
+
+
+// extracts a random sample with replacement of rows from self and
+// puts it into matrix out.  The size of the sample is the number of
+// rows in out.
+template <class T>
+MatrixT<T> &MatrixT<T>::sample(MatrixT &out)
+{
+    assertColsEqual(out, "sample");
+
+    for (int r=0; r<out.maxr; r++) {
+        int otherRow;
+
+        otherRow = randMod(maxr);
+        for (int c=0; c<maxc; c++) {
+            out.m[r][c] = m[otherRow][c];
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::transpose()
+{
+    ProfileScope prof("transpose", name);
+
+    assertDefined("transpose");
+
+    MatrixT out(maxc, maxr);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            out.m[c][r] = m[r][c];
+        }
+    }
+    out.defined = true;
+
+    return out;
+}
+
+
+
+// transposes in place, but will reallocate and copy if a nonsquare matrix!
+// WARNING: overwrites self
+template <class T>
+MatrixT<T> &MatrixT<T>::transposeSelf()
+{
+    ProfileScope prof("transposeSelf", name);
+
+    assertDefined("transposeSelf");
+
+    // handle square matrix in place
+    if (maxr == maxc) {
+        for (int r=0; r<maxr; r++) {
+            for (int c=r+1; c<maxc; c++) {
+                T tmp;
+                tmp = m[r][c]; m[r][c] = m[c][r]; m[c][r] = tmp;
+            }
+        }
+    }
+    // handle non-square matrix with reallocation
+    else {
+        T **oldm, *olddata;
+        int oldr, oldc;
+        bool oldsubmatrix;
+        void *oldmapping;
+        size_t oldmappingBytes;
+
+        oldm = m;
+        olddata = data;
+        oldr = maxr;
+        oldc = maxc;
+        oldsubmatrix = submatrix;
+        oldmapping = mapping;
+        oldmappingBytes = mappingBytes;
+
+        allocate(oldc, oldr, name);   // new storage in the current storage mode
+
+        for (int r=0; r<oldr; r++) {
+            for (int c=0; c<oldc; c++) {
+                m[c][r] = oldm[r][c];
+            }
+        }
+        
+        if (profile) profileFree(oldm);
+        freeRows(oldm, olddata, oldr, oldsubmatrix, oldmapping, oldmappingBytes);  // deallocate AFTER copying
+        defined = true;
+    }
+
+    return *this;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Linear systems
+//
+// The factorizations work a block of columns at a time.  The block is
+// factored with simple loops and the rest of the matrix is updated with
+// the blocked multiply (see gemm) which is where nearly all the time goes.
+// Rows are swapped by swapping row pointers just as the sorts do.
+//
+
+static const int factorBlock = 64;    // columns factored at a time
+
+
+// LU decomposition with partial pivoting of the n X n a in place: PA = LU
+// with the unit lower triangle L below the diagonal and U on and above
+// it.  Row i of the result was row perm[i] of a.  Returns false if a
+// zero pivot shows a is singular.
+template <class T>
+static bool luFactor(T **a, int n, int *perm)
+{
+    bool ok = true;
+    T **pl, **pu, **pc;
+
+    for (int i=0; i<n; i++) perm[i] = i;
+    pl = new T *[n];
+    pu = new T *[factorBlock];
+    pc = new T *[n];
+    for (int k0=0; k0<n; k0+=factorBlock) {
+        int k1 = std::min(n, k0+factorBlock);
+
+        // factor the panel of columns k0..k1-1 swapping whole rows
+        for (int j=k0; j<k1; j++) {
+            int p = j;
+            double big = fabs(a[j][j]);
+
+            for (int i=j+1; i<n; i++) {
+                if (fabs(a[i][j]) > big) {
+                    big = fabs(a[i][j]);
+                    p = i;
+                }
+            }
+            if (p!=j) {
+                std::swap(a[p], a[j]);
+                std::swap(perm[p], perm[j]);
+            }
+            if (a[j][j]==0) {
+                ok = false;
+                continue;
+            }
+
+            parallelFor(n-j-1, (double)(n-j)*(k1-j), [&](int lo, int hi) {
+                for (int i=j+1+lo; i<j+1+hi; i++) {
+                    T l = a[i][j] /= a[j][j];
+
+                    for (int c=j+1; c<k1; c++) a[i][c] -= l*a[j][c];
+                }
+            });
+        }
+        if (k1==n) break;
+
+        // U12 = inverse(L11) A12 for the rows of the panel
+        parallelFor(n-k1, 0.5*(n-k1)*(k1-k0)*(k1-k0), [&](int lo, int hi) {
+            for (int j=k0; j<k1; j++) {
+                for (int i=j+1; i<k1; i++) {
+                    T l = a[i][j];
+
+                    for (int c=k1+lo; c<k1+hi; c++) a[i][c] -= l*a[j][c];
+                }
+            }
+        });
+
+        // A22 -= L21 U12
+        for (int i=k1; i<n; i++) {
+            pl[i-k1] = a[i] + k0;
+            pc[i-k1] = a[i] + k1;
+        }
+        for (int i=k0; i<k1; i++) pu[i-k0] = a[i] + k1;
+        product(n-k1, n-k1, k1-k0, -1.0, pl, false, pu, false, 1.0, pc);
+    }
+    delete [] pl;
+    delete [] pu;
+    delete [] pc;
+
+    return ok;
+}
+
+
+// Cholesky decomposition A = L L^T of the symmetric positive definite n X n
+// a in place.  Only the lower triangle is read or written so if a turns
+// out not to be positive definite (false is returned) the upper triangle
+// still holds the original.
+template <class T>
+static bool choleskyFactor(T **a, int n)
+{
+    T **pl, **pc;
+
+    pl = new T *[n];
+    pc = new T *[n];
+    for (int k0=0; k0<n; k0+=factorBlock) {
+        int k1 = std::min(n, k0+factorBlock);
+        bool ok = true;
+
+        // factor the diagonal block (the blocks before are already taken out of it)
+        for (int j=k0; j<k1 && ok; j++) {
+            double d = a[j][j];
+
+            for (int p=k0; p<j; p++) d -= (double)a[j][p]*a[j][p];
+            if (!(d > 0)) {
+                ok = false;
+                break;
+            }
+            a[j][j] = d = sqrt(d);
+            for (int i=j+1; i<k1; i++) {
+                double s = a[i][j];
+
+                for (int p=k0; p<j; p++) s -= (double)a[i][p]*a[j][p];
+                a[i][j] = s/d;
+            }
+        }
+        if (!ok) {
+            delete [] pl;
+            delete [] pc;
+            return false;
+        }
+        if (k1==n) break;
+
+        // L21 = A21 inverse(L11)^T a row at a time
+        parallelFor(n-k1, (double)(n-k1)*(k1-k0)*(k1-k0), [&](int lo, int hi) {
+            for (int i=k1+lo; i<k1+hi; i++) {
+                for (int j=k0; j<k1; j++) {
+                    double s = a[i][j];
+
+                    for (int p=k0; p<j; p++) s -= (double)a[i][p]*a[j][p];
+                    a[i][j] = s/a[j][j];
+                }
+            }
+        });
+
+        // A22 -= L21 L21^T on and below the diagonal.  Each band of rows
+        // uses the blocked multiply left of its diagonal block and a loop
+        // for the lower half of the diagonal block itself.
+        for (int i=k1; i<n; i++) {
+            pl[i-k1] = a[i] + k0;
+            pc[i-k1] = a[i] + k1;
+        }
+        int bands = (n - k1 + factorBlock - 1)/factorBlock;
+        parallelFor(bands, (double)(n-k1)*(n-k1)*(k1-k0), [&](int lo, int hi) {
+            for (int b=lo; b<hi; b++) {
+                int i0 = k1 + b*factorBlock, i1 = std::min(n, i0+factorBlock);
+
+                if (i0 > k1) product(i1-i0, i0-k1, k1-k0, -1.0, pl+(i0-k1), false, pl, true, 1.0, pc+(i0-k1));
+                for (int i=i0; i<i1; i++) {
+                    for (int c=i0; c<=i; c++) {
+                        double s = 0;
+
+                        for (int p=k0; p<k1; p++) s += (double)a[i][p]*a[c][p];
+                        a[i][c] -= s;
+                    }
+                }
+            }
+        });
+    }
+    delete [] pl;
+    delete [] pc;
+
+    return true;
+}
+
+
+// Solve op(a) x = b in place for the n X m right-hand sides b where a is
+// lower or upper triangular and op(a) is a or its transpose.  Each block of
+// rows has the rows already solved taken out of it with the blocked
+// multiply and then is finished by substitution.
+template <class T>
+static void triangularSolve(T **a, int n, bool lower, bool trans, bool unit, T **b, int m)
+{
+    bool forward = (lower != trans);
+    T **p;
+
+    p = new T *[n];
+    for (int step=0; step*factorBlock < n; step++) {
+        int i0, i1;
+
+        if (forward) {
+            i0 = step*factorBlock;
+            i1 = std::min(n, i0+factorBlock);
+            if (i0 > 0) {
+                // b[i0..i1) -= op(a)[i0..i1, 0..i0) b[0..i0)
+                if (trans) {
+                    for (int k=0; k<i0; k++) p[k] = a[k] + i0;
+                    product(i1-i0, m, i0, -1.0, p, true, b, false, 1.0, b+i0);
+                }
+                else product(i1-i0, m, i0, -1.0, a+i0, false, b, false, 1.0, b+i0);
+            }
+        }
+        else {
+            i1 = n - step*factorBlock;
+            i0 = (i1 > factorBlock) ? i1-factorBlock : 0;
+            if (i1 < n) {
+                // b[i0..i1) -= op(a)[i0..i1, i1..n) b[i1..n)
+                if (trans) {
+                    for (int k=i1; k<n; k++) p[k-i1] = a[k] + i0;
+                    product(i1-i0, m, n-i1, -1.0, p, true, b+i1, false, 1.0, b+i0);
+                }
+                else {
+                    for (int i=i0; i<i1; i++) p[i-i0] = a[i] + i1;
+                    product(i1-i0, m, n-i1, -1.0, p, false, b+i1, false, 1.0, b+i0);
+                }
+            }
+        }
+
+        // substitution within the block, the right-hand sides shared out by column
+        parallelFor(m, (double)(i1-i0)*(i1-i0)*m, [&](int lo, int hi) {
+            for (int s=0; s<i1-i0; s++) {
+                int i = forward ? i0+s : i1-1-s;
+                int j0 = forward ? i0 : i+1, j1 = forward ? i : i1;
+
+                for (int j=j0; j<j1; j++) {
+                    T l = trans ? a[j][i] : a[i][j];
+
+                    if (l!=0) for (int c=lo; c<hi; c++) b[i][c] -= l*b[j][c];
+                }
+                if (!unit) {
+                    T d = a[i][i];
+
+                    for (int c=lo; c<hi; c++) b[i][c] /= d;
+                }
+            }
+        });
+    }
+    delete [] p;
+}
+
+
+// Factor the n X n a in place for solving.  If tryCholesky and a is
+// symmetric a Cholesky decomposition is tried first (L in the lower
+// triangle, zeros above) and if a is not positive definite it is put back
+// and LU decomposition is used.  Returns 2 for Cholesky, 1 for LU and 0 if
+// a is singular.
+template <class T>
+static int factorSystem(T **a, int n, bool tryCholesky, int *perm)
+{
+    if (tryCholesky) {
+        for (int i=0; i<n && tryCholesky; i++) {
+            for (int j=0; j<i; j++) {
+                if (a[i][j]!=a[j][i]) {
+                    tryCholesky = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (tryCholesky) {
+        T *diag;
+
+        diag = new T [n];
+        for (int i=0; i<n; i++) diag[i] = a[i][i];
+        if (choleskyFactor(a, n)) {
+            for (int i=0; i<n; i++) {
+                for (int j=i+1; j<n; j++) a[i][j] = 0;
+            }
+            delete [] diag;
+            return 2;
+        }
+
+        // not positive definite: restore the lower triangle from the upper
+        for (int i=0; i<n; i++) {
+            a[i][i] = diag[i];
+            for (int j=0; j<i; j++) a[i][j] = a[j][i];
+        }
+        delete [] diag;
+    }
+
+    return luFactor(a, n, perm) ? 1 : 0;
+}
+
+
+// solve a x = b in place for the n X m b given the factors from factorSystem
+template <class T>
+static void solveFactored(T **f, int n, int kind, const int *perm, T **b, int m)
+{
+    if (kind==2) {
+        triangularSolve(f, n, true, false, false, b, m);    // L y = b
+        triangularSolve(f, n, true, true, false, b, m);     // L^T x = y
+    }
+    else {
+        T *rows, **q;
+
+        // put b in the order of the factored rows
+        rows = new T [(size_t)n*m];
+        q = new T *[n];
+        for (int i=0; i<n; i++) {
+            q[i] = rows + (size_t)i*m;
+            for (int c=0; c<m; c++) q[i][c] = b[perm[i]][c];
+        }
+        triangularSolve(f, n, true, false, true, q, m);     // L y = P b
+        triangularSolve(f, n, false, false, false, q, m);   // U x = y
+        for (int i=0; i<n; i++) {
+            for (int c=0; c<m; c++) b[i][c] = q[i][c];
+        }
+        delete [] rows;
+        delete [] q;
+    }
+}
+
+
+// LU decomposition IN PLACE with partial pivoting so PA = LU.  The unit
+// lower triangle L (diagonal not stored) is below the diagonal and U is
+// on and above it.  Rows are swapped as the pivots are chosen.
+// Returns the permutation: row r now holds what was row perm[r].
+// WARNING: allocates the permutation (delete [] it)
+template <class T>
+int *MatrixT<T>::LU()
+{
+    ProfileScope prof("LU", name);
+
+    int *perm;
+
+    assertDefined("LU decomposition");
+    assertSquare("LU decomposition");
+
+    perm = new int [maxr];
+    luFactor(m, maxr, perm);
+
+    return perm;
+}
+
+
+// Cholesky decomposition IN PLACE of a symmetric positive definite
+// matrix (such as cov() gives): self is replaced by the lower triangular
+// L with L Transpose(L) = self.  Only the lower triangle is read.
+template <class T>
+MatrixT<T> &MatrixT<T>::cholesky()
+{
+    ProfileScope prof("cholesky", name);
+
+    assertDefined("cholesky");
+    assertSquare("cholesky");
+
+    if (!choleskyFactor(m, maxr)) {
+        if (name.length()==0)
+            printf("ERROR(cholesky): matrix is not positive definite\n");
+        else
+            printf("ERROR(cholesky): matrix \"%s\" is not positive definite\n", name.c_str());
+        exit(1);
+    }
+    for (int r=0; r<maxr; r++) {
+        for (int c=r+1; c<maxc; c++) m[r][c] = 0;
+    }
+
+    return *this;
+}
+
+
+// solve op(self) x = B in place where self is lower (or upper) triangular
+// and op(self) is self or its transpose.  Each COLUMN of B is a vector to
+// solve for.  B is replaced by the solutions and returned.
+template <class T>
+MatrixT<T> &MatrixT<T>::solveTriangular(MatrixT &B, bool lower, bool transpose, bool unitDiagonal) const
+{
+    assertDefined("solveTriangular");
+    B.assertDefined("rhs of solveTriangular");
+    assertSquare("solveTriangular");
+    assertRowsEqual(B, "solveTriangular");
+
+    triangularSolve(m, maxr, lower, transpose, unitDiagonal, B.m, B.maxc);
+
+    return B;
+}
+
+
+// solve Ax = B where A is this matrix object and B is a matrix in
+// which each COLUMN is a vector to solve for.
+// output: B is replaced by the corresponding set of solution vectors.
+// This matrix is destroyed: it is replaced by its Cholesky factor if it
+// is symmetric positive definite and by its LU decomposition (rows
+// permuted) otherwise.  To solve with the same matrix many times use
+// MatrixSolver.
+template <class T>
+MatrixT<T> &MatrixT<T>::solve(MatrixT &B)
+{
+    ProfileScope prof("solve", name);
+
+    assertDefined("solve");
+    B.assertDefined("rhs of solve");
+    assertSquare("solve");
+    assertRowsEqual(B, "solve");
+
+    int *perm, kind;
+
+    perm = new int [maxr];
+    kind = factorSystem(m, maxr, true, perm);
+    if (kind==0) {
+        if (name.length()==0)
+            printf("ERROR(solve): matrix is singular\n");
+        else
+            printf("ERROR(solve): matrix \"%s\" is singular\n", name.c_str());
+        exit(1);
+    }
+    solveFactored(m, maxr, kind, perm, B.m, B.maxc);
+    delete [] perm;
+
+    return B;
+}
+
+
+template <class T>
+MatrixT<T> &MatrixT<T>::inverse()
+{
+    ProfileScope prof("inverse", name);
+
+    assertDefined("inverse");
+    assertSquare("inverse");
+
+    MatrixSolverT<T> solver(*this);
+    MatrixT<T> inv = solver.inverse();
+
+    *this = inv;
+
+    return *this;
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// class MatrixSolver
+//
+
+template <class T>
+MatrixSolverT<T>::MatrixSolverT(const MatrixT<T> &a, int method) : factors(a)
+{
+    a.assertSquare("MatrixSolver");
+
+    perm = new int [factors.maxr];
+    kind = factorSystem(factors.m, factors.maxr, method!=SOLVE_LU, perm);
+    if (method==SOLVE_CHOLESKY && kind!=2) {
+        printf("ERROR(MatrixSolver): matrix is not symmetric positive definite\n");
+        exit(1);
+    }
+    if (kind==0) {
+        printf("ERROR(MatrixSolver): matrix is singular\n");
+        exit(1);
+    }
+}
+
+
+template <class T>
+MatrixSolverT<T>::~MatrixSolverT()
+{
+    delete [] perm;
+}
+
+
+// b is replaced by x where a x = b (each column of b is a right-hand side)
+template <class T>
+MatrixT<T> &MatrixSolverT<T>::solveInPlace(MatrixT<T> &b) const
+{
+    b.assertDefined("rhs of MatrixSolver::solve");
+    factors.assertRowsEqual(b, "MatrixSolver::solve");
+
+    solveFactored(factors.m, factors.maxr, kind, perm, b.m, b.maxc);
+
+    return b;
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixSolverT<T>::solve(const MatrixT<T> &b) const
+{
+    MatrixT<T> x(b);
+
+    solveInPlace(x);
+
+    return x;
+}
+
+
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixSolverT<T>::inverse() const
+{
+    MatrixT<T> x(factors.maxr, factors.maxr);
+
+    x.constant(0.0);
+    x.constantDiagonal(1.0);
+    solveInPlace(x);
+
+    return x;
+}
+
+
+template <class T>
+double MatrixSolverT<T>::determinant() const
+{
+    double det = 1.0;
+
+    for (int i=0; i<factors.maxr; i++) det *= factors.m[i][i];
+    if (kind==2) return det*det;
+
+    // the sign of the permutation: each cycle of length k is k-1 swaps
+    bool *seen = new bool [factors.maxr];
+    for (int i=0; i<factors.maxr; i++) seen[i] = false;
+    for (int i=0; i<factors.maxr; i++) {
+        if (!seen[i]) {
+            for (int j=i; !seen[j]; j=perm[j]) {
+                seen[j] = true;
+                if (j!=i) det = -det;
+            }
+        }
+    }
+    delete [] seen;
+
+    return det;
+}
+
+
+
+// just print the size and name of the matrix
+template <class T>
+void MatrixT<T>::printSize(std::string msg) const
+{
+    if (msg.length()) {
+        printf("%s ", msg.c_str());
+    }
+
+    if (name.length()) {
+        printf("(size of %s: %d X %d)\n", name.c_str(), maxr, maxc);
+    }
+    else {
+        printf("(size: %d X %d)\n", maxr, maxc);
+    }
+    fflush(stdout);
+}
+
+
+// print the whole matrix including it's name and size
+template <class T>
+void MatrixT<T>::print(std::string msg) const
+{
+    assertDefined("print");
+
+    printSize(msg);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            printf("%10.5lf ", m[r][c]);
+//            printf("%7.3lg ", m[r][c]);
+        }
+        printf("\n");
+    }
+
+    fflush(stdout);
+}
+
+
+// print the whole matrix including it's name and size
+template <class T>
+void MatrixT<T>::printInt(std::string msg) const
+{
+    assertDefined("printInt");
+
+    printSize(msg);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (m[r][c] != int(m[r][c])) {
+                printf("ERROR(printInt): Trying to print an integer matrix but element at position %d, %d is %10.5lg which is not an integer\n", r, c, m[r][c]);
+                exit(1);
+            }
+            printf("%5d ", int(m[r][c]));
+        }
+        printf("\n");
+    }
+
+    fflush(stdout);
+}
+
+
+// print the whole matrix including it's name and size
+// included in this call is a list of row labels which are indexed by column 0.
+// zzz WARNING: no attempt to make sure column 0 indices are in range.
+template <class T>
+void MatrixT<T>::printLabeledRow(char **labels, std::string msg) const
+{
+    assertDefined("printLabeledRow");
+    if (labels==NULL) {
+        printf("ERROR(printLabeledRow): labels has not been defined!\n");
+        exit(1);
+    }
+
+    printSize(msg);
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (c==0) {
+                if (0<=m[r][0] && m[r][0]<maxr && int(m[r][0])==m[r][0]) {
+                    printf("%s ", labels[int(m[r][0])]);
+                }
+                else {
+                    printf("ERROR(printLabeledRow): Trying to print a label for a labeled matrix but in row %d the index into the label array %lg is not in range or not an integer.\n", r, m[r][0]);
+                    exit(1);
+                }
+            }
+            else {
+                printf("%lg ", m[r][c]);
+            }
+        }
+        printf("\n");
+    }
+
+    fflush(stdout);
+}
+
+
+// write out just the matrix data in a form that can be read back in
+template <class T>
+void MatrixT<T>::write()
+{
+    assertDefined("write");
+
+    printf("%d %d\n", maxr, maxc);
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            printf("%lg ", m[r][c]);
+        }
+        printf("\n");
+    }
+}
+
+
+
+
+// this will print a row with a terminal blank but no terminal newline
+template <class T>
+void MatrixT<T>::writeLine(int r)
+{
+    assertDefined("write");
+    checkBounds(r, 0, "writeLine");
+
+    for (int c=0; c<maxc; c++) {
+//        printf("%lg ", m[r][c]);
+        printf("%8.2f ", m[r][c]);
+    }
+}
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Reading the text form
+//
+// The text is a number of rows and a number of columns then the elements
+// by row, all separated by white space.  In a labeled matrix the first
+// element of each row is a label (any string without white space).
+//
+// Rather than a scanf per element the text is read in large blocks and
+// parsed here.  The number parser takes the same characters scanf("%lf")
+// would and gets the same value, so exactly the same files are accepted,
+// but it does not look at the locale and converts the usual numbers (up to
+// 19 digits and a small exponent) with one multiply or divide.  Anything
+// else (hex, inf, nan, long mantissas) goes to strtod as scanf does.
+//
+// Only a file can be read ahead: the file is then repositioned to just
+// after the matrix so the caller can go on reading it with scanf.  A pipe
+// is read a character at a time since nothing after the matrix may be
+// taken from it.  A big unlabeled matrix in a file is split at line ends
+// and the pieces are parsed on the shared threads.
+//
+
+static const size_t textBlock = 1<<20;              // bytes read at a time
+static const long long parallelTextBytes = 1<<20;   // smaller texts are parsed serially
+
+// what went wrong in the text and where
+struct TextProblem {
+    const char *what;        // the problem
+    std::string item;        // what was being read when it happened
+    long long line, col;     // where from where the reading began (both from 1)
+    int found;               // the character there or EOF
+};
+
+
+// the characters scanf counts as white space
+static inline bool textSpace(int c)
+{
+    return c==' ' || c=='\n' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+
+// Text to parse: either read from a file in blocks as it is used up or a
+// piece of a text already in memory.  peek() is the next character (EOF
+// at the end) and next() moves past it.
+class TextInput {
+public:
+    TextInput(FILE *fpx, size_t blockSizex) :
+        fp(fpx), blockSize(blockSizex), lines(0), lineStart(0), base(0)
+    {
+        buf = new char [blockSize];
+        p = end = buf;
+    }
+
+    TextInput(const char *text, size_t from, size_t to) :
+        fp(NULL), blockSize(0), lines(0), lineStart(0), base(0)
+    {
+        buf = (char *)text;
+        p = text + from;
+        end = text + to;
+    }
+
+    ~TextInput() { if (fp!=NULL) delete [] buf; }
+
+    int peek() { return (p<end || fill()) ? (unsigned char)*p : EOF; }
+    void next() { p++; }
+    long long where() const { return base + (p - buf); }   // offset from where the reading began
+
+    // the text in hand from the next character on so a parser can run over it directly
+    const char *at() const { return p; }
+    const char *atEnd() const { return end; }
+    void skipTo(const char *q) { p = q; }
+
+    // skip white space.  false if the text ends first
+    bool skipSpace()
+    {
+        do {
+            while (p<end && textSpace(*p)) p++;
+            if (p<end) return true;
+        } while (fill());
+
+        return false;
+    }
+
+    // give back the character read from the file but not used
+    void unread() { if (fp!=NULL && p<end) ungetc((unsigned char)*p, fp); }
+
+    // line and column of the next character
+    void lineCol(long long &line, long long &col) const
+    {
+        long long n, start;
+
+        n = lines;
+        start = lineStart;
+        countLines(buf, p, n, start);
+        line = n + 1;
+        col = where() - start + 1;
+    }
+
+private:
+    FILE *fp;                   // the file for a block reader else NULL
+    size_t blockSize;
+    char *buf;                  // the block or the whole text
+    const char *p, *end;        // the next character and the end of the data in buf
+    long long lines;            // newlines before buf
+    long long lineStart;        // offset of the start of the line buf begins in
+    long long base;             // offset of buf
+
+    // count the newlines in [from, to) and note where the last line starts
+    void countLines(const char *from, const char *to, long long &n, long long &start) const
+    {
+        const char *q;
+
+        while ((q = (const char *)memchr(from, '\n', to - from))!=NULL) {
+            n++;
+            start = base + (q - buf) + 1;
+            from = q + 1;
+        }
+    }
+
+    bool fill()
+    {
+        size_t n;
+
+        if (fp==NULL) return false;
+        countLines(buf, end, lines, lineStart);
+        base += end - buf;
+        if (blockSize==1) {
+            int c;
+
+            c = getc(fp);
+            if (c!=EOF) buf[0] = c;
+            n = (c!=EOF);
+        }
+        else n = fread(buf, 1, blockSize, fp);
+        p = buf;
+        end = buf + n;
+
+        return n>0;
+    }
+};
+
+
+// always false: note what went wrong at the current place in the text
+static bool textFail(TextInput &in, TextProblem &problem, const char *what, std::string item="")
+{
+    problem.what = what;
+    problem.item = item;
+    problem.found = in.peek();
+    in.lineCol(problem.line, problem.col);
+
+    return false;
+}
+
+
+// scanf("%d") once the white space is skipped: a sign then digits
+static bool textInt(TextInput &in, int &value)
+{
+    long long v;
+    bool neg;
+    int c, digits;
+
+    neg = false;
+    c = in.peek();
+    if (c=='-' || c=='+') {
+        neg = (c=='-');
+        in.next();
+        c = in.peek();
+    }
+
+    v = 0;
+    for (digits=0; c>='0' && c<='9'; digits++) {
+        if (v<=INT_MAX) v = v*10 + (c - '0');
+        in.next();
+        c = in.peek();
+    }
+    if (digits==0 || v>INT_MAX) return false;
+    value = neg ? -v : v;
+
+    return true;
+}
+
+
+// take the next characters if they match word ignoring case
+static bool textWord(TextInput &in, const char *word, std::string &tok)
+{
+    for (; *word; word++) {
+        int c;
+
+        c = in.peek();
+        if (c==EOF || (c | 0x20)!=*word) return false;
+        tok += (char)c;
+        in.next();
+    }
+
+    return true;
+}
+
+
+static const double textPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// mant X 10^e when that can be done exactly: an exact mantissa times an
+// exact power of ten is rounded just once, just as strtod rounds.
+static inline bool textExact(unsigned long long mant, int e, bool neg, double &value)
+{
+    if (mant>(1ULL<<53) || e<-22 || e>22) return false;
+    value = (double)(long long)mant;   // exact and quicker than from unsigned
+    value = (e<0) ? value/textPow10[-e] : value*textPow10[e];
+    value *= neg ? -1.0 : 1.0;         // no branch: the signs are random
+
+    return true;
+}
+
+
+// strtod on the decimal number in [p, end) but with no locale.  false if
+// no characters can be converted.
+static bool textConvert(const char *p, const char *end, double &value)
+{
+#ifdef __cpp_lib_to_chars
+    std::from_chars_result r;
+    const char *q;
+
+    q = (*p=='+') ? p + 1 : p;
+    r = std::from_chars(q, end, value);
+    if (r.ec==std::errc()) return true;
+    if (r.ec!=std::errc::result_out_of_range) return false;
+#endif
+    std::string tok(p, end);
+    char *endp;
+
+    value = strtod(tok.c_str(), &endp);
+
+    return endp!=tok.c_str();
+}
+
+
+static inline bool textLittleEndian()
+{
+    const unsigned int one = 1;
+
+    return *(const unsigned char *)&one==1;
+}
+
+
+// Take a run of digits adding them to mant and counting them in digits
+// (mant is only right while there are 19 or fewer).  Eight characters at
+// a time are checked and converted as one 64 bit word with no branch per
+// character, which matters since the lengths of numbers vary.
+static inline const char *textDigits(const char *q, const char *end, unsigned long long &mant, int &digits)
+{
+    static const unsigned long long pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+
+    while (end - q>=8 && textLittleEndian()) {
+        unsigned long long v, non, low;
+        int k;
+
+        memcpy(&v, q, 8);
+        v ^= 0x3030303030303030ULL;        // digits are now bytes 0 to 9
+        non = (((v & 0x7f7f7f7f7f7f7f7fULL) + 0x7676767676767676ULL) | v) & 0x8080808080808080ULL;
+        if (non==0) k = 8;
+        else {
+            low = non & (~non + 1);       // top bit of the first byte not a digit
+            k = (int)(((low >> 7)*0x0001020304050607ULL) >> 56);
+        }
+        if (k>0) {
+            v <<= 8*(8 - k);               // just the digits as the last of 8 (first is lowest)
+            v = v*10 + (v >> 8);
+            v = (((v & 0x000000ff000000ffULL)*(100 + (1000000ULL << 32))) +
+                 (((v >> 16) & 0x000000ff000000ffULL)*(1 + (10000ULL << 32)))) >> 32;
+            mant = mant*pow10[k] + (unsigned int)v;
+            digits += k;
+            q += k;
+        }
+        if (k<8) return q;
+    }
+    for (; q<end && *q>='0' && *q<='9'; q++) {
+        mant = mant*10 + (*q - '0');
+        digits++;
+    }
+
+    return q;
+}
+
+
+// The usual case of textNumber below: an optional sign, digits with a
+// decimal point in them and an exponent, all in the text in hand.  The
+// answer is just after the number or NULL if textNumber must do it.
+static inline const char *textPlainNumber(const char *p, const char *end, double &value)
+{
+    unsigned long long mant;
+    const char *q, *start;
+    int digits, fracDigits, exp;
+    bool neg, negExp;
+
+    neg = (*p=='-');
+    q = p + (neg | (*p=='+'));
+    if (q+1>=end || (q[0]=='0' && (q[1] | 0x20)=='x')) return NULL;
+
+    // mantissa (leading zeros are counted as digits too which is safe)
+    start = q;
+    mant = 0;
+    digits = fracDigits = 0;
+    q = textDigits(q, end, mant, digits);
+    if (q<end && *q=='.') {
+        fracDigits = digits;
+        q = textDigits(q + 1, end, mant, digits);
+        fracDigits = digits - fracDigits;
+        if (q-start==1) return NULL;     // just a point
+    }
+    else if (q==start) return NULL;
+    if (digits>19) return NULL;
+
+    // exponent
+    exp = 0;
+    negExp = false;
+    if (q<end && (*q | 0x20)=='e') {
+        q++;
+        if (q<end && (*q=='-' || *q=='+')) {
+            negExp = (*q=='-');
+            q++;
+        }
+        if (q>=end || *q<'0' || *q>'9') return NULL;
+        for (; q<end && *q>='0' && *q<='9'; q++) {
+            if (exp<100000) exp = exp*10 + (*q - '0');
+        }
+    }
+    if (q>=end) return NULL;          // it may go on in the next block
+
+    if (mant==0) value = neg ? -0.0 : 0.0;
+    else if (!textExact(mant, (negExp ? -exp : exp) - fracDigits, neg, value)) {
+        if (!textConvert(p, q, value)) return NULL;
+    }
+
+    return q;
+}
+
+
+// scanf("%lf") once the white space is skipped.  The characters are taken
+// by the rules glibc's scanf uses and the value is what strtod gives for
+// them.  tok is scratch space.  false if it is not a number.
+static bool textNumber(TextInput &in, double &value, std::string &tok)
+{
+    unsigned long long mant;
+    int c, digits, fracDigits, exp;
+    bool neg, negExp, gotDigit, gotDot, gotE, hex, fast;
+    char expChar;
+    const char *q;
+    char *endp;
+
+    q = textPlainNumber(in.at(), in.atEnd(), value);
+    if (q!=NULL) {
+        in.skipTo(q);
+        return true;
+    }
+
+    tok.clear();
+    neg = negExp = gotDigit = gotDot = gotE = hex = false;
+    fast = true;
+    mant = 0;
+    digits = fracDigits = exp = 0;
+    expChar = 'e';
+
+    c = in.peek();
+    if (c=='-' || c=='+') {
+        neg = (c=='-');
+        tok += (char)c;
+        in.next();
+        if ((c = in.peek())==EOF) return false;
+    }
+
+    // "nan", "inf" and "infinity" in any case
+    if ((c | 0x20)=='n' || (c | 0x20)=='i') {
+        if ((c | 0x20)=='n') {
+            if (!textWord(in, "nan", tok)) return false;
+        }
+        else {
+            if (!textWord(in, "inf", tok)) return false;
+            c = in.peek();
+            if (c!=EOF && (c | 0x20)=='i' && !textWord(in, "inity", tok)) return false;
+        }
+        value = strtod(tok.c_str(), &endp);
+
+        return true;
+    }
+
+    // hex numbers start 0x
+    if (c=='0') {
+        tok += (char)c;
+        in.next();
+        c = in.peek();
+        if (c!=EOF && (c | 0x20)=='x') {
+            tok += (char)c;
+            in.next();
+            c = in.peek();
+            hex = true;
+            expChar = 'p';
+        }
+        else gotDigit = true;
+    }
+
+    while (c!=EOF) {
+        if (c>='0' && c<='9') {
+            if (hex) {}
+            else if (gotE) {
+                if (exp<100000) exp = exp*10 + (c - '0');
+            }
+            else if (digits==0 && c=='0') {
+                if (gotDot) fracDigits++;          // leading zeros
+            }
+            else if (digits<19) {
+                mant = mant*10 + (c - '0');
+                digits++;
+                if (gotDot) fracDigits++;
+            }
+            else fast = false;
+            gotDigit = true;
+        }
+        else if (hex && !gotE && ((c | 0x20)>='a' && (c | 0x20)<='f')) {
+            gotDigit = true;
+        }
+        else if (gotE && tok[tok.length()-1]==expChar && (c=='-' || c=='+')) {
+            negExp = (c=='-');
+        }
+        else if (gotDigit && !gotE && (c | 0x20)==expChar) {
+            c = expChar;
+            gotE = gotDot = true;
+        }
+        else if (!gotDot && c=='.') {
+            gotDot = true;
+        }
+        else break;
+
+        tok += (char)c;
+        in.next();
+        c = in.peek();
+    }
+    if (tok.length()==0 || (hex && (int)tok.length()==2 + (tok[0]=='-' || tok[0]=='+'))) return false;   // nothing after 0x
+
+    if (!hex) {
+        int e;
+
+        if (!gotDigit) return false;
+        e = (negExp ? -exp : exp) - fracDigits;
+        if (digits==0) {
+            value = neg ? -0.0 : 0.0;
+            return true;
+        }
+        if (fast && textExact(mant, e, neg, value)) return true;
+
+        return textConvert(tok.c_str(), tok.c_str() + tok.length(), value);
+    }
+
+    value = strtod(tok.c_str(), &endp);
+
+    return endp!=tok.c_str();
+}
+
+
+// a label: anything up to white space
+static char *textLabel(TextInput &in, std::string &tok)
+{
+    char *label;
+    int c;
+
+    tok.clear();
+    while ((c = in.peek())!=EOF && !textSpace(c)) {
+        tok += (char)c;
+        in.next();
+    }
+    label = new char [tok.length() + 1];
+    strcpy(label, tok.c_str());
+
+    return label;
+}
+
+
+// the number of rows and columns
+static bool textSize(TextInput &in, int &r, int &c, TextProblem &problem)
+{
+    if (!in.skipSpace()) return textFail(in, problem, "end of file was found", "the number of rows");
+    if (!textInt(in, r)) return textFail(in, problem, "not a valid integer", "the number of rows");
+    if (!in.skipSpace()) return textFail(in, problem, "end of file was found", "the number of columns");
+    if (!textInt(in, c)) return textFail(in, problem, "not a valid integer", "the number of columns");
+    if (r<=0 || c<=0) return textFail(in, problem, "the number of rows and columns must be positive");
+
+    return true;
+}
+
+
+// "element [r, c]"
+static std::string textElement(long long i, int maxc)
+{
+    char buffer[64];
+
+    sprintf(buffer, "element [%lld, %lld]", i/maxc, i%maxc);
+
+    return buffer;
+}
+
+
+// the elements one after the other.  firstRow is the row in the whole
+// matrix of row 0 of m (for the problem).
+template <class T>
+static bool textElements(TextInput &in, T **m, int maxr, int maxc, char **label, TextProblem &problem, int firstRow=0)
+{
+    std::string tok;
+    double x;
+
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) {
+            if (!in.skipSpace()) return textFail(in, problem, "end of file was found", textElement((long long)(firstRow + r)*maxc + c, maxc));
+            if (label!=NULL && c==0) {
+                label[r] = textLabel(in, tok);
+                m[r][c] = r;   // effectively numeric pointer to the label
+            }
+            else {
+                if (!textNumber(in, x, tok)) return textFail(in, problem, "invalid number", textElement((long long)(firstRow + r)*maxc + c, maxc));
+                m[r][c] = x;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// The elements of an unlabeled matrix in text[from, n) parsed by all the
+// threads.  No number spans a line end so each piece of the text cut at
+// line ends is parsed on its own, counting the numbers.  The pieces are
+// then put in order, which also says where the matrix ends (end).
+template <class T>
+static bool textElementsParallel(const char *text, size_t from, size_t n, T **m, int maxr, int maxc,
+                                 size_t &end, TextProblem &problem)
+{
+    struct Piece {
+        size_t from, to;             // the text
+        std::vector<double> x;       // the numbers in it (up to the first bad one)
+        bool bad;                    // it has a bad number after x
+        TextProblem problem;
+        long long first;             // index of the element x[0] is
+        size_t used;                 // how many of x are in the matrix
+    };
+    const long long need = (long long)maxr*maxc;
+    std::vector<Piece> piece(matPool.threads()*4);
+    int pieces, last;
+    long long done;
+
+    // cut the text at line ends
+    pieces = piece.size();
+    for (int i=0; i<pieces; i++) {
+        size_t cut;
+
+        piece[i].from = (i==0) ? from : piece[i-1].to;
+        cut = from + (n - from)*(i + 1)/pieces;
+        if (cut<piece[i].from) cut = piece[i].from;
+        while (cut<n && text[cut-1]!='\n') cut++;
+        piece[i].to = (i==pieces-1) ? n : cut;
+        piece[i].bad = false;
+    }
+
+    matPool.run(pieces, [&](int i) {
+        Piece &p = piece[i];
+        TextInput in(text, p.from, p.to);
+        std::string tok;
+        double x;
+
+        while ((long long)p.x.size()<need && in.skipSpace()) {
+            if (!textNumber(in, x, tok)) {
+                textFail(in, p.problem, "invalid number");
+                p.bad = true;
+                break;
+            }
+            p.x.push_back(x);
+        }
+    });
+
+    // put the pieces in order
+    done = 0;
+    last = -1;
+    for (int i=0; i<pieces && last<0; i++) {
+        Piece &p = piece[i];
+
+        p.first = done;
+        p.used = std::min((long long)p.x.size(), need - done);
+        done += p.used;
+        if (done==need) last = i;
+        else if (p.bad) {
+            problem = p.problem;
+            problem.item = textElement(done, maxc);
+            return false;
+        }
+    }
+    if (last<0) {
+        TextInput in(text, n, n);
+
+        return textFail(in, problem, "end of file was found", textElement(done, maxc));
+    }
+
+    matPool.run(last + 1, [&](int i) {
+        Piece &p = piece[i];
+
+        for (size_t k=0; k<p.used; k++) {
+            long long e = p.first + k;
+
+            m[e/maxc][e%maxc] = p.x[k];
+        }
+    });
+
+    // find the end of the last element used
+    {
+        TextInput in(text, piece[last].from, piece[last].to);
+        std::string tok;
+        double x;
+
+        for (size_t k=0; k<piece[last].used; k++) {
+            in.skipSpace();
+            textNumber(in, x, tok);
+        }
+        end = in.where();
+    }
+
+    return true;
+}
+
+
+// The file position or -1 if the file cannot be repositioned (a pipe or
+// a terminal).  On Windows a text mode file changes line ends as it is
+// read so offsets into what was read are not file positions: -1 there too
+// and the file is read a character at a time.
+#ifdef WINDOWS
+static long long textTell(FILE *fp) { return -1; }
+static void textSeek(FILE *fp, long long pos) {}
+static long long textLeft(FILE *fp, long long pos) { return 0; }
+#else
+static long long textTell(FILE *fp)
+{
+    long long pos;
+
+    pos = ftello(fp);
+    if (pos<0 || fseeko(fp, pos, SEEK_SET)!=0) return -1;
+
+    return pos;
+}
+
+
+static void textSeek(FILE *fp, long long pos)
+{
+    fseeko(fp, pos, SEEK_SET);
+}
+
+
+// bytes from pos to the end of the file (and leave the file at pos)
+static long long textLeft(FILE *fp, long long pos)
+{
+    long long n;
+
+    n = (fseeko(fp, 0, SEEK_END)==0) ? ftello(fp) - pos : 0;
+    fseeko(fp, pos, SEEK_SET);
+
+    return n;
+}
+#endif
+
+
+// the number of lines and the column at pos in a file that can be repositioned
+static void textPrefix(FILE *fp, long long pos, long long &lines, long long &col)
+{
+    TextInput in(fp, textBlock);
+
+    textSeek(fp, 0);
+    lines = col = 0;
+    while (in.where()<pos && in.peek()!=EOF) in.next();
+    in.lineCol(lines, col);
+    lines--;
+    col--;
+}
+
+
+// Read a matrix in the text form from fp.  If labels isn't NULL the first
+// column is a label for the row: the labels are returned in *labels and
+// column 0 holds the index of the row's label.  This is read() for any
+// file except a problem is returned in error as "line L column C: ..."
+// and the answer is false.   The lines count from where the read started
+// unless fp is a file (not a pipe).  After a problem the position in fp
+// is undefined.
+template <class T>
+bool MatrixT<T>::readText(FILE *fp, std::string &error, char ***labels)
+{
+    ProfileScope prof("readText", name);
+
+    TextInput *in;
+    TextProblem problem;
+    long long start, size;
+    char *text;
+    char **label;
+    bool parallel, ok;
+    int r, c;
+
+    // a big unlabeled matrix in a file is read whole and parsed in parallel
+    start = textTell(fp);
+    size = (start>=0 && labels==NULL && numThreads()>1) ? textLeft(fp, start) : 0;
+    parallel = (size>=parallelTextBytes);
+
+    text = NULL;
+    if (parallel) {
+        text = new char [size];
+        size = fread(text, 1, size, fp);
+        in = new TextInput(text, 0, size);
+    }
+    else in = new TextInput(fp, (start>=0) ? textBlock : 1);
+
+    label = NULL;
+    ok = textSize(*in, r, c, problem);
+    if (ok) {
+        if (maxr!=r || maxc!=c) {
+            reallocate(r, c, name);
+        }
+        if (labels!=NULL) {
+            label = new char * [r];
+            for (int i=0; i<r; i++) label[i] = NULL;
+        }
+
+        if (parallel) {
+            size_t end = 0;
+
+            ok = textElementsParallel(text, in->where(), size, m, maxr, maxc, end, problem);
+            if (ok) textSeek(fp, start + end);
+        }
+        else {
+            ok = textElements(*in, m, maxr, maxc, label, problem);
+            if (ok) {
+                if (start>=0) textSeek(fp, start + in->where());
+                else in->unread();
+            }
+        }
+    }
+    delete in;
+    delete [] text;
+
+    if (!ok) {
+        char buffer[256];
+
+        if (start>0) {
+            long long lines, col;
+
+            textPrefix(fp, start, lines, col);
+            if (problem.line==1) problem.col += col;
+            problem.line += lines;
+        }
+        sprintf(buffer, "line %lld column %lld: %s", problem.line, problem.col, problem.what);
+        error = buffer;
+        if (problem.item.length()>0) error += " when reading " + problem.item;
+        if (name.length()>0) error += " of matrix named \"" + name + "\"";
+        if (problem.found!=EOF && problem.found>' ' && problem.found<127) {
+            sprintf(buffer, ".  Found '%c'", problem.found);
+            error += buffer;
+        }
+
+        if (label!=NULL) {
+            for (int i=0; i<r; i++) delete [] label[i];
+            delete [] label;
+        }
+        defined = false;
+
+        return false;
+    }
+
+    if (labels!=NULL) *labels = label;
+    defined = true;
+
+    return true;
+}
+
+
+// readText from the named file
+template <class T>
+bool MatrixT<T>::readText(std::string filename, std::string &error, char ***labels)
+{
+    FILE *fp;
+    bool ok;
+
+    fp = fopen(filename.c_str(), "r");
+    if (fp==NULL) {
+        error = "unable to open file \"" + filename + "\"";
+        return false;
+    }
+    ok = readText(fp, error, labels);
+    fclose(fp);
+
+    return ok;
+}
+
+
+// read a matrix in.
+// first two numbers are the number of rows and columns.
+// then the matrix values by row.
+// will deallocate old array if different size.
+template <class T>
+void MatrixT<T>::read()
+{
+    std::string error;
+
+    if (!readText(stdin, error)) {
+        printf("ERROR(read): %s\n", error.c_str());
+        exit(1);
+    }
+}
+
+
+// read a matrix whose first column is a label for the row.
+// The labels are returned and column 0 holds the index of the row's label.
+template <class T>
+char **MatrixT<T>::readLabeledRow()
+{
+    std::string error;
+    char **labels;
+
+    if (!readText(stdin, error, &labels)) {
+        printf("ERROR(read): %s\n", error.c_str());
+        exit(1);
+    }
+
+    return labels;
+}
+
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Binary matrix files
+//
+// Reading the text form costs a scanf per element.  The binary form holds
+// the elements just as they sit in memory so readBinary is one fread per
+// row and mapBinary maps the file and points the rows straight into it.
+//
+// Layout (numbers are in the byte order of the machine that wrote it):
+//
+//   header     64 bytes (MatFileHeader below)
+//   labels     labelBytes bytes: one NUL terminated string per row (optional)
+//   padding    zeros up to dataOffset which is a multiple of 64
+//   elements   rows X stride elements, each row padded with zeros to stride
+//
+// The stride is the one allocate() uses so mapped rows are aligned just
+// like rows in memory.
+//
+
+struct MatFileHeader {
+    char magic[4];               // "MATB"
+    unsigned int endian;         // matFileEndian in the byte order of the writer
+    unsigned int version;        // matFileVersion
+    unsigned int elementBytes;   // the dtype: 4 for float, 8 for double
+    long long rows, cols;
+    long long stride;            // elements from the start of one row to the next
+    long long labelBytes;        // 0 if there are no labels
+    long long dataOffset;        // file offset of the first row
+    long long reserved;          // 0
+};
+
+static const unsigned int matFileEndian = 0x01020304;
+static const unsigned int matFileVersion = 1;
+
+
+// map a whole file copy on write: the matrix can be changed but the file
+// never is and a page is only copied if it is written.  NULL if it fails.
+static void *mapFile(const char *filename, size_t &bytes)
+{
+#ifdef WINDOWS
+    HANDLE file, map;
+    LARGE_INTEGER size;
+    void *p;
+
+    file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file==INVALID_HANDLE_VALUE) return NULL;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart==0) {
+        CloseHandle(file);
+        return NULL;
+    }
+    map = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (map==NULL) return NULL;
+    p = MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(map);                // the view keeps the mapping alive
+    bytes = (size_t)size.QuadPart;
+
+    return p;
+#else
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = open(filename, O_RDONLY);
+    if (fd<0) return NULL;
+    if (fstat(fd, &st)!=0 || st.st_size==0) {
+        close(fd);
+        return NULL;
+    }
+    bytes = (size_t)st.st_size;
+    p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);                       // the mapping keeps the file open
+
+    return (p==MAP_FAILED) ? NULL : p;
+#endif
+}
+
+
+static void unmapFile(void *p, size_t bytes)
+{
+#ifdef WINDOWS
+    UnmapViewOfFile(p);
+#else
+    munmap(p, bytes);
+#endif
+}
+
+
+// exit with an error unless h is the header of a matrix file this machine
+// can read and everything it describes fits in fileBytes
+static void checkHeader(const MatFileHeader &h, double fileBytes, const char *caller, const std::string &filename)
+{
+    const char *problem = NULL;
+
+    if (memcmp(h.magic, "MATB", 4)!=0) problem = "is not a binary matrix file";
+    else if (h.endian!=matFileEndian) problem = "was written on a machine with the other byte order";
+    else if (h.version!=matFileVersion) problem = "has a version this library does not know";
+    else if (h.elementBytes!=sizeof(float) && h.elementBytes!=sizeof(double)) problem = "has an unknown element type";
+    else if (h.rows<0 || h.cols<0 || h.rows>INT_MAX || h.stride>INT_MAX || h.stride<h.cols) problem = "has a bad size";
+    else if (h.labelBytes<0 || h.dataOffset<(long long)sizeof(MatFileHeader)+h.labelBytes ||
+             h.dataOffset%h.elementBytes!=0) problem = "has a bad layout";
+    else if ((double)h.dataOffset + (double)h.rows*h.stride*h.elementBytes > fileBytes) problem = "is too short";
+
+    if (problem!=NULL) {
+        printf("ERROR(%s): file \"%s\" %s\n", caller, filename.c_str(), problem);
+        exit(1);
+    }
+}
+
+
+// copy the row labels in a file into a new array of new strings
+static char **copyLabels(const char *p, long long bytes, int rows, const char *caller, const std::string &filename)
+{
+    const char *end = p + bytes;
+    char **label;
+
+    if (bytes==0) return NULL;
+
+    label = new char * [rows];
+    for (int r=0; r<rows; r++) {
+        const char *eos = (const char *)memchr(p, '\0', end-p);
+
+        if (eos==NULL) {
+            printf("ERROR(%s): file \"%s\" has fewer labels than rows\n", caller, filename.c_str());
+            exit(1);
+        }
+        label[r] = new char [eos-p+1];
+        memcpy(label[r], p, eos-p+1);
+        p = eos+1;
+    }
+
+    return label;
+}
+
+
+// write matrix with optional labels (one per row) in the binary form
+template <class T>
+void MatrixT<T>::writeBinary(std::string filename, char **labels) const
+{
+    ProfileScope prof("writeBinary", name);
+
+    const int align = matAlign/sizeof(T);
+    char zeros[matAlign];
+    MatFileHeader h;
+    FILE *OUT;
+
+    assertDefined("writeBinary");
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "MATB", 4);
+    h.endian = matFileEndian;
+    h.version = matFileVersion;
+    h.elementBytes = sizeof(T);
+    h.rows = maxr;
+    h.cols = maxc;
+    h.stride = (maxc + align - 1)/align*align;
+    if (labels!=NULL) {
+        for (int r=0; r<maxr; r++) h.labelBytes += strlen(labels[r]) + 1;
+    }
+    h.dataOffset = (sizeof(h) + h.labelBytes + matAlign - 1)/matAlign*matAlign;
+
+    OUT = fopen(filename.c_str(), "wb");
+    if (OUT==NULL) {
+        printf("ERROR(writeBinary): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+
+    memset(zeros, 0, sizeof(zeros));
+    fwrite(&h, sizeof(h), 1, OUT);
+    if (labels!=NULL) {
+        for (int r=0; r<maxr; r++) fwrite(labels[r], 1, strlen(labels[r]) + 1, OUT);
+    }
+    fwrite(zeros, 1, h.dataOffset - sizeof(h) - h.labelBytes, OUT);
+    for (int r=0; r<maxr; r++) {
+        fwrite(m[r], sizeof(T), maxc, OUT);
+        fwrite(zeros, sizeof(T), h.stride - maxc, OUT);
+    }
+
+    if (ferror(OUT) || fclose(OUT)!=0) {
+        printf("ERROR(writeBinary): Writing file \"%s\" failed.\n", filename.c_str());
+        exit(1);
+    }
+}
+
+
+// read a binary matrix file into self converting the elements if the
+// file has the other element type.  Returns the labels or NULL if none.
+template <class T>
+char **MatrixT<T>::readBinary(std::string filename)
+{
+    ProfileScope prof("readBinary", name);
+
+    MatFileHeader h;
+    FILE *IN;
+    char *row, **label;
+    double fileBytes;
+
+    IN = fopen(filename.c_str(), "rb");
+    if (IN==NULL) {
+        printf("ERROR(readBinary): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+    fseek(IN, 0, SEEK_END);
+    fileBytes = ftell(IN);
+    fseek(IN, 0, SEEK_SET);
+
+    if (fread(&h, sizeof(h), 1, IN)!=1) memset(&h, 0, sizeof(h));
+    checkHeader(h, fileBytes, "readBinary", filename);
+
+    row = new char [h.labelBytes>h.stride*h.elementBytes ? h.labelBytes : h.stride*h.elementBytes];
+
+    label = NULL;
+    if (h.labelBytes>0) {
+        if (fread(row, 1, h.labelBytes, IN)!=(size_t)h.labelBytes) h.labelBytes = 0;
+        label = copyLabels(row, h.labelBytes, h.rows, "readBinary", filename);
+    }
+
+    if (maxr!=h.rows || maxc!=h.cols) {
+        reallocate(h.rows, h.cols, name);
+    }
+
+    fseek(IN, h.dataOffset, SEEK_SET);
+    for (int r=0; r<maxr; r++) {
+        if (fread(row, h.elementBytes, h.stride, IN)!=(size_t)h.stride) {
+            printf("ERROR(readBinary): file \"%s\" ended in row %d\n", filename.c_str(), r);
+            exit(1);
+        }
+        if (h.elementBytes==sizeof(float)) {
+            const float *x = (const float *)row;
+
+            for (int c=0; c<maxc; c++) m[r][c] = x[c];
+        }
+        else {
+            const double *x = (const double *)row;
+
+            for (int c=0; c<maxc; c++) m[r][c] = x[c];
+        }
+    }
+
+    delete [] row;
+    fclose(IN);
+    defined = true;
+
+    return label;
+}
+
+
+// map a binary matrix file into self.  The rows point straight into the
+// file so nothing is read until it is used.  Changes to self are not
+// written back to the file.  Returns the labels or NULL if none.
+template <class T>
+char **MatrixT<T>::mapBinary(std::string filename)
+{
+    ProfileScope prof("mapBinary", name);
+
+    MatFileHeader h;
+    size_t bytes;
+    char *p;
+
+    p = (char *)mapFile(filename.c_str(), bytes);
+    if (p==NULL) {
+        printf("ERROR(mapBinary): Trying to map file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+
+    if (bytes<sizeof(h)) memset(&h, 0, sizeof(h));
+    else memcpy(&h, p, sizeof(h));
+    checkHeader(h, bytes, "mapBinary", filename);
+    if (h.elementBytes!=sizeof(T)) {
+        printf("ERROR(mapBinary): file \"%s\" holds %s but the matrix holds %s.  Use readBinary to convert.\n",
+               filename.c_str(), h.elementBytes==sizeof(float) ? "floats" : "doubles",
+               sizeof(T)==sizeof(float) ? "floats" : "doubles");
+        exit(1);
+    }
+
+    deallocate();
+    maxr = h.rows;
+    maxc = h.cols;
+    stride = h.stride;
+    data = (T *)(p + h.dataOffset);
+    m = new T * [maxr];
+    for (int i=0; i<maxr; i++) m[i] = data + (size_t)i*stride;
+    mapping = p;
+    mappingBytes = bytes;
+    defined = true;
+    if (debug) printf("DEBUG(       map): name \"%s\", size %d X %d\n", name.c_str(), maxr, maxc);
+
+    return copyLabels(p + sizeof(h), h.labelBytes, maxr, "mapBinary", filename);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Streaming the rows of a matrix file
+//
+// A MatrixRowStream gets its blocks from a MatrixStreamReader which reads
+// them on its own thread into two buffers: block k always goes in buffer
+// k%2 so the next block is read while the stream uses the one before.
+// A binary file with the element type of the matrix is read straight into
+// the buffer with one fread per block.
+//
+
+// seek and size for files that may be bigger than a long
+#ifdef WINDOWS
+static void streamSeek(FILE *fp, long long pos)
+{
+    _fseeki64(fp, pos, SEEK_SET);
+}
+
+
+static long long streamSize(FILE *fp)
+{
+    _fseeki64(fp, 0, SEEK_END);
+
+    return _ftelli64(fp);
+}
+#else
+static void streamSeek(FILE *fp, long long pos)
+{
+    fseeko(fp, pos, SEEK_SET);
+}
+
+
+static long long streamSize(FILE *fp)
+{
+    fseeko(fp, 0, SEEK_END);
+
+    return ftello(fp);
+}
+#endif
+
+
+template <class T>
+class MatrixStreamReader {
+public:
+    int rows, cols;              // size of the matrix in the file
+
+    MatrixStreamReader(std::string filenamex, int blockRowsx);
+    ~MatrixStreamReader();
+
+    void start();                // (re)start reading at the first row
+    MatrixT<T> *get(int k);      // wait for block k and free the ones before it.  NULL if there is no block k.
+
+private:
+    std::string filename;
+    FILE *fp;
+    bool binary;                 // else text
+    MatFileHeader h;             // the header of a binary file
+    TextInput *text;             // reads a text file
+    char *row;                   // a row of a binary file to be converted
+    int blockRows, numBlocks;
+    MatrixT<T> *buffer[2];
+
+    std::thread thread;
+    std::mutex lock;
+    std::condition_variable changed;
+    int ready;                   // blocks read
+    int released;                // blocks the stream is done with
+    bool stop;                   // the thread must quit
+
+    void run();
+    void halt();
+    void readBlock(MatrixT<T> *b, int k);
+};
+
+
+template <class T>
+MatrixStreamReader<T>::MatrixStreamReader(std::string filenamex, int blockRowsx)
+{
+    char magic[4];
+
+    filename = filenamex;
+    blockRows = blockRowsx;
+    text = NULL;
+    row = NULL;
+    ready = released = 0;
+    stop = false;
+
+    fp = fopen(filename.c_str(), "rb");
+    if (fp==NULL) {
+        printf("ERROR(MatrixRowStream): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+
+    binary = (fread(magic, 1, 4, fp)==4 && memcmp(magic, "MATB", 4)==0);
+    if (binary) {
+        long long fileBytes;
+
+        fileBytes = streamSize(fp);
+        streamSeek(fp, 0);
+        if (fread(&h, sizeof(h), 1, fp)!=1) memset(&h, 0, sizeof(h));
+        checkHeader(h, fileBytes, "MatrixRowStream", filename);
+        rows = h.rows;
+        cols = h.cols;
+        row = new char [h.stride*h.elementBytes];
+    }
+    else {
+        TextProblem problem;
+
+        streamSeek(fp, 0);
+        text = new TextInput(fp, textBlock);
+        if (!textSize(*text, rows, cols, problem)) {
+            printf("ERROR(MatrixRowStream): file \"%s\" line %lld column %lld: %s when reading %s\n",
+                   filename.c_str(), problem.line, problem.col, problem.what, problem.item.c_str());
+            exit(1);
+        }
+    }
+
+    numBlocks = (rows + blockRows - 1)/blockRows;
+    for (int i=0; i<2; i++) {
+        buffer[i] = new MatrixT<T>(std::min(blockRows, rows>0 ? rows : 1), cols>0 ? cols : 1, "buffer of " + filename);
+    }
+}
+
+
+template <class T>
+MatrixStreamReader<T>::~MatrixStreamReader()
+{
+    halt();
+    for (int i=0; i<2; i++) delete buffer[i];
+    delete text;
+    delete [] row;
+    fclose(fp);
+}
+
+
+// stop the thread if it is running
+template <class T>
+void MatrixStreamReader<T>::halt()
+{
+    if (thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            stop = true;
+        }
+        changed.notify_all();
+        thread.join();
+    }
+}
+
+
+template <class T>
+void MatrixStreamReader<T>::start()
+{
+    halt();
+
+    if (binary) streamSeek(fp, h.dataOffset);
+    else {
+        TextProblem problem;
+        int r, c;
+
+        delete text;
+        streamSeek(fp, 0);
+        text = new TextInput(fp, textBlock);
+        textSize(*text, r, c, problem);
+    }
+
+    ready = released = 0;
+    stop = false;
+    thread = std::thread(&MatrixStreamReader<T>::run, this);
+}
+
+
+// the thread: read each block once the buffer it goes in is free
+template <class T>
+void MatrixStreamReader<T>::run()
+{
+    for (int k=0; k<numBlocks; k++) {
+        {
+            std::unique_lock<std::mutex> hold(lock);
+
+            changed.wait(hold, [&] { return stop || k<released+2; });
+            if (stop) return;
+        }
+
+        readBlock(buffer[k%2], k);
+
+        {
+            std::lock_guard<std::mutex> hold(lock);
+            ready = k+1;
+        }
+        changed.notify_all();
+    }
+}
+
+
+template <class T>
+MatrixT<T> *MatrixStreamReader<T>::get(int k)
+{
+    std::unique_lock<std::mutex> hold(lock);
+
+    released = k;
+    changed.notify_all();
+    if (k>=numBlocks) return NULL;
+    changed.wait(hold, [&] { return ready>k; });
+
+    return buffer[k%2];
+}
+
+
+// read block k into b
+template <class T>
+void MatrixStreamReader<T>::readBlock(MatrixT<T> *b, int k)
+{
+    int n;
+
+    n = std::min(blockRows, rows - k*blockRows);
+
+    if (binary) {
+        // the same layout as the buffer: read it straight in
+        if (h.elementBytes==sizeof(T) && b->data!=NULL && b->stride==h.stride) {
+            if (fread(b->data, h.stride*sizeof(T), n, fp)==(size_t)n) return;
+            n = 0;
+        }
+
+        for (int r=0; r<n; r++) {
+            if (fread(row, h.elementBytes, h.stride, fp)!=(size_t)h.stride) {
+                n = r;
+                break;
+            }
+            if (h.elementBytes==sizeof(float)) {
+                const float *x = (const float *)row;
+
+                for (int c=0; c<cols; c++) b->m[r][c] = x[c];
+            }
+            else {
+                const double *x = (const double *)row;
+
+                for (int c=0; c<cols; c++) b->m[r][c] = x[c];
+            }
+        }
+        if (n<std::min(blockRows, rows - k*blockRows)) {
+            printf("ERROR(MatrixRowStream): file \"%s\" ended in row %d\n", filename.c_str(), k*blockRows + n);
+            exit(1);
+        }
+    }
+    else {
+        TextProblem problem;
+
+        if (!textElements(*text, b->m, n, cols, (char **)NULL, problem, k*blockRows)) {
+            printf("ERROR(MatrixRowStream): file \"%s\" line %lld column %lld: %s when reading %s",
+                   filename.c_str(), problem.line, problem.col, problem.what, problem.item.c_str());
+            if (problem.found!=EOF && problem.found>' ' && problem.found<127) printf(".  Found '%c'", problem.found);
+            printf("\n");
+            exit(1);
+        }
+    }
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// class MatrixRowStream
+//
+
+// open the file and start reading the first block
+template <class T>
+MatrixRowStreamT<T>::MatrixRowStreamT(std::string filename, int blockRowsx)
+{
+    if (blockRowsx<1) {
+        printf("ERROR(MatrixRowStream): blocks of %d rows for file \"%s\"\n", blockRowsx, filename.c_str());
+        exit(1);
+    }
+
+    blockRows = blockRowsx;
+    reader = new MatrixStreamReader<T>(filename, blockRows);
+    maxr = reader->rows;
+    maxc = reader->cols;
+    block = new MatrixT<T>(blockRows, "block of " + filename);   // allocate as subMatrix!
+    block->maxc = maxc;
+    arow = new MatrixT<T>(1, "row of " + filename);             // allocate as subMatrix!
+    arow->maxc = maxc;
+    k = r = 0;
+    more = false;
+
+    reader->start();
+    fresh = true;
+}
+
+
+template <class T>
+MatrixRowStreamT<T>::~MatrixRowStreamT()
+{
+    delete arow;
+    delete block;
+    delete reader;
+}
+
+
+// point block at block k of the reader
+template <class T>
+void MatrixRowStreamT<T>::takeBlock()
+{
+    MatrixT<T> *b;
+
+    fresh = false;
+    b = reader->get(k);
+    more = (b!=NULL);
+    if (!more) return;
+
+    block->maxr = std::min(blockRows, maxr - k*blockRows);
+    for (int i=0; i<block->maxr; i++) block->m[i] = b->m[i];   // DANGER: we are copying pointers into other Matrix!!!
+    block->data = b->data;
+    block->stride = b->stride;
+    block->defined = true;
+}
+
+
+// point arow at row r of block
+template <class T>
+void MatrixRowStreamT<T>::pointRow()
+{
+    arow->m[0] = block->m[r];
+    arow->data = (block->data!=NULL) ? block->m[r] : NULL;
+    arow->stride = block->stride;
+    arow->defined = true;
+}
+
+
+template <class T>
+MatrixT<T> *MatrixRowStreamT<T>::blockBegin()
+{
+    if (!fresh) reader->start();
+    k = r = 0;
+    takeBlock();
+
+    return block;
+}
+
+
+template <class T>
+MatrixT<T> *MatrixRowStreamT<T>::blockNext()
+{
+    if (more) {
+        k++;
+        r = 0;
+        takeBlock();
+    }
+
+    return block;
+}
+
+
+template <class T>
+bool MatrixRowStreamT<T>::blockNotEnd()
+{
+    return more;
+}
+
+
+template <class T>
+int MatrixRowStreamT<T>::blockRow()
+{
+    return k*blockRows;
+}
+
+
+template <class T>
+MatrixT<T> *MatrixRowStreamT<T>::rowBegin()
+{
+    blockBegin();
+    if (more) pointRow();
+
+    return arow;
+}
+
+
+template <class T>
+MatrixT<T> *MatrixRowStreamT<T>::rowNext()
+{
+    if (more) {
+        if (r < block->maxr-1) r++;
+        else blockNext();
+        if (more) pointRow();
+    }
+
+    return arow;
+}
+
+
+template <class T>
+bool MatrixRowStreamT<T>::rowNotEnd()
+{
+    return more;
+}
+
+
+template <class T>
+int MatrixRowStreamT<T>::row()
+{
+    return k*blockRows + r;
+}
+
+
+// The reductions add up each column in the order of the rows just as
+// the Matrix routines do so meanVec and stddevVec give the same answers
+// (stddevVec as Matrix::stddevVec when columnStats splits the columns).
+// cov merges the blocks of the stream so it agrees to rounding.
+
+// the sum of each column
+template <class T>
+void MatrixRowStreamT<T>::columnSums(double *sum)
+{
+    for (int c=0; c<maxc; c++) sum[c] = 0;
+    for (MatrixT<T> *b = blockBegin(); blockNotEnd(); b = blockNext()) {
+        T **m = b->m;
+        int n = b->maxr;
+
+        parallelFor(maxc, (double)n*maxc, [&](int lo, int hi) {
+            for (int c=lo; c<hi; c++) {
+                double total = sum[c];
+
+                for (int r=0; r<n; r++) total += m[r][c];
+                sum[c] = total;
+            }
+        });
+    }
+}
+
+
+template <class T>
+MatrixT<T> MatrixRowStreamT<T>::meanVec()
+{
+    double *sum;
+
+    MatrixT<T> mean(1, maxc);
+    sum = new double [maxc];
+    columnSums(sum);
+    for (int c=0; c<maxc; c++) mean.m[0][c] = sum[c]/maxr;
+    mean.defined = true;
+    delete [] sum;
+
+    return mean;
+}
+
+
+// The rows are taken in the same blocks of columnStatsBlockRows as
+// Matrix::columnStats takes them (a block that spans two blocks of the
+// stream is copied) so the answer is that of Matrix::stddevVec.
+template <class T>
+MatrixT<T> MatrixRowStreamT<T>::stddevVec()
+{
+    const int block = columnStatsBlockRows;
+    std::vector<double> stats((size_t)6*maxc);
+    double *sum = &stats[0], *mean = sum + maxc, *m2 = mean + maxc, *min = m2 + maxc, *max = min + maxc, *nonZero = max + maxc;
+    std::vector<T> carry((size_t)block*maxc);   // the rows of a block that spans two blocks of the stream
+    T *carryRows[columnStatsBlockRows];
+    int carried = 0;
+    long long seen = 0;
+
+    auto merge = [&](T *const *rows, int nb) {
+        parallelFor(maxc, 3.0*nb*maxc, [&](int lo, int hi) {
+            std::vector<double> scratch(2*(hi - lo));
+
+            columnStatsBlock(rows, nb, seen, lo, hi, sum, mean, m2, min, max, nonZero, &scratch[0], &scratch[hi - lo]);
+        });
+        seen += nb;
+    };
+
+    for (int i=0; i<block; i++) carryRows[i] = carry.data() + (size_t)i*maxc;
+    for (MatrixT<T> *b = blockBegin(); blockNotEnd(); b = blockNext()) {
+        T **m = b->m;
+        int n = b->maxr;
+
+        for (int r=0; r<n; ) {
+            if (carried==0 && n-r>=block) {
+                merge(m + r, block);
+                r += block;
+            }
+            else {
+                for (int c=0; c<maxc; c++) carryRows[carried][c] = m[r][c];
+                r++;
+                if (++carried==block) {
+                    merge(carryRows, block);
+                    carried = 0;
+                }
+            }
+        }
+    }
+    if (carried>0) merge(carryRows, carried);
+
+    MatrixT<T> stddev(1, maxc);
+    for (int c=0; c<maxc; c++) stddev.m[0][c] = sqrt((T)(m2[c]/maxr));   // the variance rounded to T as columnStats keeps it
+    stddev.defined = true;
+
+    return stddev;
+}
+
+
+// One pass: the blocks go into a CovAccumulator as they are read.
+// WARNING: This is NOT the unbiased covariance in which
+// you divide by (n - 1)!  In this routine we divide by n.
+template <class T>
+MatrixT<T> MatrixRowStreamT<T>::cov()
+{
+    CovAccumulatorT<T> acc(maxc);
+
+    for (MatrixT<T> *b = blockBegin(); blockNotEnd(); b = blockNext()) acc.add(*b);
+
+    return acc.cov();
+}
+
+
+template <class T>
+MatrixT<T> MatrixRowStreamT<T>::minMax()
+{
+    MatrixT<T> minMax(2, maxc, "minMax");
+
+    for (MatrixT<T> *b = blockBegin(); blockNotEnd(); b = blockNext()) {
+        T **m = b->m;
+        int n = b->maxr;
+        bool first = (k==0);
+
+        parallelFor(maxc, 3.0*n*maxc, [&](int lo, int hi) {
+            for (int c=lo; c<hi; c++) {
+                double min, max;
+
+                min = first ? m[0][c] : minMax.m[0][c];
+                max = first ? m[0][c] : minMax.m[1][c];
+                for (int r=0; r<n; r++) {
+                    if (m[r][c] < min) min = m[r][c];
+                    if (m[r][c] > max) max = m[r][c];
+                }
+                minMax.m[0][c] = min;
+                minMax.m[1][c] = max;
+            }
+        });
+    }
+    minMax.defined = true;
+
+    return minMax;
+}
+
+
+
+// tri-diagonalize a symmetric matrix.  The matrix will be destroyed and
+// the diagonal will be returned in d and off diagonal in e.   It uses
+// the Householder transformation
+// WARNING: allocates space
+template <class T>
+void MatrixT<T>::tridiagonalize(double *&d, double *&e)
+{
+    d = new double [maxc];  // the diagonal elements
+    e = new double [maxc];  // the off-diagonal elements
+
+    householder(m, maxc, d, e);
+}
+
+
+// compute the eigenvalues and eigenvectors of a SYMMETRIC matrix
+//
+// input:  A symmetric matrix (WARNING: this fact is NOT verified!)
+//         Input matrix is destroyed.
+// output: Returns a row matrix of eigen values and
+//         transforms the matrix into a matrix of eigenvectors (one vector in each row)
+//         in the same order as the eigenvalues.
+// NOTE: The matrix is NOT the set of eigen vectors in columns!
+// NOTE: The vectors are SORTED by decreasing magnitude of eigenvalue
+// NOTE: The vectors are normalized (norm of each vector is 1)
+// NOTE: The input matrix is destroyed
+
+// WARNING: allocates a row matrix of eigenvalues
+
+// quick insertion sort for the eigen values AND corresponding vectors
+// in decreasing order of MAGNITUDE
+template <class T>
+void isort(T a[], T *b[], int len)
+{
+    for (int i=1; i<len; i++) {
+        T aa, *bb;
+        int j;
+        
+        aa = a[i];
+        bb = b[i];
+        for (j = i-1; (j>=0) && (fabs(a[j])<fabs(aa)); j--) {
+            a[j+1] = a[j];
+            b[j+1] = b[j];
+        }
+        a[j+1] = aa;
+        b[j+1] = bb;
+    }
+}
+
+// Destroys self by replacing self with eigenvectors in rows.
+// Returns a new matrix with the eigenvalues in it.
+// Eigenvalues and vectors returned sorted from largest magnitude to smallest
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::eigenSystem()
+{
+    ProfileScope prof("eigenSystem", name);
+
+    assertDefined("eigenSystem");
+    assertSquare("eigenSystem");
+    
+    MatrixT values(1, maxc);  // allocates space for eigen values
+
+    {
+        double *d, *e;
+
+        tridiagonalize(d, e);         // allocates space for 2 double arrays
+        eigen(d, e, maxc, m);         // returns eigen values in d
+
+        for (int c=0; c<maxc; c++) values.m[0][c] = d[c];   // save the eigen values from above routines
+
+        delete [] d;
+        delete [] e;
+    }
+
+    transposeSelf();              // result was returned in columns so put it in rows
+    isort(values.m[0], m, maxc);  // sort both eigenvalues and vectors in rows so vector with max eigenvalue is first
+    values.defined = true;        // mark eigen value matrix as defined
+
+    return values;
+}
+
+
+// Orthonormalize the b rows of q (each of length n) by modified
+// Gram-Schmidt done twice.  A row that vanishes because the rows were
+// dependent is replaced with a fresh pseudo random row so q always
+// spans b dimensions.  The generator is private so results are repeatable
+// and the caller's random number stream is left alone.
+template <class T>
+static void orthonormalRows(T **q, int b, int n, unsigned long long &seed)
+{
+    for (int i=0; i<b; i++) {
+        for (int tries=0; ; tries++) {
+            double before, after;
+
+            before = 0.0;
+            for (int c=0; c<n; c++) before += double(q[i][c])*q[i][c];
+
+            for (int pass=0; pass<2; pass++) {
+                for (int j=0; j<i; j++) {
+                    double s = 0.0;
+
+                    for (int c=0; c<n; c++) s += double(q[i][c])*q[j][c];
+                    for (int c=0; c<n; c++) q[i][c] -= s*q[j][c];
+                }
+            }
+
+            after = 0.0;
+            for (int c=0; c<n; c++) after += double(q[i][c])*q[i][c];
+
+            if (after > 1e-20*before && after > 0.0) {
+                double scale = 1.0/sqrt(after);
+
+                for (int c=0; c<n; c++) q[i][c] *= scale;
+                break;
+            }
+
+            if (tries > 10) {
+                printf("ERROR(eigenSystemTopK): unable to extend the basis past %d vectors\n", i);
+                exit(1);
+            }
+
+            for (int c=0; c<n; c++) {
+                seed = seed*6364136223846793005ULL + 1442695040888963407ULL;
+                q[i][c] = double(seed>>11)/double(1ULL<<53) - 0.5;
+            }
+        }
+    }
+}
+
+
+// Like eigenSystem() but only the k eigenvalues of largest magnitude and
+// their vectors are found.  Destroys self by replacing self with the k
+// eigenvectors in rows.  Returns a 1 x k matrix of the eigenvalues.  Both
+// are sorted from largest magnitude to smallest just as in eigenSystem().
+//
+// Uses subspace iteration with Rayleigh-Ritz on a block of a few more
+// vectors than k.  Each pass costs one product with self (2 b n^2 flops)
+// instead of the O(n^3) of the full solution.  It stops when every
+// residual |A x - l x| is at most tol times the largest eigenvalue.  If
+// the block is nearly as big as self or the iteration is slow to settle
+// the full eigenSystem() is used and cut down to k.
+// WARNING: allocates new matrix for answer
+template <class T>
+MatrixT<T> MatrixT<T>::eigenSystemTopK(int k, double tol)
+{
+    ProfileScope prof("eigenSystemTopK", name);
+
+    assertDefined("eigenSystemTopK");
+    assertSquare("eigenSystemTopK");
+    if (k<1 || k>maxr) {
+        printf("ERROR(eigenSystemTopK): asked for %d eigenvectors of a %d X %d matrix\n", k, maxr, maxc);
+        exit(1);
+    }
+
+    const int n = maxr;
+    const int b = std::min(n, k + (k/2 > 10 ? k/2 : 10));  // block size with some oversampling
+
+    tol = fmax(tol, 1000.0*std::numeric_limits<T>::epsilon());
+
+    bool converged = false;
+    MatrixT values(1, k);
+    MatrixT vectors(k, n);
+
+    if (2*b < n) {
+        MatrixT q(b, n), z(b, n), x(b, n), h(b, b), s(b, b);
+        double *d, *e;
+        int *order;
+        unsigned long long seed;
+        const int maxIter = 20 + 4*n/b;  // about the cost of the full solution
+
+        d = new double [b];
+        e = new double [b];
+        order = new int [b];
+
+        seed = 0x2545F4914F6CDD1DULL;
+        for (int r=0; r<b; r++) for (int c=0; c<n; c++) q.m[r][c] = 0.0;
+        orthonormalRows(q.m, b, n, seed);   // all zero rows are all replaced with random ones
+
+        for (int iter=0; iter<maxIter; iter++) {
+            // since self is symmetric the rows of z = q self are self times the rows of q
+            product(b, n, n, 1.0, q.m, false, m, false, 0.0, z.m);
+
+            // project self onto the block: h = q self q^T and solve the small problem
+            product(b, b, n, 1.0, z.m, false, q.m, true, 0.0, h.m);
+            for (int r=0; r<b; r++) {
+                for (int c=0; c<r; c++) h.m[r][c] = h.m[c][r] = 0.5*(h.m[r][c] + h.m[c][r]);
+            }
+            householder(h.m, b, d, e);
+            eigen(d, e, b, h.m);      // vectors of h in columns
+
+            for (int i=0; i<b; i++) {
+                int j;
+
+                for (j=i-1; j>=0 && fabs(d[order[j]])<fabs(d[i]); j--) order[j+1] = order[j];
+                order[j+1] = i;
+            }
+
+            // Ritz vectors x = s q and self times them s z, where row i of
+            // s is the column of h for the i-th largest eigenvalue
+            for (int r=0; r<b; r++) for (int c=0; c<b; c++) s.m[r][c] = h.m[c][order[r]];
+            product(b, n, b, 1.0, s.m, false, q.m, false, 0.0, x.m);
+            product(b, n, b, 1.0, s.m, false, z.m, false, 0.0, q.m);
+
+            double worst = 0.0;
+            for (int r=0; r<k; r++) {
+                double lambda = d[order[r]], sum = 0.0;
+
+                for (int c=0; c<n; c++) {
+                    double diff = q.m[r][c] - lambda*x.m[r][c];
+
+                    sum += diff*diff;
+                }
+                worst = fmax(worst, sqrt(sum));
+            }
+
+            if (worst <= tol*fabs(d[order[0]])) {
+                for (int r=0; r<k; r++) {
+                    values.m[0][r] = d[order[r]];
+                    for (int c=0; c<n; c++) vectors.m[r][c] = x.m[r][c];
+                }
+                converged = true;
+                break;
+            }
+
+            orthonormalRows(q.m, b, n, seed);   // the next block spans self times the Ritz vectors
+        }
+
+        delete [] d;
+        delete [] e;
+        delete [] order;
+    }
+
+    if (!converged) {
+        MatrixT all = eigenSystem();
+
+        for (int r=0; r<k; r++) {
+            values.m[0][r] = all.m[0][r];
+            for (int c=0; c<n; c++) vectors.m[r][c] = m[r][c];
+        }
+    }
+
+    values.defined = true;
+    vectors.defined = true;
+    *this = std::move(vectors);
+
+    return values;
+}
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// The following routines are from "Numerical Recipes in C"
+//
+// REF: Eigenvalue solvers, tred2 (householder) and tqli (eigen), from
+// "Numerical Recipes in C" (Cambridge Univ. Press) by W.H. Press,
+// S.A. Teukolsky, W.T. Vetterling, and B.P. Flannery. Translated from
+// 1 based array (originally from FORTRAN) by Robert Heckendorn,
+// University of Idaho
+//
+// Householder reduction of a real, symmetric matrix a[0..n-1][0..n-1] to a
+// symmetric tridiagonal matrix.
+//
+// On output, a is replaced by the orthogonal matrix Q effecting the
+// transformation. d[0..n-1] returns the diagonal elements of the tridiagonal matrix,
+// and e[0..n-1] the off-diagonal elements, with e[0]=0. Several statements, as noted
+// in comments, can be omitted if only eigenvalues are to be found, in which case a
+// contains no useful information on output. Otherwise they are to be included.
+//
+#define SIGN(a, b) ((b) >= 0.0 ? fabs(a) : -fabs(a))
+template <class T>
+static void householder(T **a, int n, double d[], double e[])
+{
+    int l, k, j, i;
+    double scale, hh, h, g, f;
+
+    for (i=n-1; i>=1; i--) {
+        l=i-1;
+        h=scale=0.0;
+        if (l > 0) {
+            for (k=0; k<=l; k++) {
+                scale += fabs(a[i][k]);
+            }
+
+            if (scale == 0.0) {             // Skip transformation.
+                e[i]=a[i][l];
+            }
+            else {
+                for (k=0; k<=l; k++) {
+                    a[i][k] /= scale;       // Use scaled a's for transformation.
+                    h += a[i][k]*a[i][k];   // Form sigma in h.
+                }
+                f=a[i][l];
+                g=(f >= 0.0 ? -sqrt(h) : sqrt(h));
+                e[i]=scale*g;
+                h -= f*g;                   // Now h is equation (11.2.4).
+                a[i][l]=f-g;                // Store u in the ith row of a.
+                f=0.0;
+                for (j=0; j<=l; j++) {
+                    // Next statement can be omitted if eigenvectors not wanted
+                    a[j][i]=a[i][j]/h;      // Store u/H in ith column of a.
+
+                    g=0.0;                  // Form an element of A.u in g.
+                    for (k=0; k<=j; k++) {
+                        g += a[j][k]*a[i][k];
+                    }
+                    for (k=j+1; k<=l; k++) {
+                        g += a[k][j]*a[i][k];
+                    }
+
+                    e[j]=g/h;               // Form element of p in temporarily unused element of e.
+                    f += e[j]*a[i][j];
+                }
+                hh=f/(h+h);                 // Form K, equation (11.2.11).
+
+                // Form q and store in e overwriting p.
+                for (j=0; j<=l; j++) {
+                    f=a[i][j];
+                    e[j]=g=e[j]-hh*f;
+
+                    // Reduce a, equation (11.2.13).
+                    for (k=0; k<=j; k++) {
+                        a[j][k] -= (f*e[k] + g*a[i][k]);
+                    }
+                }
+            }
+        }
+        else {
+            e[i]=a[i][l];
+        }
+        d[i]=h;
+    }
+
+    // Next statement can be omitted if eigenvectors not wanted
+    d[0]=0.0;
+    e[0]=0.0;
+
+    // Contents of this loop can be omitted if eigenvectors not
+    //   wanted except for statement d[i]=a[i][i];
+
+    // Begin accumulation of transformation matrices.
+    for (i=0; i<n; i++) {
+        l=i-1;
+        if (d[i]) {                        // This block skipped when i=0.
+            for (j=0; j<=l; j++) {
+                // Use u and u/H stored in a to form P.Q.
+                g=0.0;
+                for (k=0; k<=l; k++) {
+                    g += a[i][k]*a[k][j];
+                }
+                for (k=0; k<=l; k++) {
+                    a[k][j] -= g*a[k][i];
+                }
+            }
+        }
+        d[i]=a[i][i];                       // This statement remains.
+        a[i][i]=1.0;                        // Reset row and column of a to identity matrix for next iteration.
+        for (j=0; j<=l; j++) {
+            a[j][i]=a[i][j]=0.0;
+        }
+    }
+}
+
+
+// Compute the eigen values and vectors of a symmetric tridiagonal matrix
+//
+// QL algorithm with implicit shifts, to determine the eigenvalues and eigenvectors
+// of a real, symmetric, tridiagonal matrix, or of a real, symmetric matrix
+// previously reduced by householder sec. 11.2. On input, d[0..n-1] contains the diagonal
+// elements of the tridiagonal matrix. On output, it returns the eigenvalues. The
+// vector e[0..n-1] inputs the subdiagonal elements of the tridiagonal matrix, with
+// e[0] arbitrary. On output e is destroyed. When finding only the eigenvalues,
+// several lines may be omitted, as noted in the comments. If the eigenvectors of
+// a tridiagonal matrix are desired, the matrix z[0..n-1][0..n-1] is input as the
+// identity matrix. If the eigenvectors of a matrix that has been reduced by householder
+// are required, then z is input as the matrix output by householder. In either case,
+// the kth column of z returns the normalized eigenvector corresponding to d[k].
+//
+// input: d - diagonal of symmetric tridiagonal matrix
+//        e - offdiagonal of symmetric tridiagonal matrix
+//        z - identity if you want eigensystem of symmetric tridiagonal matrix
+//          - OR the householder reduction of a symmetric matrix
+// output: d - eigenvalues
+//         z - the corresponding eigen vectors in the COLUMNS!!!
+template <class T>
+static void eigen(double *d, double *e, int n, T **z)
+{
+    double pythag(double a, double b);
+    int m, l, iter, i, k;
+    double s, r, p, g, f, dd, c, b;
+
+      // Convenient to renumber the elements of e.
+    for (i=1; i<n; i++) e[i-1]=e[i];
+    e[n-1]=0.0;
+
+    for (l=0; l<n; l++) {
+        iter=0;
+        do {
+            // Look for a single small subdiagonal element to split the matrix.
+            for (m=l; m<n-1; m++) {
+                dd=fabs(d[m])+fabs(d[m+1]);
+                if ((double)(fabs(e[m])+dd) == dd) break;
+            }
+
+            if (m != l) {
+                if (iter++ == 30) printf("Too many iterations in tqli");
+                g=(d[l+1]-d[l])/(2.0*e[l]);       // Form shift.
+                r=pythag(g, 1.0);
+                g=d[m]-d[l]+e[l]/(g+SIGN(r, g));       // This is dm - ks.
+                s=c=1.0;
+                p=0.0;
+                for (i=m-1; i>=l; i--) {      // A plane rotation as in the original QL, followed by Givens
+                    f=s*e[i];                // rotations to restore tridiagonal form.
+                    b=c*e[i];
+                    e[i+1]=(r=pythag(f, g));
+                    if (r == 0.0) {      // Recover from underflow.
+                        d[i+1] -= p;
+                        e[m]=0.0;
+                        break;
+                    }
+                    s=f/r;
+                    c=g/r;
+                    g=d[i+1]-p;
+                    r=(d[i]-g)*s+2.0*c*b;
+                    d[i+1]=g+(p=s*r);
+                    g=c*r-b;
+                    // Next loop can be omitted if eigenvectors not wanted
+                    // Form eigenvectors.
+                    for (k=0; k<n; k++) {
+                        f=z[k][i+1];
+                        z[k][i+1]=s*z[k][i]+c*f;
+                        z[k][i]=c*z[k][i]-s*f;
+                    }
+                }
+                if (r == 0.0 && i >= l) continue;
+                d[l] -= p;
+                e[l]=g;
+                e[m]=0.0;
+            }
+        } while (m != l);
+    }
+}
+
+
+//******************************************************************************
+// Computes (a2 + b2)1/2 without destructive underflow or overflow.
+//
+double pythag(double a, double b)
+{
+    double absa, absb;
+    absa=fabs(a);
+    absb=fabs(b);
+    if (absa > absb) return absa*sqrt(1.0+(absb/absa)*(absb/absa));
+    else return (absb == 0.0 ? 0.0 : absb*sqrt(1.0+(absa/absb)*(absa/absb)));
+}
+
+
+// use this n^2 sort for small numbers of elements
+// to sort the rows of a matrix from rows numbered:
+// lower to upper inclusive
+template <class T>
+void MatrixT<T>::selectSort(int lower, int upper)
+{
+    int bestLoc;
+    
+    for (int l=lower; l<upper; l++) {
+        bestLoc = l;
+        for (int u=l+1; u<=upper; u++) {
+            if (lessRows(u, bestLoc)) bestLoc=u;
+        }
+        if (bestLoc!=l) swapRows(l, bestLoc);
+    }
+}
+
+
+// use this n^2 sort for small numbers of elements
+// to sort the rows of a matrix from rows numbered:
+// lower to upper inclusive
+template <class T>
+void MatrixT<T>::selectSortCol(int c, int lower, int upper)
+{
+    int bestLoc;
+    
+    for (int l=lower; l<upper; l++) {
+        bestLoc = l;
+        for (int u=l+1; u<=upper; u++) {
+            if (m[u][c] < m[bestLoc][c]) bestLoc=u;
+        }
+        if (bestLoc!=l) swapRows(l, bestLoc);
+    }
+}
+
+
+// do a quick sort of elements a[lower]...a[upper]
+template <class T>
+void MatrixT<T>::qs(int lower, int upper)
+{
+    int save;
+
+    if (upper-lower<32) {
+        selectSort(lower, upper);
+        return;
+    }
+
+    save = lower;      // start scanning up with ptr from lower to upper
+    for (int ptr=lower; ptr<upper; ptr++) {
+        // keep shuffling the values less that split to be in the
+        // array indexed below save.
+        if (lessRows(ptr, upper)) {
+            swapRows(save, ptr);
+            save++;
+        }
+    }    
+
+    swapRows(upper, save);
+
+    if (save-lower>1) qs(lower, save-1);
+    if (upper-save>1) qs(save+1, upper);
+}
+
+
+// do a quick sort of elements a[lower]...a[upper]
+template <class T>
+void MatrixT<T>::qsCol(int c, int lower, int upper)
+{
+    int save;
+
+    if (upper-lower<32) {
+        selectSortCol(c, lower, upper);
+        return;
+    }
+
+    save = lower;      // start scanning up with ptr from lower to upper
+    for (int ptr=lower; ptr<upper; ptr++) {
+        // keep shuffling the values less that split to be in the
+        // array indexed below save.
+        if (m[ptr][c] < m[upper][c]) {
+            swapRows(save, ptr);
+            save++;
+        }
+    }    
+
+    swapRows(upper, save);
+
+    if (save-lower>1) qsCol(c, lower, save-1);
+    if (upper-save>1) qsCol(c, save+1, upper);
+}
+
+
+// Ranges with at least this many rows are sorted by the parallel merge
+// sort or the radix sort below rather than by the quick sorts above.
+static const int largeSortRows = 4096;
+
+
+// A row pointer with its key column as an unsigned number that sorts in
+// the same order as the value.  Sorting these pairs touches only one
+// array instead of chasing every row pointer for each compare.
+template <class T>
+struct RowKey {
+    unsigned long long key;
+    T *row;
+};
+
+
+// IEEE bits of x as an unsigned number in the order of the values:
+// negative numbers have all their bits flipped and positive numbers just
+// the sign bit.  -0 sorts before +0 and NaNs go to the ends.
+static inline unsigned long long sortKey(double x)
+{
+    unsigned long long bits;
+
+    memcpy(&bits, &x, sizeof(bits));
+    return (bits>>63) ? ~bits : (bits | 0x8000000000000000ULL);
+}
+
+
+// Stable LSD radix sort of rows[0..n-1] on column c, one byte of the key
+// per pass.  Passes where every key has the same byte are skipped, which
+// drops most of them for floats, small integers and narrow ranges.  Each
+// thread counts and then scatters its own slice, so the passes run in
+// parallel and stay stable.
+template <class T>
+static void radixSortRows(T **rows, int n, int c)
+{
+    RowKey<T> *a, *b, *tmp;
+    int chunks, passes;
+    int byteUsed[8];
+
+    if (n<2) return;
+
+    chunks = MatrixBase::numThreads();
+    if ((double)n*8<parallelMinWork || chunks>n) chunks = 1;
+    a = new RowKey<T>[n];
+    b = new RowKey<T>[n];
+
+    // the keys and a histogram of every byte of them in one pass
+    int *counts = new int[(size_t)chunks*8*256]();
+    parallelFor(chunks, (double)n*8, [&](int lo, int hi) {
+        for (int j=lo; j<hi; j++) {
+            int *cnt = counts + (size_t)j*8*256;
+            int r0 = (int)((long long)n*j/chunks), r1 = (int)((long long)n*(j+1)/chunks);
+
+            for (int r=r0; r<r1; r++) {
+                unsigned long long k = sortKey(rows[r][c]);
+
+                a[r].key = k;
+                a[r].row = rows[r];
+                for (int d=0; d<8; d++) cnt[d*256 + ((k>>(8*d)) & 0xff)]++;
+            }
+        }
+    }, 1);
+
+    // a byte only needs a pass if the keys differ in it
+    passes = 0;
+    for (int d=0; d<8; d++) {
+        int total = 0;
+
+        for (int j=0; j<chunks; j++) total += counts[(size_t)j*8*256 + d*256 + (a[0].key>>(8*d) & 0xff)];
+        if (total<n) byteUsed[passes++] = d;
+    }
+
+    int *offsets = new int[(size_t)chunks*256];
+    for (int p=0; p<passes; p++) {
+        int d = byteUsed[p];
+
+        // the first pass can use the counts made with the keys
+        if (p>0) {
+            parallelFor(chunks, (double)n, [&](int lo, int hi) {
+                for (int j=lo; j<hi; j++) {
+                    int *cnt = counts + (size_t)j*8*256 + d*256;
+                    int r0 = (int)((long long)n*j/chunks), r1 = (int)((long long)n*(j+1)/chunks);
+
+                    memset(cnt, 0, 256*sizeof(int));
+                    for (int r=r0; r<r1; r++) cnt[(a[r].key>>(8*d)) & 0xff]++;
+                }
+            }, 1);
+        }
+
+        // where each chunk writes each byte value: in byte order and for
+        // the same byte in chunk order, which keeps the sort stable
+        int at = 0;
+        for (int v=0; v<256; v++) {
+            for (int j=0; j<chunks; j++) {
+                offsets[j*256 + v] = at;
+                at += counts[(size_t)j*8*256 + d*256 + v];
+            }
+        }
+
+        parallelFor(chunks, (double)n, [&](int lo, int hi) {
+            for (int j=lo; j<hi; j++) {
+                int *off = offsets + j*256;
+                int r0 = (int)((long long)n*j/chunks), r1 = (int)((long long)n*(j+1)/chunks);
+
+                for (int r=r0; r<r1; r++) b[off[(a[r].key>>(8*d)) & 0xff]++] = a[r];
+            }
+        }, 1);
+
+        tmp = a; a = b; b = tmp;
+    }
+
+    parallelFor(n, (double)n, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) rows[r] = a[r].row;
+    });
+
+    delete [] offsets;
+    delete [] counts;
+    delete [] b;
+    delete [] a;
+}
+
+
+// Merge the sorted runs a[0..na-1] and b[0..nb-1] into out with the
+// output cut into pieces that are merged in parallel.  The start of each
+// piece is found by a binary search for how many of its elements come
+// from a (ties take a first so the merge is stable).
+template <class P, class Less>
+static void mergeRuns(P *a, int na, P *b, int nb, P *out, const Less &less)
+{
+    int n = na+nb;
+    int pieces = MatrixBase::numThreads()*4;
+
+    if (pieces>n) pieces = n;
+    if (pieces<1) pieces = 1;
+
+    auto split = [&](int k) {
+        int lo = k>nb ? k-nb : 0, hi = k<na ? k : na;
+
+        while (lo<hi) {
+            int i = (lo+hi)/2;
+
+            if (less(b[k-i-1], a[i])) hi = i;
+            else lo = i+1;
+        }
+        return lo;
+    };
+
+    parallelFor(pieces, 4.0*n, [&](int lo, int hi) {
+        for (int p=lo; p<hi; p++) {
+            int k0 = (int)((long long)n*p/pieces), k1 = (int)((long long)n*(p+1)/pieces);
+            int i0 = split(k0), i1 = split(k1);
+
+            std::merge(a+i0, a+i1, b+(k0-i0), b+(k1-i1), out+k0, less);
+        }
+    }, 1);
+}
+
+
+// Parallel merge sort of the rows[0..n-1]: each thread sorts a run of
+// rows and then the runs are merged in pairs until one is left.  Only
+// the row pointers are moved.
+template <class T, class Less>
+static void mergeSortRows(T **rows, int n, const Less &less)
+{
+    int runs = MatrixBase::numThreads();
+
+    if ((double)n*20<parallelMinWork || runs>n/2) runs = 1;
+
+    int *bounds = new int[runs+1];
+    for (int j=0; j<=runs; j++) bounds[j] = (int)((long long)n*j/runs);
+
+    parallelFor(runs, 20.0*n, [&](int lo, int hi) {
+        for (int j=lo; j<hi; j++) std::sort(rows+bounds[j], rows+bounds[j+1], less);
+    }, 1);
+
+    T **from = rows, **to = new T *[n], **spare = to;
+    while (runs>1) {
+        int merged = 0;
+
+        for (int j=0; j<runs; j+=2) {
+            if (j+1<runs) mergeRuns(from+bounds[j], bounds[j+1]-bounds[j],
+                                    from+bounds[j+1], bounds[j+2]-bounds[j+1], to+bounds[j], less);
+            else memcpy(to+bounds[j], from+bounds[j], (bounds[j+1]-bounds[j])*sizeof(T *));
+            bounds[merged++] = bounds[j];
+        }
+        bounds[merged] = n;
+        runs = merged;
+        T **tmp = from; from = to; to = tmp;
+    }
+    if (from!=rows) memcpy(rows, from, n*sizeof(T *));
+
+    delete [] spare;
+    delete [] bounds;
+}
+
+
+// sort the rows of a matrix.   WARNING: sorts in place
+// Large matrices are merge sorted in parallel with NaNs after all numbers.
+template <class T>
+void MatrixT<T>::sortRows() {
+    assertDefined("sortRows");
+    if (maxr>1) sortRows(0, maxr-1);
+}
+
+
+template <class T>
+void MatrixT<T>::sortRows(int startRow, int endRow) {
+    ProfileScope prof("sortRows", name);
+
+    assertDefined("sortRows");
+    assertRowIndexOK(startRow, "sortRows");
+    assertRowIndexOK(endRow, "sortRows");
+    if (endRow-startRow+1 >= largeSortRows) {
+        int cols = maxc;
+
+        // NaNs go after every number (and are equal to each other) so the
+        // merges see one consistent order and no row is lost
+        mergeSortRows(m+startRow, endRow-startRow+1, [cols](const T *a, const T *b) {
+            for (int c=0; c<cols; c++) {
+                if (a[c] > b[c]) return false;
+                if (a[c] < b[c]) return true;
+                if (a[c]!=b[c] && (a[c]!=a[c]) != (b[c]!=b[c])) return b[c]!=b[c];
+            }
+            return false;
+        });
+    }
+    else if (maxr>1) qs(startRow, endRow);
+}
+
+
+// sort the rows of a matrix using column c as the key.
+// Column numbering starts at 0.
+// Large matrices are radix sorted in parallel.
+// WARNING: sorts in place
+template <class T>
+void MatrixT<T>::sortRowsByCol(int c) {
+    assertDefined("sortRowsCol");
+    assertColIndexOK(c, "sortRowsByCol");
+    if (maxr>1) sortRowsByCol(c, 0, maxr-1);
+}
+
+
+// sort rows in place in a range of rows
+// Column numbering starts at 0.
+// WARNING: sorts in place
+template <class T>
+void MatrixT<T>::sortRowsByCol(int c, int startRow, int endRow)
+{
+    ProfileScope prof("sortRowsByCol", name);
+
+    assertDefined("sortRowsByCol");
+    assertColIndexOK(c, "sortRowsByCol");
+    assertRowIndexOK(startRow, "sortRowsByCol");
+    assertRowIndexOK(endRow, "sortRowsByCol");
+    if (endRow-startRow+1 >= largeSortRows) radixSortRows(m+startRow, endRow-startRow+1, c);
+    else if (maxr>1) qsCol(c, startRow, endRow);
+}
+
+
+// As sortRowsByCol but stable: rows with equal keys keep their order.
+// This is always the radix sort, which is linear in the number of rows.
+// -0 sorts before +0 and NaNs go to the ends (negative NaNs first).
+template <class T>
+void MatrixT<T>::stableSortRowsByCol(int c)
+{
+    assertDefined("stableSortRowsByCol");
+    assertColIndexOK(c, "stableSortRowsByCol");
+    radixSortRows(m, maxr, c);
+}
+
+
+template <class T>
+void MatrixT<T>::stableSortRowsByCol(int c, int startRow, int endRow)
+{
+    ProfileScope prof("stableSortRowsByCol", name);
+
+    assertDefined("stableSortRowsByCol");
+    assertColIndexOK(c, "stableSortRowsByCol");
+    assertRowIndexOK(startRow, "stableSortRowsByCol");
+    assertRowIndexOK(endRow, "stableSortRowsByCol");
+    radixSortRows(m+startRow, endRow-startRow+1, c);
+}
+
+
+// Three way partition of rows lower..upper on column c about the value
+// pivot: afterwards rows lower..lt-1 are less than pivot, rows lt..gt are
+// equal to it and rows gt+1..upper are greater.  Runs of equal keys are
+// gathered together so they cannot make selection quadratic.
+template <class T>
+void MatrixT<T>::partition3Col(int c, double pivot, int lower, int upper, int &lt, int &gt)
+{
+    int i;
+
+    lt = i = lower;
+    gt = upper;
+    while (i<=gt) {
+        if (m[i][c] < pivot) swapRows(lt++, i++);
+        else if (m[i][c] > pivot) swapRows(i, gt--);
+        else i++;
+    }
+}
+
+
+// Introselect: quickselect with a median of three pivot until depth runs
+// out and then median of medians pivots, which guarantee linear time.
+template <class T>
+void MatrixT<T>::selectCol(int c, int k, int lower, int upper, int depth)
+{
+    while (upper-lower >= 16) {
+        double pivot;
+        int lt, gt;
+
+        if (depth-- > 0) {
+            double a = m[lower][c], b = m[(lower+upper)/2][c], d = m[upper][c];
+
+            pivot = (a<b) ? ((b<d) ? b : ((a<d) ? d : a)) : ((a<d) ? a : ((b<d) ? d : b));
+        }
+        else {
+            int groups = 0;
+
+            // gather the medians of groups of five at the front and find their median
+            for (int g=lower; g+4<=upper; g+=5) {
+                selectSortCol(c, g, g+4);
+                swapRows(lower+groups, g+2);
+                groups++;
+            }
+            selectCol(c, lower+groups/2, lower, lower+groups-1, 0);
+            pivot = m[lower+groups/2][c];
+        }
+
+        partition3Col(c, pivot, lower, upper, lt, gt);
+        if (k<lt) upper = lt-1;
+        else if (k>gt) lower = gt+1;
+        else return;
+    }
+
+    selectSortCol(c, lower, upper);
+}
+
+
+// Move rows startRow..endRow (inclusive) so that row k holds the row that
+// would be there if the range were sorted on column c, the rows before it
+// have values in column c no greater and the rows after no smaller.  Like
+// std::nth_element this takes linear time rather than a sort's n log n
+// and is all a median split needs.  Only row pointers move.
+template <class T>
+void MatrixT<T>::selectRowsByCol(int c, int k, int startRow, int endRow)
+{
+    ProfileScope prof("selectRowsByCol", name);
+
+    assertDefined("selectRowsByCol");
+    assertColIndexOK(c, "selectRowsByCol");
+    assertRowIndexOK(startRow, "selectRowsByCol");
+    assertRowIndexOK(endRow, "selectRowsByCol");
+    if (k<startRow || k>endRow) {
+        printf("ERROR(selectRowsByCol): row %d to select is not in the range of rows %d to %d\n", k, startRow, endRow);
+        exit(1);
+    }
+
+    int depth = 0;
+    for (int n=endRow-startRow+1; n>1; n>>=1) depth += 2;
+    selectCol(c, k, startRow, endRow, depth);
+}
+
+
+// Move the rows so those with a value in column c less than pivot come
+// first.  Returns the number of them, which is the index of the first row
+// with a value of at least pivot.  Only row pointers move.
+template <class T>
+int MatrixT<T>::partitionRowsByCol(int c, double pivot)
+{
+    assertDefined("partitionRowsByCol");
+
+    return maxr>0 ? partitionRowsByCol(c, pivot, 0, maxr-1) : 0;
+}
+
+
+// as above in rows startRow..endRow (inclusive) returning the index of the
+// first row with a value of at least pivot (endRow+1 if there is none)
+template <class T>
+int MatrixT<T>::partitionRowsByCol(int c, double pivot, int startRow, int endRow)
+{
+    assertDefined("partitionRowsByCol");
+    assertColIndexOK(c, "partitionRowsByCol");
+    assertRowIndexOK(startRow, "partitionRowsByCol");
+    assertRowIndexOK(endRow, "partitionRowsByCol");
+
+    int i = startRow, j = endRow;
+
+    // Hoare's scan from both ends so each row is swapped at most once
+    for (;;) {
+        while (i<=j && m[i][c] < pivot) i++;
+        while (i<=j && !(m[j][c] < pivot)) j--;
+        if (i>=j) break;
+        swapRows(i++, j--);
+    }
+
+    return i;
+}
+
+
+
+// Create a subMatrix.   DANGER: This bit of evil is a matrix that POINTS
+// INTO ANOTHER MATRIX!   DANGER: Do not use the subMatrix after you
+// deallocate the other matrix!!   In a sense this is not a real matrix.
+// If you want this matrix to persist then you have to make a full copy of it.
+template <class T>
+MatrixT<T> MatrixT<T>::subMatrix(int minr, int minc, int sizer, int sizec) const
+{
+    if (sizer==0) sizer = maxr - minr;
+    if (sizec==0) sizec = maxc - minc;
+
+    checkBounds(minr, minc, "lower bounds extract");
+    checkBounds(minr+sizer-1, minc+sizec-1, "upper bounds extract");
+
+    MatrixT out(sizer);                        // allocate a subMatrix!
+    out.maxc = sizec;                          // fix internal column width
+    if (data!=NULL) {                          // view shares the block and stride of the parent
+        out.data = &(m[minr][minc]);
+        out.stride = stride;
+    }
+
+    for (int r=0; r<sizer; r++) {
+        out.m[r] = &(m[minr][minc]);               // DANGER: we are copying pointers into other Matrix!!!
+        minr++;
+    }
+
+    out.defined = true;
+
+    return out;
+}    
+
+
+
+// Create a subMatrix.   DANGER: This bit of evil is a matrix that POINTS
+// INTO ANOTHER MATRIX!   DANGER: Do not use the subMatrix after you
+// deallocate the other matrix!!   In a sense this is not a real matrix.
+// If you want this matrix to persist then you have to make a full copy of it.
+template <class T>
+MatrixT<T> MatrixT<T>::subMatrixEq(int c, double value) const
+{
+    assertColIndexOK(c, "subMatrixEq");
+
+    std::vector<T *> rowList;        // this is a retrofit of using an array originally when vector better
+
+    for (int r=0; r<maxr; r++) {
+        if (m[r][c]==value) rowList.push_back(m[r]);
+    }
+
+    MatrixT out(rowList.size());                        // allocate a subMatrix!
+    out.maxc = maxc;
+    if (data!=NULL && rowList.size()>0) {               // view shares the block and stride of the parent
+        out.data = rowList[0];
+        out.stride = stride;
+    }
+    
+    for (unsigned int r=0; r<rowList.size(); r++) {
+        out.m[r] = rowList[r];                          // DANGER: we are copying pointers into other Matrix!!!
+    }
+
+    out.defined = true;
+
+    return out;
+}    
+
+
+template <class T>
+MatrixT<T> MatrixT<T>::subMatrixNeq(int c, double value) const
+{
+    assertColIndexOK(c, "subMatrixNeq");
+
+    std::vector<T *> rowList;        // this is a retrofit of using an array originally when vector better
+
+    for (int r=0; r<maxr; r++) {
+        if (m[r][c]!=value) rowList.push_back(m[r]);
+    }
+
+    MatrixT out(rowList.size());                        // allocate a subMatrix!
+    out.maxc = maxc;
+    if (data!=NULL && rowList.size()>0) {               // view shares the block and stride of the parent
+        out.data = rowList[0];
+        out.stride = stride;
+    }
+    
+    for (unsigned int r=0; r<rowList.size(); r++) {
+        out.m[r] = rowList[r];                          // DANGER: we are copying pointers into other Matrix!!!
+    }
+
+    out.defined = true;
+
+    return out;
+}    
+
+
+// // // // // // // // // // // // // // // // // // // //
+//
+// image (picture) support: pgm (gray) and ppm (color) files
+//
+// Reads P2/P3 (ascii) and P5/P6 (binary) files with any maximum value up
+// to 65535.  A maximum above 255 means two bytes per sample, high byte
+// first.  The samples are not scaled: a pixel is a number from 0 to the
+// maximum value.  Writes binary files unless asked for ascii.
+// Gray is one number for each pixel.
+// Color is three numbers in a row for RGB in each pixel.
+// That is a color square 100x100 pixels gens a 100x300 dimensional array
+
+// helper routine for writing images: x as a sample from 0 to maxval
+template <class T>
+int MatrixT<T>::pixelValue(double x, int maxval)
+{
+    int z;
+
+    z = int(x);
+    if (z<0) z = 0;
+    if (z>maxval) z = maxval;
+
+    return z;
+}
+
+
+// the next number in the header of an image file.  Comments (# to the
+// end of the line) may come anywhere between the numbers.
+static int imageHeaderNumber(FILE *in, const char *caller, const std::string &filename, const char *what)
+{
+    int ch, n;
+
+    for (;;) {
+        ch = getc(in);
+        if (ch=='#') {
+            while (ch!='\n' && ch!=EOF) ch = getc(in);
+        }
+        else if (ch!=' ' && ch!='\t' && ch!='\r' && ch!='\n') break;
+    }
+
+    if (ch<'0' || ch>'9') {
+        printf("ERROR(%s): unable to read the %s from the header of file \"%s\".\n", caller, what, filename.c_str());
+        exit(1);
+    }
+    n = 0;
+    while (ch>='0' && ch<='9') {
+        if (n > (INT_MAX - 9)/10) {
+            printf("ERROR(%s): the %s in the header of file \"%s\" is too big.\n", caller, what, filename.c_str());
+            exit(1);
+        }
+        n = n*10 + (ch - '0');
+        ch = getc(in);
+    }
+    if (ch!=EOF && ch!=' ' && ch!='\t' && ch!='\r' && ch!='\n') ungetc(ch, in);   // the one white space after maxval is eaten
+
+    return n;
+}
+
+
+// helper routine for reading images
+template <class T>
+MatrixT<T> MatrixT<T>::readImage(char *expectedType, char *caller, std::string filename, std::string namex)
+{
+    ProfileScope prof("readImage", namex);
+
+    char magic[3];               // magic number
+    FILE *IN;                    // input file
+    int newr, newc, max;         // picture parms
+
+    if (filename.length()>0) {
+        IN = fopen(filename.c_str(), "rb");
+        if (IN==NULL) {
+            printf("ERROR(%s): Trying to open file \"%s\" but failed.\n", caller, filename.c_str());
+            exit(1);
+        }
+    }
+    else {
+        IN = stdin;
+    }
+
+    // get magic number of file
+    if (fscanf(IN, "%2s", magic)!=1) {
+        printf("ERROR(%s): unable to read file magic number for file named \"%s\".\n", caller, filename.c_str());
+        exit(1);
+    }
+
+    if (! (magic[0]=='P' && (magic[1]==expectedType[0] || magic[1]==expectedType[1]))) {
+        printf("ERROR(%s): Trying to open a file named \"%s\" in P%c or P%c format but had wrong magic number.\n",
+               caller,
+               filename.c_str(),
+               expectedType[0],
+               expectedType[1]);
+        exit(1);
+    }
+
+    // read picture parameters
+    newc = imageHeaderNumber(IN, caller, filename, "width");
+    newr = imageHeaderNumber(IN, caller, filename, "height");
+    max = imageHeaderNumber(IN, caller, filename, "maximum value");
+    if (max<1 || max>65535) {
+        printf("ERROR(%s): file \"%s\" has maximum value %d but it must be from 1 to 65535.\n", caller, filename.c_str(), max);
+        exit(1);
+    }
+
+    // is color?
+    if (magic[1]=='3' || magic[1]=='6') {
+        if (newc > INT_MAX/3) newc = -1;
+        else newc *= 3;
+    }
+    if (newr<1 || newc<1) {
+        printf("ERROR(%s): file \"%s\" has a bad picture size.\n", caller, filename.c_str());
+        exit(1);
+    }
+
+    // reallocate myself
+    reallocate(newr, newc, name);
+
+    // is ascii numbers?
+    if (magic[1]=='2' || magic[1]=='3') {
+        for (int r=0; r<maxr; r++) {
+            for (int c=0; c<maxc; c++) {
+                int tmp;
+                if (fscanf(IN, "%d", &tmp)!=1) {
+                    printf("ERROR(%s): Trying to read ascii pixel value at position (%d, %d) from file \"%s\" but failed.\n",
+                           caller,
+                           r, c,
+                           filename.c_str());
+                    exit(1);
+                }
+                m[r][c] = tmp;
+            }
+        }
+    }
+
+    // is binary numbers?  All the pixels come in with one read.
+    if (magic[1]=='5' || magic[1]=='6') {
+        const size_t sampleBytes = (max>255) ? 2 : 1;
+        const size_t rowBytes = (size_t)maxc*sampleBytes;
+        unsigned char *pixels = new unsigned char [(size_t)maxr*rowBytes];
+        size_t got = fread(pixels, 1, (size_t)maxr*rowBytes, IN);
+
+        if (got!=(size_t)maxr*rowBytes) {
+            printf("ERROR(%s): file \"%s\" ended in pixel row %d of %d.\n", caller, filename.c_str(), (int)(got/rowBytes), maxr);
+            exit(1);
+        }
+
+        parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+            for (int r=lo; r<hi; r++) {
+                const unsigned char *p = pixels + (size_t)r*rowBytes;
+                T *row = m[r];
+
+                if (sampleBytes==1) {
+                    for (int c=0; c<maxc; c++) row[c] = p[c];
+                }
+                else {
+                    for (int c=0; c<maxc; c++) row[c] = (p[2*c]<<8) | p[2*c+1];
+                }
+            }
+        });
+        delete [] pixels;
+    }
+
+    if (IN!=stdin) fclose(IN);
+    defined = true;
+
+    return *this;
+}
+
+
+// Read a pgm file (gray scale) in P2 or P5 format.
+template <class T>
+MatrixT<T> MatrixT<T>::readImagePgm(std::string filename, std::string namex)
+{
+    return readImage((char *)"25", (char *)"readImagePgm", filename, namex);  // accept types P2 or P5
+}
+
+
+template <class T>
+MatrixT<T> MatrixT<T>::readImagePpm(std::string filename, std::string namex)
+{
+    return readImage((char *)"36", (char *)"readImagePpm", filename, namex);  // accept types P3 or P6
+}
+
+
+// helper routine for writing images.  The header is followed by the
+// pixels built up a row at a time in a buffer: binary samples (one byte
+// or two bytes high byte first) or the decimal numbers of an ascii file,
+// one row to a line.  channels is 1 for gray and 3 for color.
+template <class T>
+void MatrixT<T>::writeImage(const char *caller, std::string filename, std::string comment, int channels, int maxval, bool ascii)
+{
+    FILE *OUT;
+    char magic;
+    std::vector<unsigned char> buffer;
+
+    assertDefined(caller);
+    if (maxval<1 || maxval>65535) {
+        printf("ERROR(%s): maximum value %d must be from 1 to 65535.\n", caller, maxval);
+        exit(1);
+    }
+
+    if (filename.length()>0) {
+        OUT = fopen(filename.c_str(), "wb");
+        if (OUT==NULL) {
+            printf("ERROR(%s): Trying to open file \"%s\" but failed.\n", caller, filename.c_str());
+            exit(1);
+        }
+    }
+    else {
+        OUT = stdout;
+    }
+
+    if (channels==1) magic = ascii ? '2' : '5';
+    else magic = ascii ? '3' : '6';
+    fprintf(OUT, "P%c\n", magic);
+    if (name.length()>0) fprintf(OUT, "# Name: %s\n", name.c_str());
+    if (comment.length()>0) fprintf(OUT, "# %s\n", comment.c_str());
+    fprintf(OUT, "# %d bit %s\n", maxval>255 ? 16 : 8, channels==1 ? "gray scale" : "color");
+    fprintf(OUT, "%d %d\n", maxc/channels, maxr);    // NOTE: columns then rows!
+    fprintf(OUT, "%d\n", maxval);                    // maximum level of gray or of color channels
+
+    buffer.resize((size_t)maxc*(ascii ? 6 : (maxval>255 ? 2 : 1)));
+    for (int r=0; r<maxr; r++) {
+        unsigned char *p = buffer.data();
+
+        for (int c=0; c<maxc; c++) {
+            int z = pixelValue(m[r][c], maxval);
+
+            if (ascii) {
+                char digits[8];
+                int n = 0;
+
+                do { digits[n++] = '0' + z%10; z /= 10; } while (z>0);
+                while (n>0) *p++ = digits[--n];
+                *p++ = (c<maxc-1) ? ' ' : '\n';
+            }
+            else if (maxval>255) {
+                *p++ = z>>8;
+                *p++ = z&0xff;
+            }
+            else *p++ = z;
+        }
+        if (p!=buffer.data()) fwrite(buffer.data(), 1, p - buffer.data(), OUT);
+    }
+
+    if (OUT!=stdout) {
+        if (fclose(OUT)!=0) {
+            printf("ERROR(%s): unable to write file \"%s\".\n", caller, filename.c_str());
+            exit(1);
+        }
+    }
+    else fflush(OUT);
+}
+
+
+// Write a pgm file (gray scale): binary P5 or with ascii the readable
+// P2.  Line length of a P2 file is unrestricted.
+// WARNING: the user is entrusted with the task of using the pgm file extension
+// in the filename
+template <class T>
+void MatrixT<T>::writeImagePgm(std::string filename, std::string comment, int maxval, bool ascii)
+{
+    ProfileScope prof("writeImagePgm", name);
+
+    writeImage("writeImagePgm", filename, comment, 1, maxval, ascii);
+}
+
+
+
+// Write a ppm file (color): binary P6 or with ascii the readable P3.
+// WARNING: the user is entrusted with the task of using the ppm file extension
+// in the filename
+template <class T>
+void MatrixT<T>::writeImagePpm(std::string filename, std::string comment, int maxval, bool ascii)
+{
+    ProfileScope prof("writeImagePpm", name);
+
+    if (maxc%3 != 0) {
+        if (name.length()==0) {
+            printf("ERROR(writeImagePpm): Number of columns %d not divisible by three but supposed to be a matrix of RGB values.\n", maxc);
+        }
+        else {
+            printf("ERROR(writeImagePpm): Number of columns %d in matrix named \"%s\" is not divisible by three but supposed to be a matrix of RGB values .\n", maxc, name.c_str());
+        }
+        exit(1);
+    }
+
+    writeImage("writeImagePpm", filename, comment, 3, maxval, ascii);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // //
+//
+// SparseMatrix
+//
+// The nonzeros are kept in CSR form (see mat.h).  Zeros are never kept:
+// the constructors and readText drop them.  The products split the rows
+// (dot) or the columns of the answer (Tdot) over the thread pool so every
+// element is summed in the same order whatever the number of threads.
+//
+
+template <class T>
+SparseMatrixT<T>::SparseMatrixT(std::string namex)
+{
+    maxr = maxc = 0;
+    rowStart.assign(1, 0);
+    name = namex;
+}
+
+
+template <class T>
+SparseMatrixT<T>::SparseMatrixT(int r, int c, std::string namex)
+{
+    if (r<0 || c<0) {
+        printf("ERROR(SparseMatrix): Trying to create a sparse matrix of size %d X %d\n", r, c);
+        exit(1);
+    }
+    maxr = r;
+    maxc = c;
+    rowStart.assign((size_t)r+1, 0);
+    name = namex;
+}
+
+
+template <class T>
+SparseMatrixT<T>::SparseMatrixT(const MatrixT<T> &dense, double tol, std::string namex)
+{
+    std::vector<int> count;
+
+    dense.assertDefined("SparseMatrix");
+    maxr = dense.maxr;
+    maxc = dense.maxc;
+    name = namex;
+
+    // count the nonzeros of each row, then fill in each row where it starts
+    count.assign(maxr, 0);
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            const T *row = dense.m[r];
+            int n = 0;
+
+            for (int c=0; c<maxc; c++) if (fabs((double)row[c])>tol) n++;
+            count[r] = n;
+        }
+    });
+
+    rowStart.assign((size_t)maxr+1, 0);
+    for (int r=0; r<maxr; r++) rowStart[r+1] = rowStart[r] + count[r];
+    col.resize(rowStart[maxr]);
+    value.resize(rowStart[maxr]);
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            const T *row = dense.m[r];
+            long long k = rowStart[r];
+
+            for (int c=0; c<maxc; c++) {
+                if (fabs((double)row[c])>tol) {
+                    col[k] = c;
+                    value[k] = row[c];
+                    k++;
+                }
+            }
+        }
+    });
+}
+
+
+template <class T>
+SparseMatrixT<T>::SparseMatrixT(int r, int c, const std::vector<int> &rows, const std::vector<int> &cols,
+                                const std::vector<T> &values, std::string namex)
+{
+    std::vector<long long> order, next;
+    size_t n;
+
+    if (r<0 || c<0) {
+        printf("ERROR(SparseMatrix): Trying to create a sparse matrix of size %d X %d\n", r, c);
+        exit(1);
+    }
+    if (rows.size()!=cols.size() || rows.size()!=values.size()) {
+        printf("ERROR(SparseMatrix): %lu rows, %lu columns and %lu values given for the nonzeros\n",
+               (unsigned long)rows.size(), (unsigned long)cols.size(), (unsigned long)values.size());
+        exit(1);
+    }
+    maxr = r;
+    maxc = c;
+    name = namex;
+    n = values.size();
+
+    for (size_t i=0; i<n; i++) {
+        if (rows[i]<0 || rows[i]>=maxr || cols[i]<0 || cols[i]>=maxc) {
+            printf("ERROR(SparseMatrix): nonzero at [%d, %d] is outside a %d X %d matrix\n", rows[i], cols[i], maxr, maxc);
+            exit(1);
+        }
+    }
+
+    // bucket the triples by row keeping their order, then sort each row by column
+    next.assign((size_t)maxr+1, 0);
+    for (size_t i=0; i<n; i++) next[rows[i]+1]++;
+    for (int i=0; i<maxr; i++) next[i+1] += next[i];
+    order.resize(n);
+    for (size_t i=0; i<n; i++) order[next[rows[i]]++] = i;
+
+    rowStart.assign((size_t)maxr+1, 0);
+    col.resize(n);
+    value.resize(n);
+    long long k = 0, start = 0;
+    for (int i=0; i<maxr; i++) {
+        long long end = next[i];
+
+        std::stable_sort(order.begin()+start, order.begin()+end, [&](long long a, long long b) { return cols[a] < cols[b]; });
+        for (long long j=start; j<end; ) {
+            int cc = cols[order[j]];
+            double sum = 0;
+
+            for (; j<end && cols[order[j]]==cc; j++) sum += values[order[j]];   // repeats are added
+            if (sum!=0) {
+                col[k] = cc;
+                value[k] = sum;
+                k++;
+            }
+        }
+        rowStart[i+1] = k;
+        start = end;
+    }
+    col.resize(k);
+    value.resize(k);
+}
+
+
+template <class T>
+double SparseMatrixT<T>::density() const
+{
+    return (maxr==0 || maxc==0) ? 0.0 : (double)value.size()/((double)maxr*maxc);
+}
+
+
+template <class T>
+double SparseMatrixT<T>::get(int r, int c) const
+{
+    if (r<0 || r>=maxr || c<0 || c>=maxc) {
+        printf("ERROR(SparseMatrix get): index [%d, %d] is outside sparse matrix \"%s\" of size %d X %d\n",
+               r, c, name.c_str(), maxr, maxc);
+        exit(1);
+    }
+
+    const int *first = col.data() + rowStart[r], *last = col.data() + rowStart[r+1];
+    const int *p = std::lower_bound(first, last, c);
+
+    return (p!=last && *p==c) ? (double)value[p - col.data()] : 0.0;
+}
+
+
+template <class T>
+MatrixT<T> SparseMatrixT<T>::toDense(std::string namex) const
+{
+    MatrixT<T> out(maxr, maxc, namex);
+
+    parallelFor(maxr, (double)maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            T *row = out.m[r];
+
+            for (int c=0; c<maxc; c++) row[c] = 0;
+            for (long long k=rowStart[r]; k<rowStart[r+1]; k++) row[col[k]] = value[k];
+        }
+    });
+    out.defined = true;
+
+    return out;
+}
+
+
+template <class T>
+SparseMatrixT<T> SparseMatrixT<T>::extractRows(int minr, int sizer) const
+{
+    if (minr<0 || sizer<0 || minr+sizer>maxr) {
+        printf("ERROR(SparseMatrix extractRows): rows %d to %d are not all in sparse matrix \"%s\" of size %d X %d\n",
+               minr, minr+sizer-1, name.c_str(), maxr, maxc);
+        exit(1);
+    }
+
+    SparseMatrixT out(sizer, maxc, name);
+    long long first = rowStart[minr], last = rowStart[minr+sizer];
+
+    for (int r=0; r<=sizer; r++) out.rowStart[r] = rowStart[minr+r] - first;
+    out.col.assign(col.begin()+first, col.begin()+last);
+    out.value.assign(value.begin()+first, value.begin()+last);
+
+    return out;
+}
+
+
+template <class T>
+SparseMatrixT<T> SparseMatrixT<T>::pickRows(const std::vector<int> &rows) const
+{
+    SparseMatrixT out((int)rows.size(), maxc, name);
+
+    for (size_t i=0; i<rows.size(); i++) {
+        if (rows[i]<0 || rows[i]>=maxr) {
+            printf("ERROR(SparseMatrix pickRows): row %d is not in sparse matrix \"%s\" of size %d X %d\n",
+                   rows[i], name.c_str(), maxr, maxc);
+            exit(1);
+        }
+        out.rowStart[i+1] = out.rowStart[i] + rowNonZero(rows[i]);
+    }
+    out.col.resize(out.rowStart[rows.size()]);
+    out.value.resize(out.rowStart[rows.size()]);
+    for (size_t i=0; i<rows.size(); i++) {
+        std::copy(col.begin()+rowStart[rows[i]], col.begin()+rowStart[rows[i]+1], out.col.begin()+out.rowStart[i]);
+        std::copy(value.begin()+rowStart[rows[i]], value.begin()+rowStart[rows[i]+1], out.value.begin()+out.rowStart[i]);
+    }
+
+    return out;
+}
+
+
+// a counting sort by column.  Walking the rows in order leaves each row
+// of the answer sorted by column.
+template <class T>
+SparseMatrixT<T> SparseMatrixT<T>::transpose() const
+{
+    SparseMatrixT out(maxc, maxr, name);
+    std::vector<long long> next;
+
+    for (size_t k=0; k<col.size(); k++) out.rowStart[col[k]+1]++;
+    for (int c=0; c<maxc; c++) out.rowStart[c+1] += out.rowStart[c];
+    out.col.resize(col.size());
+    out.value.resize(value.size());
+    next.assign(out.rowStart.begin(), out.rowStart.end()-1);
+    for (int r=0; r<maxr; r++) {
+        for (long long k=rowStart[r]; k<rowStart[r+1]; k++) {
+            long long j = next[col[k]]++;
+
+            out.col[j] = r;
+            out.value[j] = value[k];
+        }
+    }
+
+    return out;
+}
+
+
+template <class T>
+void SparseMatrixT<T>::checkDense(const MatrixT<T> &other, int rows, const char *msg) const
+{
+    other.assertDefined(msg);
+    if (other.maxr!=rows) {
+        printf("ERROR(%s): sparse matrix \"%s\" of size %d X %d does not fit matrix \"%s\" of size %d X %d\n",
+               msg, name.c_str(), maxr, maxc, other.name.c_str(), other.maxr, other.maxc);
+        exit(1);
+    }
+}
+
+
+template <class T>
+MatrixT<T> SparseMatrixT<T>::dot(const MatrixT<T> &other) const
+{
+    MatrixT<T> out;
+
+    dotInto(other, out);
+
+    return out;
+}
+
+
+template <class T>
+MatrixT<T> SparseMatrixT<T>::Tdot(const MatrixT<T> &other) const
+{
+    MatrixT<T> out;
+
+    TdotInto(other, out);
+
+    return out;
+}
+
+
+// each row of the answer is the sum of the rows of other picked out by
+// the nonzeros of that row of self
+template <class T>
+MatrixT<T> &SparseMatrixT<T>::dotInto(const MatrixT<T> &other, MatrixT<T> &out, double alpha, double beta) const
+{
+    MatrixBase::ProfileScope prof("sparse dotInto", name);
+    const int n = other.maxc;
+
+    checkDense(other, maxc, "SparseMatrix dotInto");
+    if (&out==&other) {
+        printf("ERROR(SparseMatrix dotInto): the answer can not also be a factor of the product\n");
+        exit(1);
+    }
+    if (beta!=0.0 || out.submatrix) out.assertSize(maxr, n, "SparseMatrix dotInto");
+    else out.reallocate(maxr, n, out.name);
+
+    parallelFor(maxr, 2.0*value.size()*n + (double)maxr*n, [&](int lo, int hi) {
+        std::vector<T> sum(n);
+
+        for (int r=lo; r<hi; r++) {
+            T *o = out.m[r];
+
+            for (int c=0; c<n; c++) sum[c] = 0;
+            for (long long k=rowStart[r]; k<rowStart[r+1]; k++) {
+                const T x = value[k];
+                const T *b = other.m[col[k]];
+
+                for (int c=0; c<n; c++) sum[c] += x*b[c];
+            }
+            if (beta==0.0) for (int c=0; c<n; c++) o[c] = alpha*sum[c];
+            else for (int c=0; c<n; c++) o[c] = alpha*sum[c] + beta*o[c];
+        }
+    });
+    out.defined = true;
+
+    return out;
+}
+
+
+// row r of other is added, scaled by each nonzero of row r of self, to
+// the rows of the answer named by their columns.  The columns of the
+// answer are split over the threads so no two threads add to one place,
+// and each thread adds straight into its columns of out once they are
+// cleared (or scaled by beta) with alpha taken into each nonzero.
+template <class T>
+MatrixT<T> &SparseMatrixT<T>::TdotInto(const MatrixT<T> &other, MatrixT<T> &out, double alpha, double beta) const
+{
+    MatrixBase::ProfileScope prof("sparse TdotInto", name);
+    const int n = other.maxc;
+
+    checkDense(other, maxr, "SparseMatrix TdotInto");
+    if (&out==&other) {
+        printf("ERROR(SparseMatrix TdotInto): the answer can not also be a factor of the product\n");
+        exit(1);
+    }
+    if (beta!=0.0 || out.submatrix) out.assertSize(maxc, n, "SparseMatrix TdotInto");
+    else out.reallocate(maxc, n, out.name);
+
+    parallelFor(n, 2.0*value.size()*n + (double)maxc*n, [&](int lo, int hi) {
+        for (int i=0; i<maxc; i++) {
+            T *o = out.m[i];
+
+            if (beta==0.0) for (int c=lo; c<hi; c++) o[c] = 0;
+            else if (beta!=1.0) for (int c=lo; c<hi; c++) o[c] *= beta;
+        }
+        for (int r=0; r<maxr; r++) {
+            const T *b = other.m[r];
+
+            for (long long k=rowStart[r]; k<rowStart[r+1]; k++) {
+                const T x = alpha*value[k];
+                T *o = out.m[col[k]];
+
+                for (int c=lo; c<hi; c++) o[c] += x*b[c];
+            }
+        }
+    });
+    out.defined = true;
+
+    return out;
+}
+
+
+// Only the nonzeros are visited.  The zeros of a column add nothing to
+// its sum and (maxr - nonzeros) mean^2 to its sum of squared deviations.
+template <class T>
+MatrixT<T> SparseMatrixT<T>::columnStats() const
+{
+    MatrixBase::ProfileScope prof("sparse columnStats", name);
+    std::vector<double> sum(maxc, 0.0), m2(maxc, 0.0), low(maxc, 0.0), high(maxc, 0.0);
+    std::vector<long long> nonZero(maxc, 0);
+    MatrixT<T> stats(MatrixBase::STAT_ROWS, maxc, "columnStats of " + name);
+
+    for (size_t k=0; k<value.size(); k++) {
+        int c = col[k];
+        double x = value[k];
+
+        if (nonZero[c]==0 || x<low[c]) low[c] = x;
+        if (nonZero[c]==0 || x>high[c]) high[c] = x;
+        sum[c] += x;
+        nonZero[c]++;
+    }
+    for (size_t k=0; k<value.size(); k++) {
+        double d = value[k] - sum[col[k]]/maxr;
+
+        m2[col[k]] += d*d;
+    }
+
+    for (int c=0; c<maxc; c++) {
+        double mean = sum[c]/maxr;
+
+        if (nonZero[c]<maxr) {
+            m2[c] += (maxr - nonZero[c])*mean*mean;
+            if (low[c]>0) low[c] = 0;
+            if (high[c]<0) high[c] = 0;
+        }
+        stats.m[MatrixBase::STAT_MEAN][c] = mean;
+        stats.m[MatrixBase::STAT_VARIANCE][c] = m2[c]/maxr;
+        stats.m[MatrixBase::STAT_MIN][c] = low[c];
+        stats.m[MatrixBase::STAT_MAX][c] = high[c];
+        stats.m[MatrixBase::STAT_NONZERO][c] = nonZero[c];
+    }
+    stats.defined = true;
+
+    return stats;
+}
+
+
+template <class T>
+MatrixT<T> SparseMatrixT<T>::meanVec() const
+{
+    std::vector<double> sum(maxc, 0.0);
+    MatrixT<T> mean(1, maxc);
+
+    for (size_t k=0; k<value.size(); k++) sum[col[k]] += value[k];
+    for (int c=0; c<maxc; c++) mean.m[0][c] = sum[c]/maxr;
+    mean.defined = true;
+
+    return mean;
+}
+
+
+template <class T>
+MatrixT<T> SparseMatrixT<T>::stddevVec() const
+{
+    MatrixT<T> stats = columnStats();
+    MatrixT<T> stddev(1, maxc);
+
+    for (int c=0; c<maxc; c++) stddev.m[0][c] = sqrt(stats.m[MatrixBase::STAT_VARIANCE][c]);
+    stddev.defined = true;
+
+    return stddev;
+}
+
+
+template <class T>
+void SparseMatrixT<T>::readText(std::string filename)
+{
+    MatrixBase::ProfileScope prof("sparse readText", name);
+    FILE *IN;
+    int r, c;
+    long long n;
+    std::vector<int> rows, cols;
+    std::vector<T> values;
+
+    IN = fopen(filename.c_str(), "r");
+    if (IN==NULL) {
+        printf("ERROR(SparseMatrix readText): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+    if (fscanf(IN, "%d %d %lld", &r, &c, &n)!=3 || r<0 || c<0 || n<0) {
+        printf("ERROR(SparseMatrix readText): file \"%s\" does not start with \"rows cols nonzeros\"\n", filename.c_str());
+        exit(1);
+    }
+
+    rows.reserve(n);
+    cols.reserve(n);
+    values.reserve(n);
+    for (long long i=0; i<n; i++) {
+        int rr, cc;
+        double x;
+
+        if (fscanf(IN, "%d %d %lf", &rr, &cc, &x)!=3) {
+            printf("ERROR(SparseMatrix readText): file \"%s\" ended or went wrong in nonzero %lld of %lld\n",
+                   filename.c_str(), i+1, n);
+            exit(1);
+        }
+        rows.push_back(rr);
+        cols.push_back(cc);
+        values.push_back(x);
+    }
+    fclose(IN);
+
+    *this = SparseMatrixT(r, c, rows, cols, values, name);
+}
+
+
+template <class T>
+void SparseMatrixT<T>::writeText(std::string filename) const
+{
+    FILE *OUT;
+
+    OUT = fopen(filename.c_str(), "w");
+    if (OUT==NULL) {
+        printf("ERROR(SparseMatrix writeText): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+    fprintf(OUT, "%d %d %lld\n", maxr, maxc, (long long)value.size());
+    for (int r=0; r<maxr; r++) {
+        for (long long k=rowStart[r]; k<rowStart[r+1]; k++) {
+            fprintf(OUT, "%d %d %.*g\n", r, col[k], std::numeric_limits<T>::max_digits10, (double)value[k]);
+        }
+    }
+    if (fclose(OUT)!=0) {
+        printf("ERROR(SparseMatrix writeText): unable to write file \"%s\"\n", filename.c_str());
+        exit(1);
+    }
+}
+
+
+// Binary sparse matrix file:
+//
+//   header     64 bytes (SparseFileHeader below)
+//   rowStart   rows+1 long longs
+//   col        nonZero ints
+//   value      nonZero elements of elementBytes each
+//
+struct SparseFileHeader {
+    char magic[4];               // "MATS"
+    unsigned int endian;         // matFileEndian in the byte order of the writer
+    unsigned int version;        // matFileVersion
+    unsigned int elementBytes;   // the dtype: 4 for float, 8 for double
+    long long rows, cols;
+    long long nonZero;
+    long long reserved[3];       // 0
+};
+
+
+template <class T>
+void SparseMatrixT<T>::writeBinary(std::string filename) const
+{
+    SparseFileHeader h;
+    FILE *OUT;
+    bool ok;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "MATS", 4);
+    h.endian = matFileEndian;
+    h.version = matFileVersion;
+    h.elementBytes = sizeof(T);
+    h.rows = maxr;
+    h.cols = maxc;
+    h.nonZero = value.size();
+
+    OUT = fopen(filename.c_str(), "wb");
+    if (OUT==NULL) {
+        printf("ERROR(SparseMatrix writeBinary): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+    ok = fwrite(&h, sizeof(h), 1, OUT)==1;
+    ok = ok && fwrite(rowStart.data(), sizeof(long long), rowStart.size(), OUT)==rowStart.size();
+    if (!value.empty()) {    // the vectors of an all zero matrix may have no storage at all
+        ok = ok && fwrite(col.data(), sizeof(int), col.size(), OUT)==col.size();
+        ok = ok && fwrite(value.data(), sizeof(T), value.size(), OUT)==value.size();
+    }
+    if (fclose(OUT)!=0) ok = false;
+    if (!ok) {
+        printf("ERROR(SparseMatrix writeBinary): unable to write file \"%s\"\n", filename.c_str());
+        exit(1);
+    }
+}
+
+
+template <class T>
+void SparseMatrixT<T>::readBinary(std::string filename)
+{
+    MatrixBase::ProfileScope prof("sparse readBinary", name);
+    SparseFileHeader h;
+    FILE *IN;
+    double fileBytes;
+    const char *problem = NULL;
+
+    IN = fopen(filename.c_str(), "rb");
+    if (IN==NULL) {
+        printf("ERROR(SparseMatrix readBinary): Trying to open file \"%s\" but failed.\n", filename.c_str());
+        exit(1);
+    }
+    fseek(IN, 0, SEEK_END);
+    fileBytes = ftell(IN);
+    fseek(IN, 0, SEEK_SET);
+
+    if (fread(&h, sizeof(h), 1, IN)!=1) memset(&h, 0, sizeof(h));
+    if (memcmp(h.magic, "MATS", 4)!=0) problem = "is not a binary sparse matrix file";
+    else if (h.endian!=matFileEndian) problem = "was written on a machine with the other byte order";
+    else if (h.version!=matFileVersion) problem = "has a version this library does not know";
+    else if (h.elementBytes!=sizeof(float) && h.elementBytes!=sizeof(double)) problem = "has an unknown element type";
+    else if (h.rows<0 || h.cols<0 || h.rows>=INT_MAX || h.cols>INT_MAX || h.nonZero<0) problem = "has a bad size";
+    else if (sizeof(h) + (double)(h.rows+1)*sizeof(long long) + (double)h.nonZero*(sizeof(int) + h.elementBytes) > fileBytes) {
+        problem = "is too short";
+    }
+
+    if (problem==NULL) {
+        maxr = h.rows;
+        maxc = h.cols;
+        rowStart.resize(maxr+1);
+        col.resize(h.nonZero);
+        value.resize(h.nonZero);
+        if (fread(rowStart.data(), sizeof(long long), rowStart.size(), IN)!=rowStart.size()) problem = "is too short";
+    }
+    if (problem==NULL && h.nonZero>0) {
+        if (fread(col.data(), sizeof(int), col.size(), IN)!=col.size()) problem = "is too short";
+        if (h.elementBytes==sizeof(T)) {
+            if (fread(value.data(), sizeof(T), value.size(), IN)!=value.size()) problem = "is too short";
+        }
+        else if (h.elementBytes==sizeof(float)) {
+            std::vector<float> x(h.nonZero);
+
+            if (fread(x.data(), sizeof(float), x.size(), IN)!=x.size()) problem = "is too short";
+            for (size_t k=0; k<x.size(); k++) value[k] = x[k];
+        }
+        else {
+            std::vector<double> x(h.nonZero);
+
+            if (fread(x.data(), sizeof(double), x.size(), IN)!=x.size()) problem = "is too short";
+            for (size_t k=0; k<x.size(); k++) value[k] = x[k];
+        }
+    }
+    fclose(IN);
+
+    // the offsets must climb to nonZero and the columns climb along each row
+    if (problem==NULL && (rowStart[0]!=0 || rowStart[maxr]!=h.nonZero)) problem = "has bad row offsets";
+    for (int r=0; problem==NULL && r<maxr; r++) {
+        if (rowStart[r+1]<rowStart[r]) problem = "has bad row offsets";
+        for (long long k=rowStart[r]; problem==NULL && k<rowStart[r+1]; k++) {
+            if (col[k]<0 || col[k]>=maxc || (k>rowStart[r] && col[k]<=col[k-1])) problem = "has bad columns";
+        }
+    }
+
+    if (problem!=NULL) {
+        printf("ERROR(SparseMatrix readBinary): file \"%s\" %s\n", filename.c_str(), problem);
+        exit(1);
+    }
+}
+
+
+template <class T>
+void SparseMatrixT<T>::printSize(std::string msg) const
+{
+    if (msg.length()) {
+        printf("%s ", msg.c_str());
+    }
+
+    if (name.length()) {
+        printf("(size of %s: %d X %d  nonzeros: %lld)\n", name.c_str(), maxr, maxc, (long long)value.size());
+    }
+    else {
+        printf("(size: %d X %d  nonzeros: %lld)\n", maxr, maxc, (long long)value.size());
+    }
+    fflush(stdout);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // 
+//
+// the element types compiled into the library
+//
+template class MatrixT<double>;
+template class MatrixT<float>;
+template class MatrixRowIterT<double>;
+template class MatrixRowIterT<float>;
+template class MatrixRowStreamT<double>;
+template class MatrixRowStreamT<float>;
+template class CovAccumulatorT<double>;
+template class CovAccumulatorT<float>;
+template class MatrixSolverT<double>;
+template class MatrixSolverT<float>;
+template class SparseMatrixT<double>;
+template class SparseMatrixT<float>;
+template MatrixT<double>::MatrixT(const MatrixT<float> &other, std::string namex);
+template MatrixT<float>::MatrixT(const MatrixT<double> &other, std::string namex);
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // 
+//
+// Some random tests for the matrix code
+//
+
+
+
+/* UNCOMMENT TO HAVE A MAIN FOR TESTING
+
+int main()
+{
+    Matrix z(3331, 3);
+
+    initRand();
+
+    z.rand(0, 3);
+    z.sortRows();
+    z.print();
+    return 0;
+}
+*/
+/*
+double f(double x) { return (x>10 ? 1.0 : 0.0); };
+
+double yvalues[] = {2, 3, 5, 7, 11, 13};
+
+int main()
+{
+    Matrix x(10, 20);
+    Matrix z("dogs");
+    Matrix y(2, 3, yvalues, "cats");
+    Matrix a, b;
+
+    Matrix xx = new Matrix(3, 4);
+
+    initRand();
+
+    y.print("matrix y");
+//    z.print(); // undefined
+//    x.print("matrix x");  // undefined
+//    y.dot(y);   // wrong sizes
+    
+    printf("Supply a 3x3 or larger matrix to read:\n");
+    x.read();
+
+    printf("Read Matrix\n");
+    x.write();
+
+    a = x.transpose();
+    printf("Transpose\n");
+    a.write();
+
+    a.mult(a);
+    printf("Squared\n");
+    a.write();
+
+    b = a.extract(1, 1, 2, 1);
+    printf("Extracted\n");
+    b.write();
+
+    a.insert(b, 0, 0);
+    printf("Inserted\n");
+    a.write();
+
+    printf("\n");
+    x.print();
+    printf("\n");
+    a.print();
+    printf("\n");
+    b.print();
+    printf("\n");
+
+    (x.extract(0, 2, 0, 0)).print();
+    printf("\n");
+
+    printf("\n");
+    (x.extract(0, 0, 0, 2)).print();
+    printf("\n");
+
+    printf("Map\n");
+    x.map(f);
+    x.write();
+    printf("\n");
+
+    printf("Random -1.0 to 1.0\n");
+    x.rand(-1.0, 1.0);
+    x.write();
+    printf("\n");
+
+    printf("Normalize\n");
+    x.write();
+    printf("\n");
+    a = x.normalizeCols();
+    x.write();
+    printf("\n");
+    a.write();
+    printf("\n");
+    b.normalizeCols(a);
+    b.write();
+    printf("\n");
+
+    printf("Random -5.0 to 10.0\n");
+    x.rand(-5.0, 10.0);
+    x.write();
+    printf("\n");
+
+    printf("Random -5 to 10\n");
+    x.rand(-5, 10);
+    x.write();
+    printf("\n");
+
+    printf("Random 0 to 6\n");
+    x.rand(0, 6);
+    printf("X\n");
+    x.write();
+    printf("\n");
+
+    // print b
+    b = x.transpose();
+    printf("B\n");
+    b.write();
+    printf("\n");
+
+    // print x . b
+    printf("X.B\n");
+    a = x.dot(b);
+    a.write();
+    printf("\n");
+
+    // print b . x
+    printf("B.X\n");
+    a = b.dot(x);
+    a.write();
+
+    // constant
+    a.constant(3.14159265);
+    a.write();
+
+    {
+        Matrix m(5, 3);
+
+        initRand();
+
+        m.rand(0, 10);
+        m.print("");
+
+        MatrixRowIter a(&m);
+        for (Matrix *i = a.rowBegin(); a.rowNotEnd(); a.rowNext()) {
+            i->print("");
+        }
+
+        return 0;
+    }
+}
+*/
+/*
+double yvalues[] = {2, 3, 5, 7, 11, 13};
+
+int main()
+{
+    Matrix y(2, 3, yvalues, "cats");
+    Matrix x(2, 3, yvalues, "newCats");
+    Matrix z(10, 3, "sample");
+
+    initRand();
+
+    y.print();
+    x.print();
+
+    (x.Tdot(y)).print();
+    x.print();
+    x.write();
+
+    x.sample(z);
+    z.print();
+
+    return 0;
+}
+
+*/
+
+/*
+double yvalues[] =  {5, 0, 3, 7, 1, -5, 7, 3, 4, 9, 8, 10};
+double avalues[] = {2, 0, -9, 3, 4, 1};
+double bvalues[] = {5, 2, 6, -4, 4, 9};
+double cvalues[] = {2, 0, -9, 3, 4, 1};
+double dvalues[] = {5, 2, 6, 8, -4, 4, 9, 7};
+double evalues[] = {1, 1, 2, 2, 3, 1, 4, 2, 5, 1};
+
+int main()
+{
+//    Matrix::debug = true;
+    Matrix x(3, 4,  yvalues, "x");
+    Matrix a(2, 3, avalues, "a");
+    Matrix b(2, 3, bvalues, "b");
+    Matrix c(2, 3, cvalues, "c");
+    Matrix d(2, 4, dvalues, "d");
+    Matrix e(5, 2, evalues, "e");
+    Matrix y("y");
+
+    x.print();
+    x.subMatrix(1, 1, 2, 2).transposeSelf();
+    x.print();
+
+    e.print();
+    e.subMatrixEq(1, 1).print();
+    e.subMatrixEq(1, 3).print();
+    e.subMatrixNeq(0, 3).print();
+    printf("%d\n", e.countNeqCol(0, 1));
+    printf("%d\n", e.countNeqCol(0, 2));
+    printf("%d\n", e.countNeqCol(0, 3));
+    printf("%d\n", e.countNeqCol(0, 8));
+
+    x.cov().print("cov(x)");
+    {
+        y = e.cov();
+    }
+    y.print();
+
+    a.print();
+    b.print();
+    a.cov(b).print("cov(a, b)");
+    b.cov(a).print("cov(b, a)");
+
+    c.print();
+    d.print();
+    c.cov(d).print("cov(c, d)");
+    d.cov(c).print("cov(d, c)");
+
+    return 0;
+}
+*/
+/*
+int main()
+{
+    Matrix pic(300, 300, "picture");
+
+    for (int c=0; c<pic.numCols(); c++) {
+        pic.constantColRange(c, 0, 1);
+    }
+    pic.writeImagePgm("zfade.pgm", "fade.pgm");
+
+    pic.readImagePgm("znano.pgm", "nano");
+    pic.print();
+
+    pic.readImagePgm("mondrianRedBlueAndYellow.pgm", "mondrian");
+
+    pic.readImagePpm("mondrianRedBlueAndYellow.ppm", "mondrian");
+    pic.writeImagePgm("zm.pgm", "mondrian.pgm");
+
+    pic.readImagePpm("girlWithPearlEarringSm.ppm", "mondrian");
+    pic.writeImagePgm("zg.pgm", "girl with pearl earring color");
+
+//    pic.readImagePgm("z.pgm", "mondrian").printInt();
+}
+*/
+
+/*
+int main()
+{
+    Matrix data("data");
+    char **labels;
+    
+    labels = data.readLabeledRow();
+
+    data.print();
+    data.printLabeledRow(labels);
+
+    data.sortRowsByCol(1);
+    data.print();
+    data.printLabeledRow(labels);
+
+    return 0;
+}
+*/    
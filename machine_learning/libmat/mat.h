@@ -0,0 +1,1213 @@
+#ifndef MATH
+#define MATH
+
+// // // // // // // // // // // // // // // // 
+//
+// Some simple matrix operators.
+//
+//
+// These routines are self contained except for random number generation.
+// Comment these out if you want completely stand-alone functionality.
+// Uses some code from Numerical Recipes (see comments).  This code is NOT
+// designed to be blindingly fast but rather just get the job done.  The
+// variable Matrix::debug can be set to true if you want to debug memory
+// allocation to look for overallocation of matrices and memory leaks.
+// The variable Matrix::contiguous (default true) makes each matrix one
+// 64 byte aligned block with a fixed row stride rather than one block per
+// row.  Set it to false before allocating to get the old behavior.
+// Large operations are split across a shared pool of threads; see
+// Matrix::setThreads().  The answers do not depend on the thread count.
+// MatrixF is the same class holding floats (see class Matrix below).
+// Every tool in machine_learning links this one copy as libmat (see
+// the makefile here); the SIMD kernels are picked at run time.
+// NOTE: most routines overwrite self with the answer.  For example: add
+// adds to self.  See further in this comment block.
+//
+// Author: Robert B. Heckendorn, University of Idaho, 2018
+// Version: 2.5
+// Date: Apr 7, 2018
+
+// IMPORTANT: If running on MICROSOFT WINDOWS uncomment this define statement!
+// #define WINDOWS
+
+// 
+// Most matrix library routines replace the contents of the matrix
+// object (overwrite self).  That is: X.sub(Y) will replace X with X - Y.
+//
+// Only the following routines allocate a new matrix leaving the original
+// matrix untouched.  For these routines you need to assign the result
+// to a new matrix: X = Y.dot(Z)
+// or print them out: Y.dot(Z).print()
+// The assignment moves the new matrix into X (no element by element copy).
+// 
+// argMinRow()
+// cartesianRow(double (*f)(int size, double *x, double *y), Matrix &other)
+// columnStats()
+// cholesky() // DANGER this replaces the object
+// cov()
+// cov(Matrix &other)
+// covUnbiased()
+// dot(const Matrix &other)
+// dotT(const Matrix &other)
+// Tdot(const Matrix &other)
+// eigenSystem() // DANGER this replaces the object AND returns a new matrix
+// eigenSystemTopK(int k, double tol) // DANGER as eigenSystem() but only the top k
+// extract(int minr, int minc, int sizer, int sizec)
+// meanVec()
+// minRow()
+// pickRows(int match, const Matrix &list, int &num)
+// stddevVec()
+// transpose()
+// 
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <vector>      // supports submatrices
+#include <string>      // matrix names are strings
+#include <functional>  // pieces of work handed to the thread pool
+#include <type_traits> // matrix expression operators
+#include "rand.h"      // portable random number generator.  Include exactly
+                       // ONE of the random number cpp files in your compile
+template <class T> class MatrixT;
+template <class E> class MatrixExpr;
+template <class T> class MatrixRowStreamT;
+template <class T> class MatrixStreamReader;
+template <class T> class CovAccumulatorT;
+template <class T> class MatrixSolverT;
+template <class T, int R, int C> class FixedMatrixT;
+template <class T> class SparseMatrixT;
+typedef MatrixT<double> Matrix;     // the usual matrix of doubles
+typedef MatrixT<float> MatrixF;     // half the memory when float precision is enough
+
+// // // // // // // // // // // // // // // // 
+//
+// class MatrixRowIter
+//
+// Iterator for incrementing through rows in a matrix
+//
+template <class T>
+class MatrixRowIterT {
+private:
+    MatrixT<T> *mat;
+    int r;
+    MatrixT<T> *arow;
+    bool more;
+
+public:
+    MatrixRowIterT(MatrixT<T> *mat);
+    ~MatrixRowIterT();
+
+public:
+    MatrixT<T> *rowBegin();
+    MatrixT<T> *rowNext();
+    bool rowNotEnd();
+    int row();
+};
+
+typedef MatrixRowIterT<double> MatrixRowIter;
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class MatrixWorkspace
+//
+// While a workspace is in scope the storage of each new matrix comes from
+// it and goes back to it when the matrix is freed, ready for the next
+// matrix of the same size.  A loop that makes the same temporaries each
+// time around stops going to the heap after the first time:
+//
+//     {
+//         MatrixWorkspace ws;
+//         for (...) { H = S.dot(V); ... }
+//         ws.printStats("training");
+//     }   // all the storage the workspace holds is freed here
+//
+// A matrix that outlives the workspace keeps its storage and frees it as
+// usual.  Workspaces nest (the newest one is used) and belong to the
+// thread that made them.  Only contiguous storage (see Matrix::contiguous)
+// comes from a workspace.
+//
+class MatrixWorkspace {
+public:
+    MatrixWorkspace();
+    ~MatrixWorkspace();
+
+    unsigned long long hits;     // matrices given storage that was used before
+    unsigned long long misses;   // matrices given new storage from the heap
+    size_t bytes;                // storage held: in use or waiting to be reused
+    size_t peakBytes;            // the most storage ever held
+    void resetStats();           // zero hits and misses and start peakBytes over
+    void printStats(std::string msg="");   // print the four stats above
+
+    // used by Matrix: storage from the workspace in scope (else the heap) and back
+    static void *take(size_t n);
+    static void give(void *p);
+
+private:
+    MatrixWorkspace *outer;      // the workspace in scope before this one
+    std::vector<void *> held;    // every block it has made
+    std::vector<void *> spare;   // one free block of each size (the rest are linked to it)
+
+    MatrixWorkspace(const MatrixWorkspace &);             // no copies
+    MatrixWorkspace &operator=(const MatrixWorkspace &);
+};
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class Matrix
+//
+// A simple class for matrix operations.  It has some nice debugging
+// features like trying hard to check that the proper dimensions are used.
+// It is very draconian about this so there is an important different
+// between row vectors and column vectors.  I find this helps students get
+// the math to work out correctly if you pay attention to this difference.
+// The routines allow you to name a matrix.  The name is then used in debug
+// output.  Other things checked include referencing out of bounds.
+//
+// The element type is a template parameter.  Matrix holds doubles and
+// MatrixF holds floats.  Numbers still go in and out as doubles (get, set,
+// max, sum, ...) so the two are used the same way.  Statistics are summed in
+// double but the products (dot, dotT, Tdot) of a MatrixF are done in float.
+// Convert explicitly from one to the other: MatrixF f(d); Matrix d2(f);
+//
+
+// the settings and counters shared by every element type
+class MatrixBase {
+public:
+    static bool debug;      // debugging flag
+    static bool contiguous; // storage mode: true means one aligned block, false means one block per row
+    static unsigned long long allocations;  // number of times space for a matrix was allocated
+    static unsigned long long copies;       // number of element by element copies of a whole matrix
+    static unsigned long long moves;        // number of times storage was moved rather than copied
+    static void resetCounts();              // zero the three counters above
+    static void printCounts(std::string msg="");  // print the three counters above
+
+    // Profiling.  When profile is true the storage allocated, live and at
+    // its peak plus the copies are kept for each matrix name, and the time
+    // spent in the bigger operations (dot, cov, map, sort, read, ...) for
+    // each operation and name.  Only the outermost operation is timed so a
+    // cov that calls Tdot is counted once.  Setting MAT_PROFILE=text or
+    // MAT_PROFILE=json in the environment turns profiling on and prints
+    // the report to stderr at exit.
+    static bool profile;                    // profiling flag
+    static void resetProfile();             // zero the profile (storage still live is kept)
+    static void printProfile(bool json=false, FILE *fp=stdout);  // report sorted by time and by bytes
+
+    // times one operation on a named matrix while it is in scope
+    class ProfileScope {
+    public:
+        ProfileScope(const char *op, const std::string &name) : started(false) { if (profile) begin(op, name); }
+        ~ProfileScope() { if (started) end(); }
+    private:
+        const char *op;
+        const std::string *name;
+        double start;
+        bool started;
+        void begin(const char *opx, const std::string &namex);
+        void end();
+    };
+
+    // SIMD kernels for dot, dotT and Tdot.  By default (SIMD_AUTO) the best
+    // the CPU supports is used.  Setting simd lower forces a simpler kernel.
+    enum SimdLevel { SIMD_AUTO=-1, SIMD_NONE=0, SIMD_SSE2=1, SIMD_AVX2=2, SIMD_AVX512=3 };
+    static int simd;                        // highest SimdLevel to use
+    static const char *simdName();          // name of the kernel actually in use
+
+    // the rows of the matrix Matrix::columnStats returns
+    enum ColumnStat { STAT_MEAN=0, STAT_VARIANCE, STAT_MIN, STAT_MAX, STAT_NONZERO, STAT_ROWS };
+
+    // threads used by the bigger operations (dot, cov, meanVec, map, add, ...)
+    static void setThreads(int n);          // n<=0 means MAT_THREADS from the environment or else all cores
+    static int numThreads();                // number of threads that will be used
+
+    static void exprSizeError(const char *op, int lr, int lc, int rr, int rc);  // report mismatched sizes in a matrix expression
+
+protected:
+    static void parallelRows(int n, double work, const std::function<void(int lo, int hi)> &body);
+
+    // used when profile is true: storage of a matrix made, freed or copied
+    static void profileAlloc(const void *block, const std::string &name, size_t bytes);
+    static void profileFree(const void *block);
+    static void profileCopy(const std::string &name);
+};
+
+
+template <class T>
+class MatrixT : public MatrixBase {
+template <class U> friend class MatrixRowIterT;
+template <class U> friend class MatrixRowStreamT;
+template <class U> friend class MatrixStreamReader;
+template <class U> friend class CovAccumulatorT;
+template <class U> friend class MatrixSolverT;
+template <class U, int R, int C> friend class FixedMatrixT;
+template <class U> friend class SparseMatrixT;
+template <class U> friend class MatrixT;
+template <class U> friend class MatrixLeaf;
+private:
+    bool defined;           // does it have rows and cols defined
+    bool submatrix;         // if submatrix then it does NOT own the row content of m (see deallocate)!!
+    int maxr, maxc;
+    int stride;             // distance in elements from one row to the next in data
+    T *data;                // aligned block the rows point into or NULL if rows allocated one by one
+    T **m;                  // the data (a pointer to each row)
+    void *mapping;          // the mapped file data points into or NULL (see mapBinary)
+    size_t mappingBytes;    // size of mapping
+    std::string name;       // the name of the matrix or ""
+
+private:  // private methods
+    void allocate(int r, int c, std::string namex, bool isSubMatrix=false);
+    bool deallocate();
+    void reallocate(int othermaxr, int othermaxc, std::string namex);
+    void stealStorage(MatrixT &other);
+    void prepareInto(const MatrixT &other, MatrixT &out, int r, int c, double beta, const char *msg) const;
+    template <class E> void evalExpr(const E &e);
+
+// constructors
+public:
+    MatrixT(std::string namex="");
+    MatrixT(int r, std::string namex="");                           // create a subMatrix columns unallocated
+    MatrixT(int r, int c, std::string namex="");
+    MatrixT(int r, int c, double initValue, std::string namex="");  // create and initialize
+    MatrixT(int r, int c, double *data, std::string namex="");      // create and initialize from array
+    MatrixT(const MatrixT &other, std::string namex="");            // copy constructor
+    MatrixT(MatrixT *other);                                        // for convenience
+    MatrixT(MatrixT &&other);                                       // move constructor (steals the storage of other)
+    template <class U> explicit MatrixT(const MatrixT<U> &other, std::string namex="");  // convert element type, e.g. MatrixF f(d)
+    ~MatrixT();
+    MatrixT &operator=(const MatrixT &other);
+    MatrixT &operator=(MatrixT &&other);                            // move assignment (steals the storage of other)
+    template <class E> MatrixT(const MatrixExpr<E> &e, std::string namex=""); // evaluate an expression (see Matrix expressions)
+    template <class E> MatrixT &operator=(const MatrixExpr<E> &e);            // evaluate an expression into self
+
+// basic error checking support
+public:
+    void checkBounds(int r, int c, const char *msg) const;   // msg is a char * so the check costs nothing when it passes
+    void assertColVector(std::string) const;
+    void assertColsEqual(const MatrixT &other, std::string msg) const;
+    void assertDefined(std::string msg) const;
+    void assertRowIndexOK(int r, std::string msg) const;
+    void assertColIndexOK(int c, std::string msg) const;
+    void assertIndexOK(int, int, std::string) const;
+    void assertOtherLhs(const MatrixT &other, std::string msg) const;
+    void assertOtherSizeMatch(const MatrixT &other, std::string msg) const;
+    void assertRowVector(std::string) const;
+    void assertRowsEqual(const MatrixT &other, std::string msg) const;
+    void assertSize(int r, int c, std::string msg) const;
+    void assertUsableSize(std::string msg) const;
+    void assertSquare(std::string msg) const;
+
+public:  // auxillary routines but not private (for speed, they do not check self!!)
+    void swapRows(int i, int j);                  // utility to swap two rows
+    bool lessRows(int i, int j) const;            // utility to compare two rows
+
+// accessors
+public: 
+    int maxRows() const { return maxr; }  // DEPRICATED
+    int maxCols() const { return maxc; }  // DEPRICATED
+    int numRows() const { return maxr; }
+    int numCols() const { return maxc; }
+    double get(int r, int c) const;      // get element value
+    double inc(int r, int c);            // increment element
+    double dec(int r, int c);            // decrement element
+    double set(int r, int c, double v);  // set element
+    bool isContiguous() const;           // are the rows in order in one block with a fixed stride?
+    int rowStride() const { return stride; }  // distance in doubles between rows (if contiguous)
+    void setDefined();                   // make defined when you *KNOW* the array has been defined by other means
+    void setName(std::string newName);   // set matrix name
+    const std::string &getName(const std::string &defaultName="") const;
+    void narrow(int newMaxCol);          // remove trailing columns (without proper deallocation)
+    void shorten(int newMaxRow);         // remove trailing rows (without proper deallocation)
+
+// operations on matrices
+public: 
+    bool isRowVector() const { return defined && maxr==1; }  // exactly one row
+    bool isColVector() const { return defined && maxc==1; }  // exactly one col
+    bool equal(const MatrixT &other) const;      // are the two matrices equal?
+    bool nearEqual(double epsilon, const MatrixT &other) const; // matrices nearly equal?
+    int countGreater(const MatrixT &other) const; // count number of elements >
+    void argMax(int &r, int &c) const;           // what location is the largest in whole array
+    void argMin(int &r, int &c) const;           // what location is the smallest in whole array
+    MatrixT argMinRow() const;                   // constructs a column vector of the argmin in each row
+    MatrixT minRow() const;                      // constructs a column vector of the min in each row
+    double max() const;                          // minimum in whole array
+    double min() const;                          // maximum in whole array
+    double mean() const;                         // mean of whole array
+    double maxCol(int c) const;                  // maximum value in a column
+    double minCol(int c) const;                  // minimum value in a column
+    double meanCol(int c) const;                 // mean in a column
+    double stddevCol(int c) const;               // standard deviation in a column
+    int countEqCol(int c, double value) const;   // count number of items in column c equal to value
+    int countNeqCol(int c, double value) const;  // count number of items in column c not equal to value
+    double dist2(const MatrixT &other) const;    // *SQUARE* of distance between two matrices
+    MatrixT pickRows(int match, const MatrixT &list, int &num);    // pick rows which have list value == match
+    double dot(int r, int c, const MatrixT &other) const; // dot of row of this with col of other -> double 
+    double dist2(int r, int c, const MatrixT &other) const; // *SQUARE* of distance between row of this with col of other
+
+    // element by element operators (modifies self)
+    MatrixT &abs();
+    MatrixT &add(const MatrixT &other);
+    MatrixT &sub(const MatrixT &other);
+    MatrixT &mult(const MatrixT &other);
+    MatrixT &div(const MatrixT &other);
+
+    MatrixT &swap(MatrixT &other);  // swaps two matrices so also modifies other (O(1) unless a subMatrix)
+    MatrixT &rowInc(int r);         // increment the values in a given row by 1
+
+    // scalar operators
+    MatrixT &constant(double x);           // this can be used to zero a matrix
+    MatrixT &constantDiagonal(double x);   // this can be used to set the diagonal to a constant but does set rest of matrix
+    MatrixT &constantCol(int c, double x); // this can be used to zero a column
+    MatrixT &constantColRange(int c, double start, double step);  // assign all elements in col range starting at start and going by step
+    MatrixT &identity();                   // convert to an identity matrix  (must be square)
+    MatrixT &scalarMult(double x);         // multiply all elements by x
+    MatrixT &scalarAdd(double x);          // add to all elements x
+    MatrixT &scalarPreSub(double x);       // NOTE: this is x - self   not   self - x, can be used to negate
+    MatrixT &scalarPostSub(double x);      // NOTE: this is self - x
+
+    // Vector operations
+    MatrixT &divColVector(const MatrixT &other);
+    MatrixT &multColVector(const MatrixT &other);
+
+    MatrixT &divRowVector(const MatrixT &other); // self[r] / (row vector other) for each row
+    MatrixT &multRowVector(const MatrixT &other); // self[r] * (row vector other) for each row
+    MatrixT &addRowVector(const MatrixT &other); // self[r] + (row vector other) for each row
+    MatrixT &subRowVector(const MatrixT &other); // self[r] - (row vector other) for each row
+    MatrixT &addRowVector(int r, const MatrixT &other); // add row vector matrix in other to the given row of self
+    
+    // min/max normalization by columns
+    MatrixT normalizeCols();                      // normalize and return array of min and max of each col
+    MatrixT &normalizeCols(MatrixT &minMax);      // normalize based on an array of min and max for each col
+
+    // mapping functions
+    MatrixT &map(double (*f)(double x));             // apply given function to all elements (f must be thread safe)
+    MatrixT &mapCol(int c, double (*f)(double x));   // apply given function to all elements in col c
+    MatrixT &mapIndex(double (*f)(int r, int c, double x)); // apply function to (index, element)
+    MatrixT cartesianRow(double (*)(int, T*, T*), MatrixT&); // apply given function to the cartesian product of two vectors of row vectors
+    template <class F> MatrixT &map(F f);            // same as above for any callable (lambda, functor) so f can be inlined
+    template <class F> MatrixT &mapCol(int c, F f);
+    template <class F> MatrixT &mapIndex(F f);
+
+    // activation functions (vectorized, see mat.cpp for the accuracy)
+    MatrixT &mapLogistic(double slope=1.0);          // 1/(1 + exp(-slope x))
+    MatrixT &mapTanh();                              // tanh(x)
+    MatrixT &mapStep(double threshold=0.0);          // 0 if x < threshold else 1
+
+    // random initialization (random number generator must be initialized with initRand() )
+    MatrixT &randCol(int c, double min, double max); // random reals in a column
+    MatrixT &rand(double min, double max);           // random reals in range 
+    MatrixT &rand(int min, int max);                 // random integers in range
+
+    // insertion and extraction
+    MatrixT &sample(MatrixT &out); // extract random rows with replacement into existing matrix out
+    MatrixT &extract(int minr, int minc, int sizer, int sizec, MatrixT &out); // extract into existing matrix out (see other versions of extract)
+    MatrixT &insert(const MatrixT &other, int minr, int minc);  // insert the matrix at minr, minc.   Overflow is ignored.
+    template <int R, int C> MatrixT &insert(const FixedMatrixT<T, R, C> &other, int minr, int minc);  // insert a fixed matrix (must fit)
+    MatrixT &insertRowVector(int row, const MatrixT&);
+
+    // products into an existing matrix out: out = alpha op(self) op(other) + beta out
+    // e.g. the weight update W -= eta H^T D is H.TdotInto(D, W, -eta, 1.0) with no temporaries.
+    // If beta is 0 out is only written (and resized if needed).  out can not be self or other.
+    MatrixT &dotInto(const MatrixT &other, MatrixT &out, double alpha=1.0, double beta=0.0) const;   // self * other
+    MatrixT &dotTInto(const MatrixT &other, MatrixT &out, double alpha=1.0, double beta=0.0) const;  // self * Transpose(other)
+    MatrixT &TdotInto(const MatrixT &other, MatrixT &out, double alpha=1.0, double beta=0.0) const;  // Transpose(self) * other
+
+    // input/output
+    void print(std::string msg="") const;      // print matrix and its name
+    void printInt(std::string msg="") const;   // print matrix as integers (it will error if not.)
+    void printLabeledRow(char **labels, std::string msg="") const;   // print matrix with rows labeled
+    void printSize(std::string msg="") const;  // print just the matrix size
+    void write();                        // write out matrix in a form that can be read in
+    void writeLine(int r);               // write out an unadorned row
+    void read();                         // read in a matrix
+    char **readLabeledRow();             // read in a matrix plus row labels
+    bool readText(FILE *fp, std::string &error, char ***labels=NULL);   // read (a labeled matrix if labels) but give any problem in error rather than exit
+    bool readText(std::string filename, std::string &error, char ***labels=NULL);  // readText from the named file
+
+    // binary files: much faster than the text form (see mat.cpp for the layout)
+    // Row labels are optional.  The label of row r is labels[(int)get(r, 0)].
+    void writeBinary(std::string filename, char **labels=NULL) const;  // write matrix plus optional row labels
+    char **readBinary(std::string filename);   // read a binary file (either element type) into self
+    char **mapBinary(std::string filename);    // map a binary file into self with no copying (element type must match)
+
+    // WARNING: The following CONSTRUCT TO NEW MATRIX for the answer  (BEWARE MEMORY LEAKS!)
+    // NOTE: the result of these functions should be used somewhere like in an assignment
+    //  e.g. a.dot(b) is probably wrong.   while x = a.dot(b) stores the result.
+    MatrixT extract(int minr, int minc, int sizer, int sizec);
+    MatrixT extractStride(int minr, int minc, int stepr, int stepc);
+    MatrixT transpose();                   // classic transpose into new matrix (see transposeSelf below)
+    MatrixT dot(const MatrixT &other);     // classic matrix multiply, inner product
+    MatrixT dotT(const MatrixT &other);    // classic matrix multiply self * Transpose(other)
+    MatrixT Tdot(const MatrixT &other);    // classic matrix multiply Transpose(self) * other
+    MatrixT meanVec();                     // creates a row vector of means of columns
+    MatrixT stddevVec();                   // creates a row vector of standard deviations of columns
+    MatrixT columnStats();                 // one pass for the mean, variance, min, max and nonzeros of columns (see ColumnStat)
+    MatrixT cov();                         // covariance matrix (BIASED covariance)
+    MatrixT covUnbiased();                 // covariance matrix (UNBIASED: divides by n-1)
+    MatrixT cov(MatrixT &other);           // covariance matrix (BIASED covariance)
+
+    // alternation versions of operaters that DO NOT create new matrices
+    MatrixT &transposeSelf();               // transpose in place of SQUARE MATRIX
+
+    // special operators (destroys arguments).  To solve with the same
+    // matrix many times use MatrixSolver which factors it only once.
+    int *LU();                              // LU decomposition with partial pivoting in place (returns the row permutation)
+    MatrixT &cholesky();                    // replace SYMMETRIC POSITIVE DEFINITE self with lower triangular L: L L^T = self
+    MatrixT &solve(MatrixT &B);             // solve Ax = B replacing B with the solutions (self is replaced by its factors)
+    MatrixT &inverse();                     // replace with inverse
+    MatrixT &solveTriangular(MatrixT &B, bool lower, bool transpose=false, bool unitDiagonal=false) const;  // B replaced by x: op(self) x = B
+
+    // eigenSystem() destroys self by replacing self with eigenvectors in rows.
+    // Returns a new matrix with the eigenvalues in it.
+    // Eigenvalues and vectors returned sorted from largest magnitude to smallest
+    // WARNING: allocates new matrix for answer
+    void tridiagonalize(double *&d, double *&e);
+    MatrixT eigenSystem();
+    MatrixT eigenSystemTopK(int k, double tol=1e-10);  // only the k of largest magnitude (self becomes k X n)
+
+    // sorting support
+public:
+    void selectSort(int lower, int upper);
+    void qs(int lower, int upper);
+    void selectSortCol(int c, int lower, int upper);
+    void qsCol(int c, int lower, int upper);
+    void partition3Col(int c, double pivot, int lower, int upper, int &lt, int &gt);
+    void selectCol(int c, int k, int lower, int upper, int depth);
+
+public: 
+    void sortRows();                            // sort rows in place
+    void sortRows(int startRow, int endRow);    // sort rows in place in a range of rows
+    void sortRowsByCol(int c);                  // sort rows in place on given column
+    void sortRowsByCol(int c, int startRow, int endRow);     // sort rows in place in a range of rows
+    void stableSortRowsByCol(int c);            // sort rows on given column keeping the order of equal keys
+    void stableSortRowsByCol(int c, int startRow, int endRow);  // same in a range of rows
+    void selectRowsByCol(int c, int k, int startRow, int endRow);  // row k as if sorted on column c, smaller before and larger after (linear time)
+    int partitionRowsByCol(int c, double pivot);                 // rows with column c < pivot first; returns how many
+    int partitionRowsByCol(int c, double pivot, int startRow, int endRow);  // same in a range of rows returning the first row >= pivot
+
+public:
+    // subMatrices are an efficiency for creating submatrices by pointing into
+    // the parent matrix rather than copying all the contents of the matrix.
+    // Read the warnings in the .cpp file
+    // 
+    MatrixT subMatrix(int minr, int minc, int sizer, int sizec) const; // create a submatrix whose corner is (minr, minc) and size given
+    MatrixT subMatrixEq(int c, double value) const;        // create submatrix with rows whose column c has the given value
+    MatrixT subMatrixNeq(int c, double value) const;       // create submatrix with rows whose column c does not have the given value
+
+    // image (picture) support: pgm (gray) and ppm (color) files with
+    // maximum values up to 65535 (two bytes a sample above 255)
+    // gray is one integer in the range 0-maxval for each pixel
+    // color is three integers in a row in the range 0-maxval for RGB in each pixel.
+    // That is a color square 100x100 pixels gens a 100x300 dimensional array
+private:
+    int pixelValue(double x, int maxval);
+    MatrixT readImage(char *expectedType, char *caller, std::string filename, std::string namex);
+    void writeImage(const char *caller, std::string filename, std::string comment, int channels, int maxval, bool ascii);
+
+public: 
+    MatrixT readImagePgm(std::string filename, std::string namex);  // read a P2 or P5 pgm (gray scale) file into self
+    MatrixT readImagePpm(std::string filename, std::string namex);  // read a P3 or P6 ppm (color)
+    void writeImagePgm(std::string filename, std::string comment, int maxval=255, bool ascii=false);  // write a P5 (or ascii P2) pgm file (gray scale)
+    void writeImagePpm(std::string filename, std::string comment, int maxval=255, bool ascii=false);  // write a P6 (or ascii P3) ppm file (color)
+};
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class MatrixRowStream
+//
+// The rows of a matrix file read a block at a time so a data set bigger
+// than memory can be used.  The file is either the text form of read() or
+// the binary form of writeBinary() (told apart by the first bytes).  While
+// one block is in use the next one is read on a background thread.  Go
+// through the rows just as with MatrixRowIter:
+//
+//     MatrixRowStream s("big.matb");
+//     for (Matrix *row = s.rowBegin(); s.rowNotEnd(); row = s.rowNext()) ...
+//
+// or a block at a time with blockBegin, blockNext and blockNotEnd.  The row
+// and the block point into the stream's buffers (nothing is copied) and
+// are only good until the next call.  Each reduction is a pass over the
+// file (restarting any walk through the rows) and gives the same answer
+// the Matrix routine would for the whole matrix (cov to within rounding
+// since it merges the blocks with a CovAccumulator).  Labels are not
+// supported.
+//
+template <class T>
+class MatrixRowStreamT {
+private:
+    MatrixStreamReader<T> *reader;   // reads the blocks ahead
+    MatrixT<T> *block;       // the block in use (a subMatrix of a buffer of the reader)
+    MatrixT<T> *arow;        // the row in use (a subMatrix of block)
+    int maxr, maxc;          // size of the matrix in the file
+    int blockRows;           // rows in every block but perhaps the last
+    int k;                   // the block in use
+    int r;                   // the row in use in block
+    bool more;
+    bool fresh;              // the reader is at the start and nothing has been taken
+
+    void takeBlock();
+    void pointRow();
+    void columnSums(double *sum);
+
+public:
+    MatrixRowStreamT(std::string filename, int blockRows=4096);
+    ~MatrixRowStreamT();
+
+    int numRows() const { return maxr; }
+    int numCols() const { return maxc; }
+
+public:
+    MatrixT<T> *rowBegin();
+    MatrixT<T> *rowNext();
+    bool rowNotEnd();
+    int row();               // row in the file of the row in use
+
+    MatrixT<T> *blockBegin();
+    MatrixT<T> *blockNext();
+    bool blockNotEnd();
+    int blockRow();          // row in the file of the first row of the block in use
+
+public:
+    MatrixT<T> meanVec();    // row vector of means of columns
+    MatrixT<T> stddevVec();  // row vector of standard deviations of columns
+    MatrixT<T> cov();        // covariance matrix (divides by n like Matrix::cov)
+    MatrixT<T> minMax();     // the min and max of each col as normalizeCols() returns (use with normalizeCols(minMax))
+};
+
+typedef MatrixRowStreamT<double> MatrixRowStream;
+typedef MatrixRowStreamT<float> MatrixRowStreamF;
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class CovAccumulator
+//
+// The mean and covariance of rows that arrive a block at a time, in one
+// pass.  Each block is centered on its own mean, its sums of products are
+// added with the blocked matrix multiply (only the upper triangle is
+// formed) and it is merged with what came before by the pairwise update
+// of Chan, Golub and LeVeque (Welford's update for a block rather than a
+// row).  Rows split over threads go into an accumulator each which are
+// merged at the end:
+//
+//     CovAccumulator a, b;
+//     a.add(firstHalf);  b.add(secondHalf);   // on different threads
+//     a.merge(b);
+//     Matrix c = a.cov();
+//
+// The sums are kept in double for MatrixF as well.  Matrix::cov uses this.
+//
+template <class T>
+class CovAccumulatorT {
+private:
+    int maxc;                // number of columns (0 until the first rows are seen)
+    long long n;             // rows seen
+    double *mean;            // mean of each column
+    double **m2;             // sums of products of deviations from the mean (upper triangle)
+    double *scratch;         // a row of work space for addRow
+
+    void setCols(int c, const char *msg);
+
+public:
+    CovAccumulatorT(int cols=0);
+    ~CovAccumulatorT();
+
+    void clear();                               // forget all rows (keeps the number of columns)
+    void add(const MatrixT<T> &rows);           // add every row of rows
+    void addRow(const MatrixT<T> &rows, int r);  // add row r only (Welford update: O(cols^2))
+    void merge(const CovAccumulatorT &other);   // add the rows other has seen
+
+    long long count() const { return n; }
+    int numCols() const { return maxc; }
+    MatrixT<T> meanVec() const;                 // row vector of means of columns
+    MatrixT<T> cov(bool unbiased=false) const;  // divides by n (like Matrix::cov) or by n-1
+
+private:
+    CovAccumulatorT(const CovAccumulatorT &);   // no copies
+    CovAccumulatorT &operator=(const CovAccumulatorT &);
+};
+
+typedef CovAccumulatorT<double> CovAccumulator;
+typedef CovAccumulatorT<float> CovAccumulatorF;
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class MatrixSolver
+//
+// Factor a square matrix once and then solve with it for as many right
+// hand sides as wanted.  A symmetric positive definite matrix (such as
+// Matrix::cov gives) uses the Cholesky decomposition, anything else LU
+// decomposition with partial pivoting, unless the method is given:
+//
+//     MatrixSolver s(A);
+//     Matrix x = s.solve(b);      // A x = b where each COLUMN of b is a right hand side
+//     Matrix y = s.solve(c);      // no refactoring
+//
+template <class T>
+class MatrixSolverT {
+private:
+    MatrixT<T> factors;      // L and U or the Cholesky factor L
+    int *perm;               // row i of the LU factors is row perm[i] of the matrix
+    int kind;                // 1 for LU and 2 for Cholesky
+
+public:
+    enum Method { SOLVE_AUTO, SOLVE_LU, SOLVE_CHOLESKY };
+
+    MatrixSolverT(const MatrixT<T> &a, int method=SOLVE_AUTO);   // factors a copy of a
+    ~MatrixSolverT();
+
+    bool isCholesky() const { return kind==2; }
+    MatrixT<T> solve(const MatrixT<T> &b) const;   // x such that a x = b
+    MatrixT<T> &solveInPlace(MatrixT<T> &b) const; // replace b with x
+    MatrixT<T> inverse() const;                    // the inverse of a
+    double determinant() const;                    // the determinant of a
+
+private:
+    MatrixSolverT(const MatrixSolverT &);          // no copies
+    MatrixSolverT &operator=(const MatrixSolverT &);
+};
+
+typedef MatrixSolverT<double> MatrixSolver;
+typedef MatrixSolverT<float> MatrixSolverF;
+
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class SparseMatrix
+//
+// A matrix that keeps only its nonzero elements in compressed sparse row
+// (CSR) form: the nonzeros of row r are value[k] in column col[k] for k
+// from rowStart[r] up to rowStart[r+1].  The storage and the time of the
+// products go with the number of nonzeros rather than rows X columns.
+// transpose() of a CSR matrix is its compressed sparse column (CSC) form.
+// Products with dense matrices give dense matrices:
+//
+//     SparseMatrix s(targets);       // the nonzeros of a dense Matrix
+//     Matrix h = s.dot(w);           // s * w
+//     s.TdotInto(delta, w, -eta, 1.0);  // w -= eta Transpose(s) * delta
+//
+// Files: the text form is a line "rows cols nonzeros" and then one line
+// "row col value" for each nonzero (rows and columns counted from 0).
+// The binary form (magic "MATS") holds rowStart, col and value as they
+// are in memory and reads into either element type like Matrix::readBinary.
+//
+template <class T>
+class SparseMatrixT {
+private:
+    int maxr, maxc;                  // size of the matrix
+    std::vector<long long> rowStart; // maxr+1 offsets into col and value
+    std::vector<int> col;            // column of each nonzero, increasing along a row
+    std::vector<T> value;            // each nonzero
+    std::string name;
+
+    void checkDense(const MatrixT<T> &other, int rows, const char *msg) const;
+
+public:
+    SparseMatrixT(std::string namex="");
+    SparseMatrixT(int r, int c, std::string namex="");       // all zeros
+    SparseMatrixT(const MatrixT<T> &dense, double tol=0.0, std::string namex="");  // the elements with |x|>tol
+    SparseMatrixT(int r, int c, const std::vector<int> &rows, const std::vector<int> &cols,
+                  const std::vector<T> &values, std::string namex="");   // triples in any order (repeats are added)
+
+    int numRows() const { return maxr; }
+    int numCols() const { return maxc; }
+    long long numNonZero() const { return (long long)value.size(); }
+    double density() const;                  // fraction of the elements that are nonzero
+    std::string getName() const { return name; }
+    void setName(std::string newName) { name = newName; }
+
+    double get(int r, int c) const;          // any element (zero if not kept)
+    int rowNonZero(int r) const { return (int)(rowStart[r+1] - rowStart[r]); }
+    const int *rowCols(int r) const { return col.data() + rowStart[r]; }      // columns of the nonzeros in row r
+    const T *rowValues(int r) const { return value.data() + rowStart[r]; }    // the nonzeros in row r
+
+    MatrixT<T> toDense(std::string namex="") const;            // all the elements
+    SparseMatrixT extractRows(int minr, int sizer) const;       // rows minr ... minr+sizer-1
+    SparseMatrixT pickRows(const std::vector<int> &rows) const; // the given rows in the given order
+    SparseMatrixT transpose() const;                            // the CSC form of self as CSR
+
+    MatrixT<T> dot(const MatrixT<T> &other) const;              // self * other
+    MatrixT<T> Tdot(const MatrixT<T> &other) const;             // Transpose(self) * other
+    MatrixT<T> &dotInto(const MatrixT<T> &other, MatrixT<T> &out, double alpha=1.0, double beta=0.0) const;   // out = alpha self * other + beta out
+    MatrixT<T> &TdotInto(const MatrixT<T> &other, MatrixT<T> &out, double alpha=1.0, double beta=0.0) const;  // out = alpha Transpose(self) * other + beta out
+
+    MatrixT<T> meanVec() const;              // row vector of means of columns (zeros included)
+    MatrixT<T> stddevVec() const;            // row vector of stddev of columns (zeros included)
+    MatrixT<T> columnStats() const;          // as Matrix::columnStats (see ColumnStat)
+
+    void readText(std::string filename);     // "rows cols nonzeros" then "row col value" lines
+    void writeText(std::string filename) const;
+    void readBinary(std::string filename);   // a binary sparse file (either element type)
+    void writeBinary(std::string filename) const;
+    void printSize(std::string msg="") const;
+};
+
+typedef SparseMatrixT<double> SparseMatrix;
+typedef SparseMatrixT<float> SparseMatrixF;
+
+
+// // // // // // // // // // // // // // // // 
+//
+// Matrix expressions
+//
+// The operators +, - and * on matrices (and numbers) do not compute
+// anything.  They build a small expression object and the work is done
+// when the expression is assigned to a matrix (or used to construct
+// one).  Then every element of the answer is computed in one pass with
+// no temporary matrices:
+//
+//     delta = (Y - T) * Y * (1 - Y);
+//
+// IMPORTANT: * is element by element multiply like mult() and NOT the
+// matrix multiply dot().  All matrices in an expression must be the
+// same size.  The answer may be one of the matrices in the expression.
+// The in place routines (add, sub, mult, scalarPreSub, ...) still work
+// as before; the results are identical to doing the same operations
+// with them one at a time.
+//
+
+template <class E>
+class MatrixExpr {
+public:
+    const E &self() const { return static_cast<const E &>(*this); }
+};
+
+
+// a matrix in an expression
+template <class T>
+class MatrixLeaf : public MatrixExpr<MatrixLeaf<T> > {
+private:
+    T **m;
+    const T *row;
+    int maxr, maxc;
+
+public:
+    MatrixLeaf(const MatrixT<T> &a) : m(a.m), row(0), maxr(a.maxr), maxc(a.maxc) { if (!a.defined) a.assertDefined("matrix expression"); }
+    int rows() const { return maxr; }
+    int cols() const { return maxc; }
+    void setRow(int r) { row = m[r]; }
+    T at(int c) const { return row[c]; }
+};
+
+
+// a number in an expression (fits any size)
+class MatrixScalar : public MatrixExpr<MatrixScalar> {
+private:
+    double x;
+
+public:
+    MatrixScalar(double v) : x(v) {}
+    int rows() const { return -1; }
+    int cols() const { return -1; }
+    void setRow(int) {}
+    double at(int) const { return x; }
+};
+
+
+// float op float stays float, anything with a double in it is done in double
+struct MatrixAddOp { static const char *name() { return "+"; } template <class A, class B> static auto apply(A a, B b) -> decltype(a + b) { return a + b; } };
+struct MatrixSubOp { static const char *name() { return "-"; } template <class A, class B> static auto apply(A a, B b) -> decltype(a - b) { return a - b; } };
+struct MatrixMultOp { static const char *name() { return "*"; } template <class A, class B> static auto apply(A a, B b) -> decltype(a * b) { return a * b; } };
+
+
+// an element by element operation on two subexpressions
+template <class L, class R, class Op>
+class MatrixBinary : public MatrixExpr<MatrixBinary<L, R, Op> > {
+private:
+    L lhs;
+    R rhs;
+
+public:
+    typedef decltype(Op::apply(std::declval<L>().at(0), std::declval<R>().at(0))) value;
+
+    MatrixBinary(const L &l, const R &r) : lhs(l), rhs(r)
+    {
+        if (l.rows()>=0 && r.rows()>=0 && (l.rows()!=r.rows() || l.cols()!=r.cols())) {
+            MatrixBase::exprSizeError(Op::name(), l.rows(), l.cols(), r.rows(), r.cols());
+        }
+    }
+    int rows() const { return lhs.rows()>=0 ? lhs.rows() : rhs.rows(); }
+    int cols() const { return lhs.cols()>=0 ? lhs.cols() : rhs.cols(); }
+    void setRow(int r) { lhs.setRow(r); rhs.setRow(r); }
+    value at(int c) const { return Op::apply(lhs.at(c), rhs.at(c)); }
+};
+
+
+// what each kind of operand becomes in an expression
+template <class T, class Enable=void>
+struct MatrixOperand { static const bool ok = false; static const bool scalar = false; };
+
+template <class T>
+struct MatrixOperand<MatrixT<T> > {
+    static const bool ok = true;
+    static const bool scalar = false;
+    typedef MatrixLeaf<T> node;
+    static node get(const MatrixT<T> &a) { return MatrixLeaf<T>(a); }
+};
+
+template <class T>
+struct MatrixOperand<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+    static const bool ok = true;
+    static const bool scalar = true;
+    typedef MatrixScalar node;
+    static node get(T x) { return MatrixScalar(x); }
+};
+
+template <class T>
+struct MatrixOperand<T, typename std::enable_if<std::is_base_of<MatrixExpr<T>, T>::value>::type> {
+    static const bool ok = true;
+    static const bool scalar = false;
+    typedef T node;
+    static const T &get(const T &e) { return e; }
+};
+
+
+// the type of A op B if at least one of them is a matrix or expression
+// (otherwise there is no type and the operator is not used)
+template <class A, class B, class Op,
+          bool use = MatrixOperand<A>::ok && MatrixOperand<B>::ok && !(MatrixOperand<A>::scalar && MatrixOperand<B>::scalar)>
+struct MatrixBinaryOf {};
+
+template <class A, class B, class Op>
+struct MatrixBinaryOf<A, B, Op, true> {
+    typedef MatrixBinary<typename MatrixOperand<A>::node, typename MatrixOperand<B>::node, Op> type;
+};
+
+template <class A, class B>
+typename MatrixBinaryOf<A, B, MatrixAddOp>::type operator+(const A &a, const B &b)
+{
+    return typename MatrixBinaryOf<A, B, MatrixAddOp>::type(MatrixOperand<A>::get(a), MatrixOperand<B>::get(b));
+}
+
+template <class A, class B>
+typename MatrixBinaryOf<A, B, MatrixSubOp>::type operator-(const A &a, const B &b)
+{
+    return typename MatrixBinaryOf<A, B, MatrixSubOp>::type(MatrixOperand<A>::get(a), MatrixOperand<B>::get(b));
+}
+
+template <class A, class B>
+typename MatrixBinaryOf<A, B, MatrixMultOp>::type operator*(const A &a, const B &b)
+{
+    return typename MatrixBinaryOf<A, B, MatrixMultOp>::type(MatrixOperand<A>::get(a), MatrixOperand<B>::get(b));
+}
+
+
+// evaluate the expression into self, one pass over the rows
+template <class T>
+template <class E>
+void MatrixT<T>::evalExpr(const E &e)
+{
+    ProfileScope prof("expression", name);
+
+    parallelRows(maxr, 2.0*maxr*maxc, [&](int lo, int hi) {
+        E x(e);                              // each piece needs its own row pointers
+
+        for (int r=lo; r<hi; r++) {
+            T *out = m[r];
+
+            x.setRow(r);
+            for (int c=0; c<maxc; c++) out[c] = x.at(c);
+        }
+    });
+    defined = true;
+}
+
+template <class T>
+template <class E>
+MatrixT<T>::MatrixT(const MatrixExpr<E> &e, std::string namex)
+{
+    allocate(e.self().rows(), e.self().cols(), namex);
+    evalExpr(e.self());
+}
+
+template <class T>
+template <class E>
+MatrixT<T> &MatrixT<T>::operator=(const MatrixExpr<E> &e)
+{
+    if (submatrix) assertSize(e.self().rows(), e.self().cols(), "matrix expression");
+    else reallocate(e.self().rows(), e.self().cols(), name);
+    evalExpr(e.self());
+
+    return *this;
+}
+
+
+// // // // // // // // // // // // // // // // 
+//
+// map with any callable
+//
+// These are templates so f is inlined into the loop.  As with the
+// function pointer map(), on big matrices map(f) calls f from several
+// threads at once.  mapCol and mapIndex call f in order on one thread.
+//
+
+template <class T>
+template <class F>
+MatrixT<T> &MatrixT<T>::map(F f)
+{
+    ProfileScope prof("map", name);
+
+    assertDefined("map");
+
+    parallelRows(maxr, 10.0*maxr*maxc, [&](int lo, int hi) {
+        for (int r=lo; r<hi; r++) {
+            T *row = m[r];
+
+            for (int c=0; c<maxc; c++) row[c] = f(row[c]);
+        }
+    });
+
+    return *this;
+}
+
+template <class T>
+template <class F>
+MatrixT<T> &MatrixT<T>::mapCol(int c, F f)
+{
+    assertDefined("mapCol");
+    assertColIndexOK(c, "mapCol");
+
+    for (int r=0; r<maxr; r++) m[r][c] = f(m[r][c]);
+
+    return *this;
+}
+
+// like mapIndex above it does not check if self is defined
+template <class T>
+template <class F>
+MatrixT<T> &MatrixT<T>::mapIndex(F f)
+{
+    for (int r=0; r<maxr; r++) {
+        for (int c=0; c<maxc; c++) m[r][c] = f(r, c, m[r][c]);
+    }
+    defined = true;
+
+    return *this;
+}
+
+
+// // // // // // // // // // // // // // // // 
+//
+// class FixedMatrix
+//
+// A small matrix whose size is part of its type, such as one query row
+// or a small block of weights.  The elements live in the object itself
+// (on the stack for a local) so making one costs no allocation, it has
+// no name and the sizes are checked by the compiler.  All loops have
+// constant bounds so the compiler unrolls them.  Sizes are only checked
+// at run time where a FixedMatrix meets an ordinary Matrix:
+//
+//     FixedMatrix<1, 3> q(data, i, 0);        // row i of data
+//     double d = q.dist2(points, r, 1);        // to row r of points from column 1
+//     FixedMatrix<1, 4> h;
+//     q.dotInto(w, h);                         // w is a 3 X 4 Matrix
+//     out.insert(h, i, 0);                     // back into a Matrix
+//
+// Like Matrix, * and dot() are different: only dot() is matrix multiply.
+//
+template <class T, int R, int C>
+class FixedMatrixT {
+    static_assert(R>0 && C>0, "FixedMatrix must have at least one row and column");
+
+private:
+    T m[R][C];
+
+    static void sizeError(const char *msg, const MatrixT<T> &other, int r, int c)
+    {
+        printf("ERROR(%s): a %d X %d fixed matrix does not fit at (%d, %d) of matrix %s of size %d X %d\n",
+               msg, R, C, r, c, other.name.c_str(), other.maxr, other.maxc);
+        exit(1);
+    }
+
+    // the part of other this meets must be defined and R X C from (r, c)
+    static void checkFit(const char *msg, const MatrixT<T> &other, int r, int c, int rows, int cols)
+    {
+        if (!other.defined) other.assertDefined(msg);
+        if (r<0 || c<0 || r+rows>other.maxr || c+cols>other.maxc) sizeError(msg, other, r, c);
+    }
+
+public:
+    FixedMatrixT() { constant(0); }
+    explicit FixedMatrixT(T value) { constant(value); }
+    FixedMatrixT(const MatrixT<T> &other, int minr=0, int minc=0) { extract(other, minr, minc); }  // copy R X C from minr, minc
+
+    static constexpr int numRows() { return R; }
+    static constexpr int numCols() { return C; }
+    T get(int r, int c) const { return m[r][c]; }          // no checks as for speed
+    void set(int r, int c, T value) { m[r][c] = value; }
+    T *row(int r) { return m[r]; }
+    const T *row(int r) const { return m[r]; }
+
+    FixedMatrixT &constant(T value)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] = value;
+        return *this;
+    }
+
+    // copy the R X C block of other starting at minr, minc
+    FixedMatrixT &extract(const MatrixT<T> &other, int minr, int minc)
+    {
+        checkFit("FixedMatrix extract", other, minr, minc, R, C);
+        for (int r=0; r<R; r++) {
+            const T *row = other.m[minr+r] + minc;
+
+            for (int c=0; c<C; c++) m[r][c] = row[c];
+        }
+        return *this;
+    }
+
+    MatrixT<T> toMatrix(std::string name="") const      // an ordinary Matrix with the same contents
+    {
+        MatrixT<T> out(R, C, name);
+
+        out.insert(*this, 0, 0);
+        out.defined = true;
+        return out;
+    }
+
+    // element by element operators (modifies self)
+    FixedMatrixT &add(const FixedMatrixT &other)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] += other.m[r][c];
+        return *this;
+    }
+
+    FixedMatrixT &sub(const FixedMatrixT &other)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] -= other.m[r][c];
+        return *this;
+    }
+
+    FixedMatrixT &mult(const FixedMatrixT &other)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] *= other.m[r][c];
+        return *this;
+    }
+
+    FixedMatrixT &scalarMult(T value)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] *= value;
+        return *this;
+    }
+
+    template <class F> FixedMatrixT &map(F f)
+    {
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) m[r][c] = f(m[r][c]);
+        return *this;
+    }
+
+    FixedMatrixT<T, C, R> transpose() const
+    {
+        FixedMatrixT<T, C, R> out;
+
+        for (int r=0; r<R; r++) for (int c=0; c<C; c++) out.set(c, r, m[r][c]);
+        return out;
+    }
+
+    // classic matrix multiply, inner product
+    template <int K>
+    FixedMatrixT<T, R, K> dot(const FixedMatrixT<T, C, K> &other) const
+    {
+        FixedMatrixT<T, R, K> out;
+
+        for (int r=0; r<R; r++) {
+            T *o = out.row(r);
+
+            for (int i=0; i<C; i++) {
+                T a = m[r][i];
+                const T *b = other.row(i);
+
+                for (int k=0; k<K; k++) o[k] += a*b[k];
+            }
+        }
+        return out;
+    }
+
+    // out = self * other where other is an ordinary C X K Matrix
+    template <int K>
+    FixedMatrixT<T, R, K> &dotInto(const MatrixT<T> &other, FixedMatrixT<T, R, K> &out) const
+    {
+        if (other.maxr!=C || other.maxc!=K) sizeError("FixedMatrix dotInto", other, 0, 0);
+        if (!other.defined) other.assertDefined("FixedMatrix dotInto");
+        out.constant(0);
+        for (int r=0; r<R; r++) {
+            T *o = out.row(r);
+
+            for (int i=0; i<C; i++) {
+                T a = m[r][i];
+                const T *b = other.m[i];
+
+                for (int k=0; k<K; k++) o[k] += a*b[k];
+            }
+        }
+        return out;
+    }
+
+    // *SQUARE* of distance between two matrices
+    double dist2(const FixedMatrixT &other) const
+    {
+        double sum = 0;
+
+        for (int r=0; r<R; r++) {
+            for (int c=0; c<C; c++) {
+                double d = m[r][c] - other.m[r][c];
+
+                sum += d*d;
+            }
+        }
+        return sum;
+    }
+
+    // *SQUARE* of distance between this row vector and the C elements of
+    // row r of other starting at column minc
+    double dist2(const MatrixT<T> &other, int r, int minc=0) const
+    {
+        static_assert(R==1, "FixedMatrix dist2 to a row of a Matrix needs a row vector");
+        double sum = 0;
+        const T *row;
+
+        checkFit("FixedMatrix dist2", other, r, minc, 1, C);
+        row = other.m[r] + minc;
+        for (int c=0; c<C; c++) {
+            double d = m[0][c] - row[c];
+
+            sum += d*d;
+        }
+        return sum;
+    }
+};
+
+template <int R, int C> using FixedMatrix = FixedMatrixT<double, R, C>;
+template <int R, int C> using FixedMatrixF = FixedMatrixT<float, R, C>;
+
+
+// insert a fixed matrix at minr, minc.   Unlike the Matrix version the
+// whole fixed matrix must fit.
+template <class T>
+template <int R, int C>
+MatrixT<T> &MatrixT<T>::insert(const FixedMatrixT<T, R, C> &other, int minr, int minc)
+{
+    if (minr<0 || minc<0 || minr+R>maxr || minc+C>maxc) {
+        printf("ERROR(insert): a %d X %d fixed matrix does not fit at (%d, %d) of matrix %s of size %d X %d\n",
+               R, C, minr, minc, name.c_str(), maxr, maxc);
+        exit(1);
+    }
+
+    for (int r=0; r<R; r++) {
+        const T *row = other.row(r);
+
+        for (int c=0; c<C; c++) m[minr+r][minc+c] = row[c];
+    }
+
+    return *this;
+}
+
+#endif
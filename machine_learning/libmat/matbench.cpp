@@ -0,0 +1,414 @@
+// Micro benchmarks for the Matrix library.  Each major operation is timed
+// on a few sizes and shapes and reported as seconds per operation,
+// GFLOP/s, GB/s and matrix allocations per operation.  The results are
+// saved as JSON and can be compared with a file saved earlier so every
+// change to mat.cpp comes with a number attached.
+//
+// usage: matbench [-q] [-o out.json] [-b baseline.json] [-s fraction] [-f text]
+//
+//   -q   quick: shorter timings and only the smaller sizes
+//   -o   write the results to this JSON file (default bench.json)
+//   -b   compare with the results in this JSON file
+//   -s   how much slower counts as a regression (default 0.10 = 10%)
+//   -f   only run the operations whose name contains text
+//
+// The exit status is 2 if anything is slower than the baseline by more
+// than -s.  Set MAT_THREADS to time with a given number of threads.
+//
+// The GFLOP/s of eigenSystem and inverse use the textbook operation
+// counts (9 n^3 and 2 n^3) and the GB/s count each element read or
+// written once, so they compare runs rather than describe the hardware.
+//
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include "mat.h"
+
+struct Result {
+    std::string op;          // name of the operation
+    std::string size;        // its shape
+    double seconds;          // best time for one
+    double flops;            // floating point operations in one
+    double bytes;            // bytes read and written by one
+    double allocs;           // Matrix allocations in one
+};
+
+static std::vector<Result> results;
+static double batchTime = 0.1;           // each of the three timed batches runs at least this long
+static bool quick = false;
+static const char *only = NULL;
+
+static const char *textFile = "matbench.tmp.txt";
+static const char *binaryFile = "matbench.tmp.matb";
+static const char *ppmFile = "matbench.tmp.ppm";
+
+
+static double now()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+static std::string shape(int a, int b, int c=0)
+{
+    char buf[64];
+
+    if (c>0) sprintf(buf, "%dx%dx%d", a, b, c);
+    else sprintf(buf, "%dx%d", a, b);
+    return buf;
+}
+
+
+static Matrix randomMatrix(int r, int c)
+{
+    Matrix x(r, c);
+
+    x.mapIndex([](int, int, double) { return randPMUnit(); });
+    return x;
+}
+
+
+// Time body.  The number of repetitions is doubled until a batch takes
+// batchTime and the best of three batches is kept, which filters out
+// most of the noise of a busy machine.
+template <class F>
+static void bench(const char *op, std::string size, double flops, double bytes, F body)
+{
+    Result res;
+    double start, best;
+    unsigned long long allocs;
+    int reps;
+
+    if (only!=NULL && strstr(op, only)==NULL) return;
+
+    body();                              // warm up the caches and the thread pool
+    reps = 1;
+    for (;;) {
+        start = now();
+        for (int i=0; i<reps; i++) body();
+        if (now()-start >= batchTime || reps>=(1<<20)) break;
+        reps *= 2;
+    }
+
+    best = 1e300;
+    allocs = MatrixBase::allocations;
+    for (int b=0; b<3; b++) {
+        start = now();
+        for (int i=0; i<reps; i++) body();
+        double t = (now()-start)/reps;
+        if (t<best) best = t;
+    }
+
+    res.op = op;
+    res.size = size;
+    res.seconds = best;
+    res.flops = flops;
+    res.bytes = bytes;
+    res.allocs = (double)(MatrixBase::allocations-allocs)/(3.0*reps);
+    results.push_back(res);
+
+    printf("%-20s %-16s %12.6f s %9.3f GFLOP/s %9.3f GB/s %6.1f allocs\n", op, size.c_str(),
+           best, flops/best*1e-9, bytes/best*1e-9, res.allocs);
+    fflush(stdout);
+}
+
+
+static void benchProducts()
+{
+    int squares[] = {64, 256, 1024};
+
+    for (int n : squares) {
+        if (quick && n>256) continue;
+        Matrix a = randomMatrix(n, n), b = randomMatrix(n, n);
+        double flops = 2.0*n*n*n, bytes = 3.0*n*n*sizeof(double);
+
+        bench("dot", shape(n, n, n), flops, bytes, [&]() { Matrix c = a.dot(b); });
+        bench("dotT", shape(n, n, n), flops, bytes, [&]() { Matrix c = a.dotT(b); });
+        bench("Tdot", shape(n, n, n), flops, bytes, [&]() { Matrix c = a.Tdot(b); });
+    }
+
+    // tall and skinny (a layer of a network on a batch) and a row vector times a matrix
+    int shapes[][3] = {{10000, 64, 64}, {1, 512, 512}};
+    for (auto &s : shapes) {
+        int m = s[0], k = s[1], n = s[2];
+        Matrix a = randomMatrix(m, k), b = randomMatrix(k, n), bt = randomMatrix(n, k), at = randomMatrix(k, m);
+        double flops = 2.0*m*n*k, bytes = ((double)m*k + (double)k*n + (double)m*n)*sizeof(double);
+
+        bench("dot", shape(m, k, n), flops, bytes, [&]() { Matrix c = a.dot(b); });
+        bench("dotT", shape(m, k, n), flops, bytes, [&]() { Matrix c = a.dotT(bt); });
+        bench("Tdot", shape(m, k, n), flops, bytes, [&]() { Matrix c = at.Tdot(b); });
+    }
+}
+
+
+static void benchLinearAlgebra()
+{
+    int covShapes[][2] = {{10000, 64}, {2000, 256}};
+    for (auto &s : covShapes) {
+        int r = s[0], c = s[1];
+        if (quick && c>64) continue;
+        Matrix x = randomMatrix(r, c);
+
+        bench("cov", shape(r, c), (double)r*c*(c+1) + 2.0*r*c, (double)r*c*sizeof(double), [&]() {
+            Matrix v = x.cov();
+        });
+    }
+
+    int eigenSizes[] = {64, 256};
+    for (int n : eigenSizes) {
+        if (quick && n>64) continue;
+        Matrix x = randomMatrix(n, n), y;
+        x = x.dotT(x);                   // symmetric as eigenSystem needs
+
+        bench("eigenSystem", shape(n, n), 9.0*n*n*n, 2.0*n*n*sizeof(double), [&]() {
+            y = x;
+            Matrix values = y.eigenSystem();
+        });
+    }
+
+    int inverseSizes[] = {128, 512};
+    for (int n : inverseSizes) {
+        if (quick && n>128) continue;
+        Matrix x = randomMatrix(n, n), y;
+
+        bench("inverse", shape(n, n), 2.0*n*n*n, 2.0*n*n*sizeof(double), [&]() {
+            y = x;
+            y.inverse();
+        });
+    }
+}
+
+
+static void benchSorting()
+{
+    int sizes[] = {100000, 1000000};
+
+    for (int r : sizes) {
+        if (quick && r>100000) continue;
+        Matrix x = randomMatrix(r, 4), y;
+
+        bench("sortRowsByCol", shape(r, 4), 0, (double)r*4*sizeof(double), [&]() {
+            y = x;
+            y.sortRowsByCol(1);
+        });
+        bench("stableSortRowsByCol", shape(r, 4), 0, (double)r*4*sizeof(double), [&]() {
+            y = x;
+            y.stableSortRowsByCol(1);
+        });
+    }
+}
+
+
+static void benchElementwise()
+{
+    int shapes[][2] = {{1000, 1000}, {4000, 250}};
+
+    for (auto &s : shapes) {
+        int r = s[0], c = s[1];
+        double n = (double)r*c;
+        Matrix x = randomMatrix(r, c), y = randomMatrix(r, c), z = randomMatrix(r, c), signs(r, c);
+
+        // z is updated in place time after time so keep its values from
+        // growing or shrinking into denormals (which are much slower)
+        signs.mapIndex([](int i, int j, double) { return ((i+j)&1) ? -1.0 : 1.0; });
+
+        bench("transpose", shape(r, c), 0, 2*n*sizeof(double), [&]() { Matrix t = x.transpose(); });
+        if (r!=c) continue;
+        bench("transposeSelf", shape(r, c), 0, 2*n*sizeof(double), [&]() { z.transposeSelf(); });
+        bench("add", shape(r, c), n, 3*n*sizeof(double), [&]() { z.add(signs); });
+        bench("mult", shape(r, c), n, 3*n*sizeof(double), [&]() { z.mult(signs); });
+        bench("scalarMult", shape(r, c), n, 2*n*sizeof(double), [&]() { z.scalarMult(-1.0); });
+        bench("map", shape(r, c), n, 2*n*sizeof(double), [&]() { z.map([](double v) { return 0.5*v + 0.25; }); });
+        bench("expression", shape(r, c), 2*n, 3*n*sizeof(double), [&]() { z = x*y + x; });
+    }
+}
+
+
+static void benchFiles()
+{
+    std::string error;
+    int r = quick ? 500 : 2000, c = 50;
+    Matrix x = randomMatrix(r, c);
+    FILE *fp;
+
+    // the text form that read() and readText() take
+    fp = fopen(textFile, "w");
+    if (fp==NULL) {
+        printf("ERROR(matbench): unable to write \"%s\"\n", textFile);
+        exit(1);
+    }
+    fprintf(fp, "%d %d\n", r, c);
+    for (int i=0; i<r; i++) {
+        for (int j=0; j<c; j++) fprintf(fp, "%.17lg ", x.get(i, j));
+        fprintf(fp, "\n");
+    }
+    double textBytes = (double)ftell(fp);
+    fclose(fp);
+
+    bench("readText", shape(r, c), 0, textBytes, [&]() {
+        Matrix y;
+        if (!y.readText(textFile, error)) {
+            printf("ERROR(matbench): %s\n", error.c_str());
+            exit(1);
+        }
+    });
+
+    int br = quick ? 250 : 1000;
+    Matrix big = randomMatrix(br, 1000);
+    double binaryBytes = (double)br*1000*sizeof(double);
+    bench("writeBinary", shape(br, 1000), 0, binaryBytes, [&]() { big.writeBinary(binaryFile); });
+    bench("readBinary", shape(br, 1000), 0, binaryBytes, [&]() { Matrix y; y.readBinary(binaryFile); });
+
+    // a picture of width w with 8 bit colors
+    int h = quick ? 256 : 1024, w = h;
+    Matrix pic(h, 3*w);
+    pic.mapIndex([](int i, int j, double) { return (double)((i*7 + j*13) % 256); });
+    bench("writeImagePpm", shape(h, w), 0, 3.0*h*w, [&]() { pic.writeImagePpm(ppmFile, ""); });
+    bench("readImagePpm", shape(h, w), 0, 3.0*h*w, [&]() { Matrix y; y.readImagePpm(ppmFile, "pic"); });
+
+    remove(textFile);
+    remove(binaryFile);
+    remove(ppmFile);
+}
+
+
+static void writeJson(const char *filename)
+{
+    FILE *fp;
+
+    fp = fopen(filename, "w");
+    if (fp==NULL) {
+        printf("ERROR(matbench): unable to write \"%s\"\n", filename);
+        exit(1);
+    }
+
+    // one result to a line so readBaseline does not need a JSON parser
+    fprintf(fp, "{\n\"threads\": %d,\n\"simd\": \"%s\",\n\"results\": [\n", MatrixBase::numThreads(), MatrixBase::simdName());
+    for (size_t i=0; i<results.size(); i++) {
+        Result &res = results[i];
+
+        fprintf(fp, "{\"op\": \"%s\", \"size\": \"%s\", \"seconds\": %.6e, \"gflops\": %.4f, \"gbytes\": %.4f, \"allocs\": %.2f}%s\n",
+                res.op.c_str(), res.size.c_str(), res.seconds, res.flops/res.seconds*1e-9,
+                res.bytes/res.seconds*1e-9, res.allocs, i+1<results.size() ? "," : "");
+    }
+    fprintf(fp, "]\n}\n");
+    fclose(fp);
+}
+
+
+// the string value of "key": "value" in line or "" if it is not there
+static std::string field(const char *line, const char *key)
+{
+    std::string pattern = std::string("\"") + key + "\": \"";
+    const char *start, *end;
+
+    start = strstr(line, pattern.c_str());
+    if (start==NULL) return "";
+    start += pattern.length();
+    end = strchr(start, '"');
+    if (end==NULL) return "";
+    return std::string(start, end-start);
+}
+
+
+// read the results from a file written by writeJson
+static std::vector<Result> readBaseline(const char *filename)
+{
+    std::vector<Result> base;
+    char line[1024];
+    FILE *fp;
+
+    fp = fopen(filename, "r");
+    if (fp==NULL) {
+        printf("ERROR(matbench): unable to read baseline \"%s\"\n", filename);
+        exit(1);
+    }
+
+    while (fgets(line, sizeof(line), fp)!=NULL) {
+        const char *seconds = strstr(line, "\"seconds\": ");
+        Result res;
+
+        if (seconds==NULL) continue;
+        res.op = field(line, "op");
+        res.size = field(line, "size");
+        res.seconds = atof(seconds + strlen("\"seconds\": "));
+        res.flops = res.bytes = res.allocs = 0;
+        base.push_back(res);
+    }
+    fclose(fp);
+
+    return base;
+}
+
+
+// print the change from the baseline and return the number of regressions
+static int compare(const std::vector<Result> &base, double slower)
+{
+    int regressions = 0;
+
+    printf("\n%-20s %-16s %12s %12s %8s\n", "op", "size", "baseline", "now", "ratio");
+    for (Result &res : results) {
+        const Result *old = NULL;
+
+        for (const Result &b : base) {
+            if (b.op==res.op && b.size==res.size) old = &b;
+        }
+        if (old==NULL || old->seconds<=0) {
+            printf("%-20s %-16s %12s %12.6f\n", res.op.c_str(), res.size.c_str(), "-", res.seconds);
+            continue;
+        }
+
+        double ratio = res.seconds/old->seconds;
+        const char *mark = "";
+        if (ratio > 1+slower) {
+            mark = "  SLOWER";
+            regressions++;
+        }
+        else if (ratio < 1/(1+slower)) mark = "  faster";
+        printf("%-20s %-16s %12.6f %12.6f %8.3f%s\n", res.op.c_str(), res.size.c_str(), old->seconds, res.seconds, ratio, mark);
+    }
+    printf("%d slower by more than %.0f%%\n", regressions, 100*slower);
+
+    return regressions;
+}
+
+
+static void usage()
+{
+    printf("usage: matbench [-q] [-o out.json] [-b baseline.json] [-s fraction] [-f text]\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *out = "bench.json", *baseline = NULL;
+    double slower = 0.10;
+
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-q")==0) quick = true;
+        else if (strcmp(argv[i], "-o")==0 && i+1<argc) out = argv[++i];
+        else if (strcmp(argv[i], "-b")==0 && i+1<argc) baseline = argv[++i];
+        else if (strcmp(argv[i], "-s")==0 && i+1<argc) slower = atof(argv[++i]);
+        else if (strcmp(argv[i], "-f")==0 && i+1<argc) only = argv[++i];
+        else usage();
+    }
+    if (quick) batchTime = 0.02;
+
+    initRand(1, 2);
+    printf("matbench: %d threads, %s kernels\n", MatrixBase::numThreads(), MatrixBase::simdName());
+
+    benchProducts();
+    benchLinearAlgebra();
+    benchSorting();
+    benchElementwise();
+    benchFiles();
+
+    writeJson(out);
+    if (baseline!=NULL && compare(readBaseline(baseline), slower)>0) return 2;
+
+    return 0;
+}
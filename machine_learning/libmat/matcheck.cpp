@@ -0,0 +1,1675 @@
+// Checks of the Matrix library routines that no tool runs on inputs big
+// or odd enough to find their bugs.  Each check compares a routine with
+// a simple reference (or a residual) and prints a line for each failure.
+// make check runs it with one thread and with several.
+//
+// usage: matcheck [-f text]
+//
+//   -f   only run the checks whose name contains text
+//
+// The exit status is 1 if any check failed.
+//
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#ifndef WINDOWS
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+#include "mat.h"
+
+static int checks = 0, failures = 0;
+static const char *only = NULL;
+
+
+// count a check and report it if it failed
+static void check(bool ok, const char *what, const std::string &detail="")
+{
+    checks++;
+    if (!ok) {
+        failures++;
+        printf("FAIL %s %s\n", what, detail.c_str());
+    }
+}
+
+
+static bool wanted(const char *name)
+{
+    return only==NULL || strstr(name, only)!=NULL;
+}
+
+
+static std::string format(const char *fmt, double a, double b=0, double c=0)
+{
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), fmt, a, b, c);
+    return buf;
+}
+
+
+template <class T>
+static MatrixT<T> randomMatrix(int r, int c)
+{
+    MatrixT<T> x(r, c);
+
+    x.mapIndex([](int, int, double) { return randPMUnit(); });
+    return x;
+}
+
+
+// the largest absolute row sum
+template <class T>
+static double normInf(const MatrixT<T> &a)
+{
+    double big = 0;
+
+    for (int r=0; r<a.numRows(); r++) {
+        double sum = 0;
+
+        for (int c=0; c<a.numCols(); c++) sum += fabs(a.get(r, c));
+        big = std::max(big, sum);
+    }
+    return big;
+}
+
+
+// ||a x - b|| / (||a|| ||x|| + ||b||) with the product summed in long
+// double, which is a small multiple of the unit roundoff when x solves
+// a x = b as well as the precision allows
+template <class T>
+static double backwardError(const MatrixT<T> &a, const MatrixT<T> &x, const MatrixT<T> &b)
+{
+    double big = 0;
+
+    for (int r=0; r<a.numRows(); r++) {
+        for (int c=0; c<x.numCols(); c++) {
+            long double sum = -(long double)b.get(r, c);
+
+            for (int k=0; k<a.numCols(); k++) sum += (long double)a.get(r, k)*x.get(k, c);
+            big = std::max(big, (double)fabsl(sum));
+        }
+    }
+    return big/(normInf(a)*normInf(x) + normInf(b) + std::numeric_limits<double>::min());
+}
+
+
+// a solve is good if its backward error is under this many unit roundoffs times n
+template <class T>
+static bool small(double error, int n)
+{
+    return error < 20.0*(n + 1)*std::numeric_limits<T>::epsilon();
+}
+
+
+#ifndef WINDOWS
+// Does body exit with status 1 (an ERROR message)?  It runs in a child
+// process.  Only the calling thread is copied into the child so body
+// must be too small to use the thread pool.
+template <class F>
+static bool exitsWithError(F body)
+{
+    pid_t pid;
+    int status;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid==0) {
+        if (freopen("/dev/null", "w", stdout)==NULL) _exit(2);
+        body();
+        _exit(0);
+    }
+    if (pid<0 || waitpid(pid, &status, 0)!=pid) return false;
+
+    return WIFEXITED(status) && WEXITSTATUS(status)==1;
+}
+#endif
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Products
+//
+// dot, dotT and Tdot at every SIMD level must give bit for bit the triple
+// loop that starts from beta c and adds (alpha a) b in order.  The sizes
+// are on both sides of the tiles (up to 8 X 32), and K goes past the
+// packed panel depth (256) so the partial sums are carried.
+//
+
+// the elements of x a row after another
+template <class T>
+static std::vector<T> elements(const MatrixT<T> &x)
+{
+    std::vector<T> e;
+
+    for (int r=0; r<x.numRows(); r++) {
+        for (int c=0; c<x.numCols(); c++) e.push_back(x.get(r, c));
+    }
+    return e;
+}
+
+
+// c = alpha op(a) op(b) + beta c by the triple loop in T.  a is the
+// elements of an M X K matrix or of its K X M transpose, and the same for b.
+template <class T>
+static std::vector<T> tripleLoop(int M, int N, int K, T alpha, const std::vector<T> &a, bool transA,
+                                 const std::vector<T> &b, bool transB, T beta, const std::vector<T> &c)
+{
+    std::vector<T> out(M*N);
+
+    for (int r=0; r<M; r++) {
+        for (int j=0; j<N; j++) {
+            T sum = (beta==0) ? 0 : beta*c[r*N + j];
+
+            for (int i=0; i<K; i++) {
+                T x = transA ? a[i*M + r] : a[r*K + i], y = transB ? b[j*K + i] : b[i*N + j];
+
+                sum += (alpha*x)*y;
+            }
+            out[r*N + j] = sum;
+        }
+    }
+    return out;
+}
+
+
+template <class T>
+static void checkProducts(const char *type)
+{
+    const int sizes[] = {1, 7, 9, 17, 33, 257, 300};
+    const double scales[][2] = {{1.0, 0.0}, {-0.75, 0.5}, {1.0, 1.0}};
+
+    for (int M : sizes) {
+        for (int N : sizes) {
+            for (int K : sizes) {
+                // one big side at a time and one product that is big all round
+                if ((M>=257) + (N>=257) + (K>=257) > 1 && !(M==257 && N==300 && K==257)) continue;
+
+                MatrixT<T> a = randomMatrix<T>(M, K), at = randomMatrix<T>(K, M);
+                MatrixT<T> b = randomMatrix<T>(K, N), bt = randomMatrix<T>(N, K), c0 = randomMatrix<T>(M, N);
+                std::vector<T> ea = elements(a), eat = elements(at), eb = elements(b), ebt = elements(bt), ec = elements(c0);
+
+                for (const double *s : scales) {
+                    T alpha = s[0], beta = s[1];
+                    std::vector<T> wantDot = tripleLoop<T>(M, N, K, alpha, ea, false, eb, false, beta, ec);
+                    std::vector<T> wantDotT = tripleLoop<T>(M, N, K, alpha, ea, false, ebt, true, beta, ec);
+                    std::vector<T> wantTdot = tripleLoop<T>(M, N, K, alpha, eat, true, eb, false, beta, ec);
+
+                    for (int level=MatrixBase::SIMD_NONE; level<=MatrixBase::SIMD_AVX512; level++) {
+                        MatrixBase::simd = level;
+
+                        std::string where = std::string(type) + " " + MatrixBase::simdName()
+                            + format(" %.0f X %.0f X %.0f", M, N, K) + format(" alpha %g beta %g", alpha, beta);
+                        MatrixT<T> c1(c0), c2(c0), c3(c0);
+
+                        a.dotInto(b, c1, alpha, beta);
+                        a.dotTInto(bt, c2, alpha, beta);
+                        at.TdotInto(b, c3, alpha, beta);
+                        check(elements(c1)==wantDot, "dot", where);
+                        check(elements(c2)==wantDotT, "dotT", where);
+                        check(elements(c3)==wantTdot, "Tdot", where);
+                    }
+                    MatrixBase::simd = MatrixBase::SIMD_AUTO;
+                }
+            }
+        }
+    }
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Linear systems
+//
+// The sizes go past factorBlock (64) so the blocked updates are run.
+//
+
+// the determinant by Gaussian elimination with partial pivoting in long double
+template <class T>
+static long double referenceDeterminant(const MatrixT<T> &a)
+{
+    int n = a.numRows();
+    std::vector<long double> m((size_t)n*n);
+    long double det = 1;
+
+    for (int r=0; r<n; r++) for (int c=0; c<n; c++) m[(size_t)r*n + c] = a.get(r, c);
+    for (int j=0; j<n; j++) {
+        int p = j;
+
+        for (int i=j+1; i<n; i++) if (fabsl(m[(size_t)i*n + j]) > fabsl(m[(size_t)p*n + j])) p = i;
+        if (m[(size_t)p*n + j]==0) return 0;
+        if (p!=j) {
+            for (int c=0; c<n; c++) std::swap(m[(size_t)p*n + c], m[(size_t)j*n + c]);
+            det = -det;
+        }
+        det *= m[(size_t)j*n + j];
+        for (int i=j+1; i<n; i++) {
+            long double l = m[(size_t)i*n + j]/m[(size_t)j*n + j];
+
+            for (int c=j; c<n; c++) m[(size_t)i*n + c] -= l*m[(size_t)j*n + c];
+        }
+    }
+    return det;
+}
+
+
+// PA = LU: L is the unit lower triangle and U the upper triangle of lu
+template <class T>
+static double luError(const MatrixT<T> &a, const MatrixT<T> &lu, const int *perm)
+{
+    int n = a.numRows();
+    double big = 0;
+
+    for (int r=0; r<n; r++) {
+        for (int c=0; c<n; c++) {
+            long double sum = -(long double)a.get(perm[r], c);
+
+            for (int k=0; k<=std::min(r, c); k++) sum += (long double)(k==r ? 1.0 : lu.get(r, k))*lu.get(k, c);
+            big = std::max(big, (double)fabsl(sum));
+        }
+    }
+    return big/(normInf(a) + std::numeric_limits<double>::min());
+}
+
+
+// L L^T = A
+template <class T>
+static double choleskyError(const MatrixT<T> &a, const MatrixT<T> &l)
+{
+    int n = a.numRows();
+    double big = 0;
+
+    for (int r=0; r<n; r++) {
+        for (int c=0; c<n; c++) {
+            long double sum = -(long double)a.get(r, c);
+
+            for (int k=0; k<=std::min(r, c); k++) sum += (long double)l.get(r, k)*l.get(c, k);
+            big = std::max(big, (double)fabsl(sum));
+            if (c>r && l.get(r, c)!=0) big = HUGE_VAL;    // must be lower triangular
+        }
+    }
+    return big/(normInf(a) + std::numeric_limits<double>::min());
+}
+
+
+// M M^T + n I
+template <class T>
+static MatrixT<T> spdMatrix(int n)
+{
+    MatrixT<T> m = randomMatrix<T>(n, n);
+    MatrixT<T> a = m.dotT(m);
+
+    for (int i=0; i<n; i++) a.set(i, i, a.get(i, i) + n);
+    return a;
+}
+
+
+template <class T>
+static void checkSolvers(const char *type)
+{
+    const int sizes[] = {1, 2, 3, 17, 63, 64, 65, 130, 300};
+    const int detMax = 65;     // bigger determinants can overflow a double
+
+    for (int n : sizes) {
+        std::string at = std::string(type) + format(" n=%.0f", n);
+
+        // general: LU with partial pivoting
+        {
+            MatrixT<T> a = randomMatrix<T>(n, n), lu(a);
+            int *perm = lu.LU();
+
+            check(small<T>(luError(a, lu, perm), n), "LU", at);
+            delete [] perm;
+
+            MatrixT<T> b = randomMatrix<T>(n, 3), x(b), a2(a);
+            a2.solve(x);
+            check(small<T>(backwardError(a, x, b), n), "solve general", at);
+
+            MatrixSolverT<T> s(a);
+            if (n>1) check(!s.isCholesky(), "MatrixSolver general is LU", at);   // 1 X 1 may be positive definite
+            check(small<T>(backwardError(a, s.solve(b), b), n), "MatrixSolver general", at);
+
+            MatrixT<T> inv(a), id(n, n);
+            inv.inverse();
+            id.constant(0.0);
+            id.constantDiagonal(1.0);
+            check(small<T>(backwardError(a, inv, id), n), "inverse", at);
+
+            if (n<=detMax) {
+                long double ref = referenceDeterminant(a);
+                double det = s.determinant();
+                check((det<0)==(ref<0) && fabsl(det - ref) <= 1e3*n*std::numeric_limits<T>::epsilon()*fabsl(ref),
+                      "determinant general", at + format(" %.17g %.17g", det, (double)ref));
+            }
+        }
+
+        // symmetric positive definite: Cholesky
+        {
+            MatrixT<T> a = spdMatrix<T>(n), l(a);
+
+            l.cholesky();
+            check(small<T>(choleskyError(a, l), n), "cholesky", at);
+
+            MatrixT<T> b = randomMatrix<T>(n, 2), x(b), a2(a);
+            a2.solve(x);
+            check(small<T>(backwardError(a, x, b), n), "solve spd", at);
+
+            MatrixSolverT<T> s(a), slu(a, MatrixSolverT<T>::SOLVE_LU);
+            check(s.isCholesky(), "MatrixSolver spd is Cholesky", at);
+            check(!slu.isCholesky(), "MatrixSolver SOLVE_LU is LU", at);
+            check(small<T>(backwardError(a, s.solve(b), b), n), "MatrixSolver spd", at);
+            check(small<T>(backwardError(a, slu.solve(b), b), n), "MatrixSolver spd by LU", at);
+
+            if (n<=detMax) {
+                long double ref = referenceDeterminant(a);
+                double det = s.determinant(), detlu = slu.determinant();
+                check(det>0 && fabsl(det - ref) <= 1e3*n*std::numeric_limits<T>::epsilon()*fabsl(ref),
+                      "determinant spd", at + format(" %.17g %.17g", det, (double)ref));
+                check(detlu>0 && fabsl(detlu - ref) <= 1e3*n*std::numeric_limits<T>::epsilon()*fabsl(ref),
+                      "determinant spd by LU", at + format(" %.17g %.17g", detlu, (double)ref));
+            }
+        }
+
+        // symmetric but indefinite: Cholesky fails part way and LU is used
+        if (n>=2) {
+            MatrixT<T> a = spdMatrix<T>(n);
+
+            a.set(n-1, n-1, -a.get(n-1, n-1));
+            MatrixSolverT<T> s(a);
+            MatrixT<T> b = randomMatrix<T>(n, 2), x(b), a2(a);
+            check(!s.isCholesky(), "MatrixSolver indefinite falls back to LU", at);
+            check(small<T>(backwardError(a, s.solve(b), b), n), "MatrixSolver indefinite", at);
+            a2.solve(x);
+            check(small<T>(backwardError(a, x, b), n), "solve indefinite", at);
+            if (n<=detMax) {
+                long double ref = referenceDeterminant(a);
+                check((s.determinant()<0)==(ref<0), "determinant indefinite sign", at);
+            }
+        }
+
+        // every triangular solve: lower or upper, op(a) = a or a^T, unit diagonal or not
+        for (int v=0; v<8; v++) {
+            bool lower = v&1, trans = v&2, unit = v&4;
+            MatrixT<T> t = randomMatrix<T>(n, n), op(n, n);
+
+            for (int r=0; r<n; r++) {
+                for (int c=0; c<n; c++) {
+                    if (lower ? c>r : c<r) t.set(r, c, 0);
+                }
+                t.set(r, r, unit ? 1.0 : 2.0 + fabs(t.get(r, r)));
+            }
+            for (int r=0; r<n; r++) for (int c=0; c<n; c++) op.set(r, c, trans ? t.get(c, r) : t.get(r, c));
+
+            MatrixT<T> b = randomMatrix<T>(n, 4), x(b), t2(t);
+            if (unit) for (int r=0; r<n; r++) t2.set(r, r, 7.0);    // a unit diagonal is not read
+            t2.solveTriangular(x, lower, trans, unit);
+            check(small<T>(backwardError(op, x, b), n), "solveTriangular",
+                  at + (lower ? " lower" : " upper") + (trans ? " transposed" : "") + (unit ? " unit" : ""));
+        }
+    }
+
+    // permutations: the determinant is the sign of the permutation
+    for (int n : {2, 3, 5, 70}) {
+        MatrixT<T> p(n, n);
+        std::vector<int> order(n);
+        int swaps = 0;
+
+        p.constant(0.0);
+        for (int i=0; i<n; i++) order[i] = i;
+        for (int i=n-1; i>0; i--) {
+            int j = randMod(i+1);
+
+            if (j!=i) {
+                std::swap(order[i], order[j]);
+                swaps++;
+            }
+        }
+        for (int i=0; i<n; i++) p.set(i, order[i], 1.0);
+        MatrixSolverT<T> s(p);
+        check(s.determinant()==((swaps%2) ? -1.0 : 1.0), "determinant of a permutation",
+              std::string(type) + format(" n=%.0f det=%g swaps=%.0f", n, s.determinant(), swaps));
+    }
+
+    // singular: the LU factors still hold and the solvers stop with an ERROR
+    {
+        int n = 8;
+        MatrixT<T> a = randomMatrix<T>(n, n), lu;
+
+        for (int r=0; r<n; r++) a.set(r, 3, 0.0);      // a zero column
+        lu = a;
+        int *perm = lu.LU();
+        bool zeroPivot = false;
+
+        for (int i=0; i<n; i++) zeroPivot = zeroPivot || lu.get(i, i)==0;
+        check(small<T>(luError(a, lu, perm), n), "LU singular", type);
+        check(zeroPivot, "LU singular has a zero pivot", type);
+        delete [] perm;
+        check(referenceDeterminant(a)==0, "reference determinant singular", type);
+    }
+}
+
+
+#ifndef WINDOWS
+// The solvers stop with an ERROR on a matrix they can not use.  These run
+// in child processes so they come before anything starts the threads of
+// the pool (a child has none of them to stop at exit).
+template <class T>
+static void checkSolverErrors(const char *type)
+{
+    int n = 8;
+    MatrixT<T> a = randomMatrix<T>(n, n), notPositive = spdMatrix<T>(n);
+
+    for (int r=0; r<n; r++) a.set(r, 3, 0.0);      // a zero column
+    notPositive.set(0, 0, -1.0);
+    check(exitsWithError([&]() { MatrixSolverT<T> s(a); }), "MatrixSolver singular stops", type);
+    check(exitsWithError([&]() { MatrixT<T> a2(a), b = randomMatrix<T>(n, 1); a2.solve(b); }), "solve singular stops", type);
+    check(exitsWithError([&]() { MatrixT<T> a2(a); a2.inverse(); }), "inverse singular stops", type);
+    check(exitsWithError([&]() { MatrixSolverT<T> s(randomMatrix<T>(n, n), MatrixSolverT<T>::SOLVE_CHOLESKY); }),
+          "MatrixSolver SOLVE_CHOLESKY of a non symmetric matrix stops", type);
+    check(exitsWithError([&]() { MatrixT<T> l(notPositive); l.cholesky(); }), "cholesky not positive definite stops", type);
+}
+#endif
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Sorting rows
+//
+// The sizes are at least largeSortRows (4096) so the parallel merge sort
+// and the radix sort are run, and up to 100000 rows so the radix sort
+// splits its passes over the threads.  The keys have many duplicates,
+// -0 and +0, infinities and NaNs of both signs.
+//
+
+// the order stableSortRowsByCol promises: the IEEE bits with negative
+// numbers flipped, so -0 comes before +0 and NaNs go to the ends
+static unsigned long long orderKey(double x)
+{
+    unsigned long long bits;
+
+    memcpy(&bits, &x, sizeof(bits));
+    return (bits>>63) ? ~bits : (bits | 0x8000000000000000ULL);
+}
+
+
+// the same bits, which tells -0 from +0 and one NaN from another
+template <class T>
+static bool same(T a, T b)
+{
+    return memcmp(&a, &b, sizeof(T))==0;
+}
+
+
+// Column 0 is a key from a few values, column 1 a small integer, column
+// 2 is zero in half the rows and column 3 is the row number, which makes
+// every row different and shows where each one went.
+template <class T>
+static MatrixT<T> sortData(int n, bool nans)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    const double keys[] = {-3, -1, -0.0, 0.0, 0.0, 1, 2.5, 1e30, -inf, inf, nan, -nan};
+    const int numKeys = nans ? 12 : 10;
+    MatrixT<T> x(n, 4);
+
+    for (int r=0; r<n; r++) {
+        x.set(r, 0, randUnit()<0.5 ? keys[randMod(numKeys)] : randMod(1000) - 500.5);
+        x.set(r, 1, randMod(4));
+        x.set(r, 2, randUnit()<0.5 ? 0.0 : randPMUnit());
+        x.set(r, 3, r);
+    }
+    return x;
+}
+
+
+// Row r of sorted is row order[r] of data with every bit the same.  The
+// rows from first to last are compared and all others must not move.
+template <class T>
+static bool sameRows(const MatrixT<T> &sorted, const MatrixT<T> &data, const std::vector<int> &order, int first, int last)
+{
+    for (int r=0; r<data.numRows(); r++) {
+        int from = (r>=first && r<=last) ? order[r-first] : r;
+
+        for (int c=0; c<data.numCols(); c++) {
+            if (!same(sorted.get(r, c), data.get(from, c))) return false;
+        }
+    }
+    return true;
+}
+
+
+// Rows first to last of sorted are the same rows of data in some order
+// with column c in the order of orderKey.  This is all an unstable sort
+// promises.
+template <class T>
+static bool sortedRows(const MatrixT<T> &sorted, const MatrixT<T> &data, int c, int first, int last)
+{
+    std::vector<int> order;
+    std::vector<bool> seen(data.numRows(), false);
+
+    for (int r=first; r<=last; r++) {
+        int from = (int)sorted.get(r, 3);
+
+        if (from<first || from>last || seen[from]) return false;
+        seen[from] = true;
+        order.push_back(from);
+        if (r>first && orderKey(sorted.get(r-1, c)) > orderKey(sorted.get(r, c))) return false;
+    }
+    return sameRows(sorted, data, order, first, last);
+}
+
+
+// the rows first to last of data in the order of column c by std::stable_sort
+template <class T>
+static std::vector<int> stableOrder(const MatrixT<T> &data, int c, int first, int last)
+{
+    std::vector<int> order;
+
+    for (int r=first; r<=last; r++) order.push_back(r);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return orderKey(data.get(a, c)) < orderKey(data.get(b, c));
+    });
+    return order;
+}
+
+
+template <class T>
+static void checkSorts(const char *type)
+{
+    const int sizes[] = {4096, 5000, 100000};
+
+    for (int n : sizes) {
+        std::string at = std::string(type) + format(" n=%.0f", n);
+        int first = n/7, last = n - 1 - n/11;        // a range that is still large
+
+        if (last-first+1 < 4096) {
+            first = 0;
+            last = n-1;
+        }
+
+        // stable: exactly the order of std::stable_sort
+        for (int c : {0, 2}) {
+            MatrixT<T> data = sortData<T>(n, true), x(data);
+
+            x.stableSortRowsByCol(c);
+            check(sameRows(x, data, stableOrder(data, c, 0, n-1), 0, n-1), "stableSortRowsByCol",
+                  at + format(" c=%.0f", c));
+
+            MatrixT<T> y(data);
+            y.stableSortRowsByCol(c, first, last);
+            check(sameRows(y, data, stableOrder(data, c, first, last), first, last), "stableSortRowsByCol range",
+                  at + format(" c=%.0f rows %.0f to %.0f", c, first, last));
+        }
+
+        // unstable: the keys in order and no row lost or changed
+        for (int c : {0, 2}) {
+            MatrixT<T> data = sortData<T>(n, true), x(data), y(data);
+
+            x.sortRowsByCol(c);
+            check(sortedRows(x, data, c, 0, n-1), "sortRowsByCol", at + format(" c=%.0f", c));
+            y.sortRowsByCol(c, first, last);
+            check(sortedRows(y, data, c, first, last), "sortRowsByCol range", at + format(" c=%.0f", c));
+        }
+
+        // whole rows compared a column at a time with < and NaNs after
+        // all numbers.  The row number in the last column breaks every tie
+        // (-0 and +0 are equal) so there is just one right answer.
+        for (bool nans : {false, true}) {
+            MatrixT<T> data = sortData<T>(n, nans), x(data), y(data);
+            auto less = [&](int a, int b) {
+                for (int c=0; c<data.numCols(); c++) {
+                    double u = data.get(a, c), v = data.get(b, c);
+
+                    if (u < v || (v!=v && u==u)) return true;
+                    if (u > v || (u!=u && v==v)) return false;
+                }
+                return false;
+            };
+            std::vector<int> order, range;
+            std::string with = at + (nans ? " with NaNs" : "");
+
+            for (int r=0; r<n; r++) order.push_back(r);
+            range.assign(order.begin()+first, order.begin()+last+1);
+            std::stable_sort(order.begin(), order.end(), less);
+            std::stable_sort(range.begin(), range.end(), less);
+
+            x.sortRows();
+            check(sameRows(x, data, order, 0, n-1), "sortRows", with);
+            y.sortRows(first, last);
+            check(sameRows(y, data, range, first, last), "sortRows range", with);
+        }
+    }
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Reading text
+//
+// readText parses numbers itself but must take the same characters as
+// scanf("%lf") and get the same value, so a matrix file is read with both
+// and the answers compared bit for bit.  The numbers are put across the
+// 1 MiB blocks the file is read in, and a file over 1 MiB is parsed in
+// parallel when there are threads.
+//
+
+static const char *scratchText = "matcheck.tmp.txt";
+static const int textBlockBytes = 1<<20;
+
+
+// numbers for the fast path and every way out of it
+static const char *textTokens[] = {
+    "0", "-0", "+0", "0.0", "-0.000", "7", "-7", "+7.25", "1.5", ".5", "-.5e-3", "5.", "1.e5",
+    "1234567890123456789", "12345678901234567890", "9999999999999999999", "18446744073709551615",
+    "18446744073709551616", "123456789012345678901234567890", "0.1234567890123456789",
+    "0.12345678901234567890", "1.2345678901234567890e5", "9007199254740992", "9007199254740993",
+    "1e22", "1e23", "1e-22", "1e-23", "123456789e22", "123456789e-22", "9007199254740991e22",
+    "9007199254740991e-22", "4.5e15", "3e-5", "1E10", "2e+3", "1e308", "1.7976931348623157e308",
+    "1e309", "2.2250738585072011e-308", "4.9e-324", "1e-324", "1e-400", "1e400", "1e99999999999",
+    "0.000000000000000000000123456789", "0.0000000000000000000001", "000000000000000000000001.5",
+    "0.00000000000000000000012345678901234567890", "00000.00000000000000000000000000000",
+    "0x1p-3", "0x1.8p1", "-0X1A", "0xAbC.8", "0x1p", "inf", "-Infinity", "NaN", "nan", "+INF", "-nan",
+    "1e", "1e+", "-1E-",
+    "0x", ".", "-", "+.e1", "e5", "x", "infin", "--1"
+};
+
+
+// write text to the scratch file
+static void writeText(const std::string &text)
+{
+    FILE *fp = fopen(scratchText, "wb");
+
+    if (fp==NULL || fwrite(text.data(), 1, text.size(), fp)!=text.size() || fclose(fp)!=0) {
+        printf("ERROR(matcheck): unable to write \"%s\".\n", scratchText);
+        exit(1);
+    }
+}
+
+
+// Read the matrix in the scratch file with readText and with scanf and
+// compare: the same elements, the same integer read just after the
+// matrix, or the same element found to be bad.
+static void checkText(const char *what, const std::string &detail, bool labeled=false)
+{
+    std::vector<double> want;
+    std::string error;
+    char **labels = NULL, label[256];
+    int rows = 0, cols = 0, after = -1, wantAfter = -1;
+    double x;
+    bool wantOk, ok;
+    FILE *fp;
+
+    // scanf
+    fp = fopen(scratchText, "r");
+    wantOk = fscanf(fp, "%d %d", &rows, &cols)==2;
+    for (int i=0; wantOk && i<rows*cols; i++) {
+        if (labeled && i%cols==0) wantOk = fscanf(fp, "%255s", label)==1;
+        else {
+            wantOk = fscanf(fp, "%lf", &x)==1;
+            if (wantOk) want.push_back(x);
+        }
+    }
+    if (wantOk && fscanf(fp, "%d", &wantAfter)!=1) wantAfter = -1;
+    fclose(fp);
+
+    // readText
+    MatrixT<double> a;
+    fp = fopen(scratchText, "r");
+    ok = a.readText(fp, error, labeled ? &labels : NULL);
+    if (ok && fscanf(fp, "%d", &after)!=1) after = -1;
+    fclose(fp);
+
+    check(ok==wantOk, what, detail + (ok ? " read" : " not read: " + error));
+    if (ok && wantOk) {
+        std::string wrong;
+        int k = 0;
+
+        // just the first wrong number
+        for (int r=0; r<rows && wrong.empty(); r++) {
+            for (int c=labeled ? 1 : 0; c<cols && wrong.empty(); c++) {
+                if (!same(a.get(r, c), want[k])) wrong = format(" number %.0f is %.17g not %.17g", k, a.get(r, c), want[k]);
+                k++;
+            }
+        }
+        check(wrong.empty(), what, detail + wrong);
+        check(after==wantAfter, what, detail + format(" then %.0f not %.0f", after, wantAfter));
+    }
+    else if (!ok && !wantOk && rows>0 && cols>0) {
+        long long bad = (long long)want.size() + (labeled ? want.size()/(cols-1) + 1 : 0);
+        char item[64];
+
+        snprintf(item, sizeof(item), "element [%lld, %lld]", bad/cols, bad%cols);
+        check(error.find(item)!=std::string::npos, what, detail + " gives " + error + " not " + item);
+    }
+
+    if (labels!=NULL) {
+        for (int r=0; r<rows; r++) delete [] labels[r];
+        delete [] labels;
+    }
+}
+
+
+// a random number written in one of the ways a program might
+static std::string randomNumberText()
+{
+    const char *formats[] = {"%.17g", "%.3f", "%.6e", "%g", "%.25f", "%.0f", "%.20e"};
+    double x = randPMUnit()*pow(10.0, randMod(60) - 30);
+    char buffer[128];
+
+    snprintf(buffer, sizeof(buffer), formats[randMod(7)], x);
+    return buffer;
+}
+
+
+static void checkReadText()
+{
+    const int numTokens = sizeof(textTokens)/sizeof(textTokens[0]);
+
+    // each number alone and after another on the line
+    for (int i=0; i<numTokens; i++) {
+        writeText(std::string("1 1\n") + textTokens[i] + "\n7\n");
+        checkText("readText number", textTokens[i]);
+        writeText(std::string("1 2\n1.5 ") + textTokens[i] + " 7\n");
+        checkText("readText second number", textTokens[i]);
+    }
+
+    // every number across the end of the first block at every place it can
+    // be cut.  A label makes the read serial with any number of threads.
+    for (int i=0; i<numTokens; i++) {
+        int len = strlen(textTokens[i]);
+
+        for (int k=1; k<=len+1; k++) {
+            std::string text("1 2\nrow");
+
+            text.append(textBlockBytes - k - text.size(), ' ');
+            text += textTokens[i];
+            text += "\n7\n";
+            writeText(text);
+            checkText("readText across a block", std::string(textTokens[i]) + format(" cut %.0f from the start", k), true);
+        }
+    }
+
+    // a big matrix of all kinds of numbers, read in parallel with threads
+    {
+        const int rows = 3000, cols = 40;
+        std::vector<std::string> element;
+        std::string text;
+
+        for (int i=0; i<rows*cols; i++) {
+            const char *t = textTokens[randMod(numTokens)];
+            std::string s = randUnit()<0.5 ? randomNumberText() : t;
+            double x;
+            int n;
+
+            // only the numbers scanf reads to a space
+            if (sscanf((s + " ").c_str(), "%lf%n", &x, &n)!=1 || n!=(int)s.size()) s = "1";
+            element.push_back(s);
+        }
+        text = format("%.0f %.0f\n", rows, cols);
+        for (int r=0; r<rows; r++) {
+            for (int c=0; c<cols; c++) text += element[r*cols + c] + (c<cols-1 ? (randMod(3)==0 ? "  " : " ") : "\n");
+        }
+        check(text.size()>(size_t)textBlockBytes, "readText big file", format("only %.0f bytes", text.size()));
+
+        writeText(text + "7\n");
+        checkText("readText big", "matrix");
+        writeText(text + text);
+        checkText("readText big", "matrix followed by another");
+
+        // a bad number in the middle is found at the same element
+        size_t at = text.find('\n', text.size()/2) + 1;
+        writeText(text.substr(0, at) + "0x " + text.substr(at));
+        checkText("readText big", "with a bad number");
+
+        // and the file ends too soon
+        writeText(text.substr(0, text.size()*2/3));
+        checkText("readText big", "cut short");
+    }
+
+    remove(scratchText);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Sparse matrices
+//
+// A SparseMatrix and the dense Matrix of the same elements must agree.
+// The products add the same nonzero terms in the same order as the
+// triple loop of the dense products, so they agree bit for bit except
+// dotInto, which scales the sum by alpha after it is made.
+//
+
+static const char *scratchSparse = "matcheck.tmp.mats";
+
+
+// the largest difference of x and y over the largest element of y
+template <class T>
+static double difference(const MatrixT<T> &x, const MatrixT<T> &y)
+{
+    double diff = 0, big = std::numeric_limits<double>::min();
+
+    if (x.numRows()!=y.numRows() || x.numCols()!=y.numCols()) return 1e300;
+    for (int r=0; r<y.numRows(); r++) {
+        for (int c=0; c<y.numCols(); c++) {
+            diff = std::max(diff, fabs(x.get(r, c) - y.get(r, c)));
+            big = std::max(big, fabs(y.get(r, c)));
+        }
+    }
+    return diff/big;
+}
+
+
+// equal element for element
+template <class T>
+static bool equal(const MatrixT<T> &x, const MatrixT<T> &y)
+{
+    return x.numRows()==y.numRows() && x.numCols()==y.numCols() && elements(x)==elements(y);
+}
+
+
+// about 1 in 8 elements nonzero, with a row and a column of zeros
+template <class T>
+static MatrixT<T> sparseData(int r, int c)
+{
+    MatrixT<T> x(r, c);
+
+    x.mapIndex([=](int i, int j, double) { return (i==r/2 || j==c/3 || randMod(8)!=0) ? 0.0 : randPMUnit(); });
+    return x;
+}
+
+
+template <class T>
+static void checkSparse(const char *type)
+{
+    const int shapes[][2] = {{1, 1}, {1, 9}, {9, 1}, {37, 5}, {300, 70}, {2000, 40}};
+
+    for (const int *shape : shapes) {
+        const int R = shape[0], C = shape[1];
+        std::string at = std::string(type) + format(" %.0f X %.0f", R, C);
+        MatrixT<T> d = sparseData<T>(R, C);
+        SparseMatrixT<T> s(d);
+        bool same = true;
+
+        for (int r=0; r<R; r++) {
+            for (int c=0; c<C; c++) same = same && s.get(r, c)==d.get(r, c);
+        }
+        check(same, "SparseMatrix get", at);
+        check(equal(s.toDense(), d), "SparseMatrix toDense", at);
+        check(equal(s.transpose().toDense(), d.transpose()), "SparseMatrix transpose", at);
+
+        // the triples (one repeated) give the same matrix
+        {
+            std::vector<int> rows, cols;
+            std::vector<T> values;
+
+            for (int r=R-1; r>=0; r--) {
+                for (int c=0; c<C; c++) {
+                    if (d.get(r, c)==0) continue;
+                    rows.push_back(r);
+                    cols.push_back(c);
+                    values.push_back(d.get(r, c));
+                    if (rows.size()==1) {
+                        rows.push_back(r);
+                        cols.push_back(c);
+                        values.push_back(0.5);
+                    }
+                }
+            }
+            MatrixT<T> d2(d);
+            if (rows.size()>0) d2.set(rows[0], cols[0], (T)(values[0] + (T)0.5));
+            check(equal(SparseMatrixT<T>(R, C, rows, cols, values).toDense(), d2), "SparseMatrix triples", at);
+        }
+
+        // rows
+        {
+            int first = R/3, size = R - R/3 - R/4;
+            std::vector<int> pick;
+
+            for (int i=0; i<R+3; i++) pick.push_back(randMod(R));
+            MatrixT<T> picked(R+3, C);
+            for (int i=0; i<R+3; i++) {
+                for (int c=0; c<C; c++) picked.set(i, c, d.get(pick[i], c));
+            }
+            check(equal(s.extractRows(first, size).toDense(), d.extract(first, 0, size, C)), "SparseMatrix extractRows", at);
+            check(equal(s.pickRows(pick).toDense(), picked), "SparseMatrix pickRows", at);
+        }
+
+        // products
+        {
+            const int N = 33;
+            MatrixT<T> b = randomMatrix<T>(C, N), bt = randomMatrix<T>(R, N), o0 = randomMatrix<T>(R, N), p0 = randomMatrix<T>(C, N);
+
+            check(equal(s.dot(b), d.dot(b)), "SparseMatrix dot", at);
+            check(equal(s.Tdot(bt), d.Tdot(bt)), "SparseMatrix Tdot", at);
+            for (double alpha : {1.0, -0.75}) {
+                for (double beta : {0.0, 1.0, 0.5}) {
+                    std::string where = at + format(" alpha %g beta %g", alpha, beta);
+                    MatrixT<T> o1(o0), o2(o0), p1(p0), p2(p0);
+
+                    if (beta==0) p1.constant(NAN);      // out is only written
+                    s.TdotInto(bt, p1, alpha, beta);
+                    d.TdotInto(bt, p2, alpha, beta);
+                    check(equal(p1, p2), "SparseMatrix TdotInto", where);
+                    s.dotInto(b, o1, alpha, beta);
+                    d.dotInto(b, o2, alpha, beta);
+                    check(difference(o1, o2) < 10*C*std::numeric_limits<T>::epsilon(), "SparseMatrix dotInto", where);
+                }
+            }
+        }
+
+        // column statistics with the zeros counted
+        {
+            MatrixT<T> stats = s.columnStats(), want = d.columnStats();
+            const double tol = 10*R*std::numeric_limits<T>::epsilon();
+            bool ok = true;
+
+            for (int c=0; c<C; c++) {
+                for (int k : {MatrixBase::STAT_MIN, MatrixBase::STAT_MAX, MatrixBase::STAT_NONZERO}) {
+                    ok = ok && stats.get(k, c)==want.get(k, c);
+                }
+            }
+            check(ok, "SparseMatrix columnStats min, max and nonzeros", at);
+            check(difference(stats, want) < tol, "SparseMatrix columnStats", at);
+            check(difference(s.meanVec(), d.meanVec()) < tol, "SparseMatrix meanVec", at);
+            check(difference(s.stddevVec(), d.stddevVec()) < tol, "SparseMatrix stddevVec", at);
+        }
+
+        // files
+        {
+            SparseMatrixT<T> t, u;
+            SparseMatrixT<float> f;
+            SparseMatrixT<double> g;
+
+            s.writeText(scratchSparse);
+            t.readText(scratchSparse);
+            check(equal(t.toDense(), d) && t.numNonZero()==s.numNonZero(), "SparseMatrix text", at);
+            s.writeBinary(scratchSparse);
+            u.readBinary(scratchSparse);
+            check(equal(u.toDense(), d) && u.numNonZero()==s.numNonZero(), "SparseMatrix binary", at);
+            f.readBinary(scratchSparse);
+            g.readBinary(scratchSparse);
+            check(equal(f.toDense(), MatrixT<float>(d)), "SparseMatrix binary to float", at);
+            check(equal(g.toDense(), MatrixT<double>(d)), "SparseMatrix binary to double", at);
+        }
+    }
+    remove(scratchSparse);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Streaming
+//
+// A MatrixRowStream over a text or binary file must walk the same rows as
+// the matrix in memory and give the same meanVec, stddevVec and minMax
+// for any block size, and cov to within rounding.
+//
+
+static const char *scratchMatrix = "matcheck.tmp.matb";
+
+
+// the matrix in the text form read() takes, every element exactly
+template <class T>
+static void writeMatrixText(const MatrixT<T> &x)
+{
+    std::string text = format("%.0f %.0f\n", x.numRows(), x.numCols());
+
+    for (int r=0; r<x.numRows(); r++) {
+        for (int c=0; c<x.numCols(); c++) text += format("%.17g", x.get(r, c)) + (c<x.numCols()-1 ? " " : "\n");
+    }
+    writeText(text);
+}
+
+
+template <class T>
+static void checkStream(const char *type)
+{
+    const int R = 1000, C = 13;
+    const int blockSizes[] = {1, 7, 64, 100, R, 5000};
+    MatrixT<T> d(R, C);
+
+    // columns far from 0 for the mean and the variance to matter
+    d.mapIndex([](int, int c, double) { return (c%3==0 ? 1000.0*c : 0.0) + randPMUnit()*(c+1); });
+    MatrixT<T> mean = d.meanVec(), stddev = d.stddevVec(), cov = d.cov(), work(d), minMax = work.normalizeCols();
+
+    writeMatrixText(d);
+    d.writeBinary(scratchMatrix);
+    for (const char *file : {scratchText, scratchMatrix}) {
+        for (int blockRows : blockSizes) {
+            std::string at = std::string(type) + (file==scratchText ? " text" : " binary") + format(" blockRows %.0f", blockRows);
+            MatrixRowStreamT<T> s(file, blockRows);
+            bool rowsOk = s.numRows()==R && s.numCols()==C;
+            int n = 0;
+
+            // part of a walk, which a reduction restarts
+            for (s.rowBegin(); s.rowNotEnd() && n<R/2; s.rowNext()) n++;
+            check(equal(s.meanVec(), mean), "MatrixRowStream meanVec", at);
+
+            n = 0;
+            for (MatrixT<T> *row = s.rowBegin(); s.rowNotEnd(); row = s.rowNext()) {
+                rowsOk = rowsOk && s.row()==n && row->numCols()==C && n<R;
+                for (int c=0; rowsOk && c<C; c++) rowsOk = row->get(0, c)==d.get(n, c);
+                n++;
+            }
+            check(rowsOk && n==R, "MatrixRowStream rows", at);
+
+            n = 0;
+            for (MatrixT<T> *block = s.blockBegin(); s.blockNotEnd(); block = s.blockNext()) {
+                rowsOk = rowsOk && s.blockRow()==n && block->numRows()<=blockRows
+                    && equal(*block, d.extract(n, 0, block->numRows(), C));
+                n += block->numRows();
+            }
+            check(rowsOk && n==R, "MatrixRowStream blocks", at);
+
+            check(equal(s.stddevVec(), stddev), "MatrixRowStream stddevVec", at);
+            check(equal(s.minMax(), minMax), "MatrixRowStream minMax", at);
+            // a rounding for each of up to R merges of blocks
+            check(difference(s.cov(), cov) < R*std::numeric_limits<T>::epsilon(), "MatrixRowStream cov", at);
+        }
+    }
+    remove(scratchText);
+    remove(scratchMatrix);
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Binary files
+//
+// writeBinary then readBinary (into either element type) or mapBinary
+// gives back the matrix and its labels.  A file that is cut short or has
+// a bad header stops readBinary, mapBinary and MatrixRowStream with an
+// ERROR rather than reading past the end.
+//
+
+// the labels of a matrix of r rows (one of them empty)
+static std::vector<std::string> makeLabels(int r)
+{
+    std::vector<std::string> labels;
+
+    for (int i=0; i<r; i++) labels.push_back(i==1 ? "" : format("row%.0f", i) + std::string(i%5, 'x'));
+    return labels;
+}
+
+
+// labels as readBinary returns them (and frees them)
+static bool sameLabels(char **got, const std::vector<std::string> &want)
+{
+    bool ok = (got!=NULL);
+
+    for (size_t i=0; ok && i<want.size(); i++) ok = want[i]==got[i];
+    if (got!=NULL) {
+        for (size_t i=0; i<want.size(); i++) delete [] got[i];
+        delete [] got;
+    }
+    return ok;
+}
+
+
+template <class T>
+static void checkBinary(const char *type)
+{
+    const int shapes[][2] = {{1, 1}, {3, 13}, {100, 64}, {1000, 33}};
+
+    for (const int *shape : shapes) {
+        const int R = shape[0], C = shape[1];
+        std::string at = std::string(type) + format(" %.0f X %.0f", R, C);
+        MatrixT<T> d = randomMatrix<T>(R, C);
+        std::vector<std::string> labels = makeLabels(R);
+        std::vector<char *> labelPtrs;
+
+        for (std::string &s : labels) labelPtrs.push_back((char *)s.c_str());
+
+        for (bool labeled : {false, true}) {
+            std::string where = at + (labeled ? " labeled" : "");
+            MatrixT<double> asDouble;
+            MatrixT<float> asFloat;
+            MatrixT<T> mapped, again;
+            char **got;
+
+            d.writeBinary(scratchMatrix, labeled ? labelPtrs.data() : NULL);
+
+            got = asDouble.readBinary(scratchMatrix);
+            check(equal(asDouble, MatrixT<double>(d)), "readBinary to double", where);
+            check(labeled ? sameLabels(got, labels) : got==NULL, "readBinary labels", where);
+
+            got = asFloat.readBinary(scratchMatrix);
+            check(equal(asFloat, MatrixT<float>(d)), "readBinary to float", where);
+            check(labeled ? sameLabels(got, labels) : got==NULL, "readBinary labels", where);
+
+            // a mapped matrix can be changed but the file is not
+            got = mapped.mapBinary(scratchMatrix);
+            check(equal(mapped, d), "mapBinary", where);
+            check(labeled ? sameLabels(got, labels) : got==NULL, "mapBinary labels", where);
+            mapped.set(R-1, C-1, 12345.0);
+            got = again.readBinary(scratchMatrix);
+            check(equal(again, d), "mapBinary leaves the file", where);
+            if (labeled) sameLabels(got, labels);
+        }
+    }
+    remove(scratchMatrix);
+}
+
+
+#ifndef WINDOWS
+// the scratch file changed: bytes at offset (or cut to size if bytes is empty)
+static void patchBinary(const std::string &file, size_t offset, const std::string &bytes, size_t size=0)
+{
+    std::string text = file;
+
+    if (bytes.empty()) text.resize(size);
+    else text.replace(offset, bytes.size(), bytes);
+    writeText(text);
+}
+
+
+// A bad binary file stops every reader.  These run in child processes so
+// they come before anything starts the threads of the pool.
+static void checkBinaryErrors()
+{
+    // offsets in the 64 byte header: magic 0, endian 4, version 8,
+    // elementBytes 12, rows 16, cols 24, stride 32, labelBytes 40, dataOffset 48
+    const long long minusOne = -1, tooBig = 1LL<<40, two = 2;
+    const unsigned int swapped = 0x04030201, version = 99, elementBytes = 2;
+    const long long stride = 3, dataOffset = 64;
+    const struct {
+        const char *what;
+        size_t offset;
+        std::string bytes;
+        size_t size;
+    } bad[] = {
+        {"empty", 0, "", 0},
+        {"cut in the header", 0, "", 40},
+        {"cut in the elements", 0, "", 64*2 + 8*16*3},
+        {"magic", 0, "MATX", 0},
+        {"byte order", 4, std::string((const char *)&swapped, 4), 0},
+        {"version", 8, std::string((const char *)&version, 4), 0},
+        {"element type", 12, std::string((const char *)&elementBytes, 4), 0},
+        {"rows", 16, std::string((const char *)&minusOne, 8), 0},
+        {"too many rows", 16, std::string((const char *)&tooBig, 8), 0},
+        {"cols", 24, std::string((const char *)&minusOne, 8), 0},
+        {"stride under cols", 32, std::string((const char *)&stride, 8), 0},
+        {"labels over the elements", 48, std::string((const char *)&dataOffset, 8), 0},
+        {"dataOffset", 48, std::string((const char *)&two, 8), 0},
+        {"labels with no ends", 64, std::string(30, 'x'), 0},
+    };
+    MatrixT<double> d = randomMatrix<double>(10, 13);
+    std::vector<std::string> labels = makeLabels(10);
+    std::vector<char *> labelPtrs;
+    std::string file;
+
+    for (std::string &s : labels) labelPtrs.push_back((char *)s.c_str());
+    d.writeBinary(scratchMatrix, labelPtrs.data());
+    {
+        FILE *fp = fopen(scratchMatrix, "rb");
+        char buffer[4096];
+        size_t n;
+
+        while ((n = fread(buffer, 1, sizeof(buffer), fp))>0) file.append(buffer, n);
+        fclose(fp);
+    }
+
+    for (const auto &b : bad) {
+        patchBinary(file, b.offset, b.bytes, b.size);
+        check(exitsWithError([]() { MatrixT<double> x; x.readBinary(scratchText); }), "readBinary stops", b.what);
+        check(exitsWithError([]() { MatrixT<double> x; x.mapBinary(scratchText); }), "mapBinary stops", b.what);
+        if (b.offset<64)
+            check(exitsWithError([]() { MatrixRowStreamT<double> s(scratchText, 4); s.meanVec(); }), "MatrixRowStream stops", b.what);
+    }
+    writeText(file);
+    check(exitsWithError([]() { MatrixT<float> x; x.mapBinary(scratchText); }), "mapBinary of the other type stops");
+    check(!exitsWithError([]() { MatrixT<double> x; sameLabels(x.readBinary(scratchText), makeLabels(10)); }), "readBinary of the good file");
+    check(!exitsWithError([]() { MatrixT<double> x; sameLabels(x.mapBinary(scratchText), makeLabels(10)); }), "mapBinary of the good file");
+    check(!exitsWithError([]() { MatrixRowStreamT<double> s(scratchText, 4); s.meanVec(); }), "MatrixRowStream of the good file");
+
+    remove(scratchText);
+    remove(scratchMatrix);
+}
+#endif
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Eigenvectors
+//
+// eigenSystemTopK against eigenSystem on symmetric matrices made from a
+// chosen spectrum.  A spectrum that falls off fast settles in a few
+// passes of the subspace iteration.  A flat one does not settle in the
+// passes allowed and a small matrix has a block too big for the
+// iteration, so those two fall back to the full eigenSystem.
+//
+
+// Q^T diag(values) Q for a random orthogonal Q
+template <class T>
+static MatrixT<T> symmetricMatrix(const std::vector<double> &values)
+{
+    const int n = values.size();
+    std::vector<std::vector<double>> q(n, std::vector<double>(n));
+    MatrixT<T> a(n, n);
+
+    // Gram-Schmidt twice over on random rows
+    for (int i=0; i<n; i++) {
+        for (int c=0; c<n; c++) q[i][c] = randPMUnit();
+        for (int pass=0; pass<2; pass++) {
+            for (int j=0; j<i; j++) {
+                double dot = 0;
+
+                for (int c=0; c<n; c++) dot += q[i][c]*q[j][c];
+                for (int c=0; c<n; c++) q[i][c] -= dot*q[j][c];
+            }
+            double norm = 0;
+            for (int c=0; c<n; c++) norm += q[i][c]*q[i][c];
+            for (int c=0; c<n; c++) q[i][c] /= sqrt(norm);
+        }
+    }
+
+    for (int r=0; r<n; r++) {
+        for (int c=r; c<n; c++) {
+            double sum = 0;
+
+            for (int i=0; i<n; i++) sum += q[i][r]*values[i]*q[i][c];
+            a.set(r, c, sum);
+            a.set(c, r, sum);
+        }
+    }
+    return a;
+}
+
+
+template <class T>
+static void checkEigen(const char *type)
+{
+    const double tol = sizeof(T)==sizeof(float) ? 1e-3 : 1e-8;
+    const int k = 5;
+
+    for (int shape=0; shape<3; shape++) {
+        const int n = (shape==2) ? 30 : 200;
+        const char *what = (shape==0) ? "falling spectrum" : (shape==1) ? "flat spectrum" : "small matrix";
+        std::string at = std::string(type) + " " + what;
+        std::vector<double> spectrum;
+
+        // the largest magnitudes have both signs.  The fall ends in a tail of
+        // distinct values since a cluster of equal ones is slow for eigenSystem.
+        for (int i=0; i<n; i++) {
+            double x = (shape==1) ? 10.0 - 0.01*i : 100.0*pow(0.5, i) + 1e-3*(n-i)/n;
+
+            spectrum.push_back((i%3==1) ? -x : x);
+        }
+        MatrixT<T> a = symmetricMatrix<T>(spectrum), full(a), top(a);
+        MatrixT<T> allValues = full.eigenSystem(), values = top.eigenSystemTopK(k);
+
+        check(values.numRows()==1 && values.numCols()==k && top.numRows()==k && top.numCols()==n, "eigenSystemTopK size", at);
+        for (int i=0; i<k; i++) {
+            double cos = 0, norm = 0;
+
+            for (int c=0; c<n; c++) {
+                cos += (double)top.get(i, c)*full.get(i, c);
+                norm += (double)top.get(i, c)*top.get(i, c);
+            }
+            check(fabs(values.get(0, i) - allValues.get(0, i)) <= tol*fabs(allValues.get(0, 0)), "eigenSystemTopK value",
+                  at + format(" %.0f: %.17g not %.17g", i, values.get(0, i), allValues.get(0, i)));
+            check(fabs(values.get(0, i) - spectrum[i]) <= tol*fabs(spectrum[0]), "eigenSystem value",
+                  at + format(" %.0f: %.17g not %.17g", i, allValues.get(0, i), spectrum[i]));
+            check(fabs(fabs(cos) - 1) <= tol && fabs(norm - 1) <= tol, "eigenSystemTopK vector",
+                  at + format(" %.0f: |cos| %.17g norm %.17g", i, fabs(cos), norm));
+        }
+    }
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Fixed size matrices
+//
+// A FixedMatrix must do what the same Matrix does.  Its products add the
+// terms in the order of the Matrix triple loop so they agree bit for bit.
+//
+
+template <class T, int R, int C, int K>
+static void checkFixed(const char *type)
+{
+    std::string at = std::string(type) + format(" %.0f X %.0f X %.0f", R, C, K);
+    MatrixT<T> data = randomMatrix<T>(R+5, C+3), w = randomMatrix<T>(C, K);
+    FixedMatrixT<T, R, C> q(data, 2, 3), p(data, 4, 1);
+    MatrixT<T> mq = data.extract(2, 3, R, C), mp = data.extract(4, 1, R, C);
+
+    check(equal(q.toMatrix(), mq) && equal(FixedMatrixT<T, R, C>().extract(data, 4, 1).toMatrix(), mp), "FixedMatrix extract", at);
+    check(equal(FixedMatrixT<T, R, C>(1.5).toMatrix(), MatrixT<T>(R, C).constant(1.5)), "FixedMatrix constant", at);
+    check(equal(q.transpose().toMatrix(), mq.transpose()), "FixedMatrix transpose", at);
+
+    // into a Matrix at a corner and in the middle
+    for (int r : {0, 5}) {
+        MatrixT<T> x(data), y(data);
+
+        x.insert(q, r, 3);
+        y.insert(mq, r, 3);
+        check(equal(x, y), "FixedMatrix insert", at);
+    }
+
+    // products
+    {
+        FixedMatrixT<T, C, K> fw(w);
+        FixedMatrixT<T, R, K> h(-1.0);
+
+        q.dotInto(w, h);
+        check(equal(h.toMatrix(), mq.dot(w)), "FixedMatrix dotInto", at);
+        check(equal(q.dot(fw).toMatrix(), mq.dot(w)), "FixedMatrix dot", at);
+    }
+
+    // element by element
+    {
+        FixedMatrixT<T, R, C> x(q);
+        MatrixT<T> y(mq);
+
+        x.add(p).mult(q).sub(p).scalarMult(0.5).map([](double v) { return v*v + 1; });
+        y.add(mp);
+        y.mult(mq);
+        y.sub(mp);
+        y.scalarMult(0.5);
+        y.map([](double v) { return v*v + 1; });
+        check(equal(x.toMatrix(), y), "FixedMatrix add, mult, sub, scalarMult and map", at);
+    }
+
+    // squared distances as Matrix::dist2 makes them
+    {
+        bool same = true;
+
+        check(q.dist2(p)==mq.dist2(mp), "FixedMatrix dist2", at);
+
+        FixedMatrixT<T, 1, C> row(data, 1, 0);
+        MatrixT<T> mrow = row.toMatrix();
+        for (int r=0; r<data.numRows(); r++) same = same && row.dist2(data, r, 3)==mrow.dist2(data.extract(r, 3, 1, C));
+        check(same, "FixedMatrix dist2 to a Matrix row", at);
+    }
+}
+
+
+#ifndef WINDOWS
+// a FixedMatrix that does not fit where it meets a Matrix stops with an ERROR
+static void checkFixedErrors()
+{
+    MatrixT<double> data = randomMatrix<double>(6, 5), w = randomMatrix<double>(4, 2);
+    FixedMatrixT<double, 2, 3> q(data, 0, 0);
+    FixedMatrixT<double, 1, 3> row(data, 0, 0);
+
+    check(exitsWithError([&]() { FixedMatrixT<double, 2, 3> x(data, 5, 0); }), "FixedMatrix extract past the rows stops");
+    check(exitsWithError([&]() { FixedMatrixT<double, 2, 3> x(data, 0, 3); }), "FixedMatrix extract past the columns stops");
+    check(exitsWithError([&]() { MatrixT<double> x(data); x.insert(q, 0, 3); }), "FixedMatrix insert past the columns stops");
+    check(exitsWithError([&]() { FixedMatrixT<double, 2, 2> h; q.dotInto(w, h); }), "FixedMatrix dotInto of the wrong size stops");
+    check(exitsWithError([&]() { row.dist2(data, 6, 0); }), "FixedMatrix dist2 past the rows stops");
+    check(exitsWithError([&]() { row.dist2(data, 0, 3); }), "FixedMatrix dist2 past the columns stops");
+    check(!exitsWithError([&]() { MatrixT<double> x(data); x.insert(q, 4, 2); row.dist2(data, 5, 2); }), "FixedMatrix that fits");
+}
+#endif
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Covariance accumulators
+//
+// Accumulators over uneven pieces of the rows, by add and by addRow, are
+// merged and must give the covariance of all the rows.  The columns are
+// far from zero with a small spread, where adding up sums of squares
+// would lose every digit and only the merge by deviations keeps them.
+//
+
+// the mean (1 X C) and covariance (C X C, divided by n) of x in long
+// double by two passes
+template <class T>
+static void referenceCov(const MatrixT<T> &x, MatrixT<double> &mean, MatrixT<double> &cov)
+{
+    const int R = x.numRows(), C = x.numCols();
+    std::vector<long double> mu(C, 0.0L);
+
+    for (int r=0; r<R; r++) for (int c=0; c<C; c++) mu[c] += x.get(r, c);
+    for (int c=0; c<C; c++) mu[c] /= R;
+    for (int i=0; i<C; i++) {
+        mean.set(0, i, mu[i]);
+        for (int j=0; j<C; j++) {
+            long double sum = 0;
+
+            for (int r=0; r<R; r++) sum += (x.get(r, i) - mu[i])*(x.get(r, j) - mu[j]);
+            cov.set(i, j, sum/R);
+        }
+    }
+}
+
+
+template <class T>
+static void checkCovAccumulator(const char *type)
+{
+    const int R = 2000, C = 9;
+    const int cuts[] = {0, 1, 2, 10, 333, 334, 1500, 1999, 2000};   // pieces of 1 to 1166 rows
+    const int pieces = sizeof(cuts)/sizeof(cuts[0]) - 1;
+
+    for (double offset : {0.0, 1e6}) {
+        std::string at = std::string(type) + format(" mean %g", offset);
+        // the deviations lose about offset roundings of a double (sums of
+        // squares would lose everything), then the answer is rounded to T
+        const double tol = std::max(100.0*std::numeric_limits<T>::epsilon(), 10*std::numeric_limits<double>::epsilon()*(1 + offset));
+        MatrixT<T> x(R, C);
+        MatrixT<double> mean(1, C), cov(C, C);
+
+        x.mapIndex([=](int, int c, double) { return offset*(c+1) + randPMUnit()*(c+1); });
+        for (int r=0; r<R; r++) x.set(r, C-1, x.get(r, 0) + x.get(r, 1));   // a column that depends on others
+        mean.constant(0.0);
+        cov.constant(0.0);
+        referenceCov(x, mean, cov);
+
+        // the even pieces by add and the odd ones a row at a time, merged
+        // from the last piece back and into an empty accumulator
+        {
+            std::vector<CovAccumulatorT<T> *> acc;
+            CovAccumulatorT<T> all;
+
+            for (int p=0; p<pieces; p++) {
+                MatrixT<T> rows = x.extract(cuts[p], 0, cuts[p+1]-cuts[p], C);
+
+                acc.push_back(new CovAccumulatorT<T>(C));
+                if (p%2==0) acc[p]->add(rows);
+                else for (int r=0; r<rows.numRows(); r++) acc[p]->addRow(rows, r);
+            }
+            for (int p=pieces-1; p>0; p--) acc[p-1]->merge(*acc[p]);
+            all.merge(*acc[0]);
+
+            check(all.count()==R && all.numCols()==C, "CovAccumulator count", at);
+            check(difference(MatrixT<double>(all.meanVec()), mean) < tol, "CovAccumulator meanVec", at);
+            check(difference(MatrixT<double>(all.cov()), cov) < tol, "CovAccumulator cov", at);
+
+            MatrixT<double> unbiased(cov);
+            unbiased.scalarMult((double)R/(R-1));
+            check(difference(MatrixT<double>(all.cov(true)), unbiased) < tol, "CovAccumulator unbiased cov", at);
+
+            for (CovAccumulatorT<T> *a : acc) delete a;
+        }
+
+        // one add of all the rows and Matrix::cov agree with it too
+        {
+            CovAccumulatorT<T> one;
+            MatrixT<T> y(x);
+
+            one.add(x);
+            check(difference(MatrixT<double>(one.cov()), cov) < tol, "CovAccumulator add all", at);
+            check(difference(MatrixT<double>(y.cov()), cov) < tol, "Matrix cov", at);
+        }
+
+        // cleared and used again
+        {
+            CovAccumulatorT<T> a(C);
+            MatrixT<T> rows = x.extract(0, 0, 10, C);
+
+            a.add(rows);
+            a.clear();
+            a.add(x);
+            check(a.count()==R && difference(MatrixT<double>(a.cov()), cov) < tol, "CovAccumulator clear", at);
+        }
+    }
+}
+
+
+
+// // // // // // // // // // // // // // // // // // // // // // // // // // // // // //
+//
+// Images
+//
+// writeImagePgm and writeImagePpm then readImagePgm and readImagePpm give
+// back the pixels for 8 and 16 bit samples, binary and ascii.  Pixels
+// outside 0 to maxval are written clamped and fractions are cut off.
+//
+
+static const char *scratchImage = "matcheck.tmp.pnm";
+
+
+// the first two bytes of the scratch image (the magic number)
+static std::string imageMagic()
+{
+    char magic[3] = "";
+    FILE *fp = fopen(scratchImage, "rb");
+
+    if (fp!=NULL) {
+        if (fread(magic, 1, 2, fp)!=2) magic[0] = '\0';
+        magic[2] = '\0';
+        fclose(fp);
+    }
+    return magic;
+}
+
+
+template <class T>
+static void checkImages(const char *type)
+{
+    const int shapes[][2] = {{1, 1}, {37, 53}, {300, 200}};
+
+    for (const int *shape : shapes) {
+        for (int maxval : {255, 65535}) {
+            for (bool ascii : {false, true}) {
+                for (int channels : {1, 3}) {
+                    const int R = shape[0], C = shape[1]*channels;
+                    std::string at = std::string(type) + format(" %.0f X %.0f maxval %.0f", R, C, maxval)
+                        + (channels==1 ? " pgm" : " ppm") + (ascii ? " ascii" : " binary");
+                    MatrixT<T> image(R, C, "picture"), want(R, C), back;
+
+                    // every sample value at the ends and random ones, a few
+                    // outside the range and some with fractions
+                    image.mapIndex([=](int r, int c, double) {
+                        int k = r*C + c;
+
+                        if (k<2) return k==0 ? 0.0 : (double)maxval;
+                        if (k%97==3) return -5.0;
+                        if (k%89==4) return maxval + 7.0;
+                        if (k%83==5) return randMod(maxval) + 0.75;
+                        return (double)randMod(maxval + 1);
+                    });
+                    want.constant(0.0);
+                    for (int r=0; r<R; r++) {
+                        for (int c=0; c<C; c++) want.set(r, c, std::min(std::max(floor(image.get(r, c)), 0.0), (double)maxval));
+                    }
+
+                    if (channels==1) {
+                        image.writeImagePgm(scratchImage, "matcheck", maxval, ascii);
+                        back.readImagePgm(scratchImage, "back");
+                        check(imageMagic()==(ascii ? "P2" : "P5"), "writeImagePgm magic", at);
+                    }
+                    else {
+                        image.writeImagePpm(scratchImage, "matcheck", maxval, ascii);
+                        back.readImagePpm(scratchImage, "back");
+                        check(imageMagic()==(ascii ? "P3" : "P6"), "writeImagePpm magic", at);
+                    }
+                    check(equal(back, want), "image round trip", at);
+                }
+            }
+        }
+    }
+    remove(scratchImage);
+}
+
+
+
+static void usage()
+{
+    printf("usage: matcheck [-f text]\n");
+    exit(1);
+}
+
+
+int main(int argc, char *argv[])
+{
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-f")==0 && i+1<argc) only = argv[++i];
+        else usage();
+    }
+
+    initRand(1, 2);
+    printf("matcheck: %d threads, %s kernels\n", MatrixBase::numThreads(), MatrixBase::simdName());
+
+#ifndef WINDOWS
+    if (wanted("solvers")) {
+        checkSolverErrors<double>("double");
+        checkSolverErrors<float>("float");
+    }
+    if (wanted("binary")) checkBinaryErrors();
+    if (wanted("fixed")) checkFixedErrors();
+#endif
+    if (wanted("products")) {
+        checkProducts<double>("double");
+        checkProducts<float>("float");
+    }
+    if (wanted("solvers")) {
+        checkSolvers<double>("double");
+        checkSolvers<float>("float");
+    }
+    if (wanted("sort")) {
+        checkSorts<double>("double");
+        checkSorts<float>("float");
+    }
+    if (wanted("fixed")) {
+        checkFixed<double, 1, 3, 4>("double");
+        checkFixed<double, 3, 4, 2>("double");
+        checkFixed<double, 4, 7, 9>("double");
+        checkFixed<float, 1, 3, 4>("float");
+        checkFixed<float, 2, 16, 5>("float");
+    }
+    if (wanted("eigen")) {
+        checkEigen<double>("double");
+        checkEigen<float>("float");
+    }
+    if (wanted("text")) checkReadText();
+    if (wanted("sparse")) {
+        checkSparse<double>("double");
+        checkSparse<float>("float");
+    }
+    if (wanted("binary")) {
+        checkBinary<double>("double");
+        checkBinary<float>("float");
+    }
+    if (wanted("cov")) {
+        checkCovAccumulator<double>("double");
+        checkCovAccumulator<float>("float");
+    }
+    if (wanted("image")) {
+        checkImages<double>("double");
+        checkImages<float>("float");
+    }
+    if (wanted("stream")) {
+        checkStream<double>("double");
+        checkStream<float>("float");
+    }
+
+    printf("matcheck: %d checks, %d failures\n", checks, failures);
+
+    return failures>0 ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+// Convert a matrix between the text form read by Matrix::read() and
+// Matrix::readLabeledRow() and the binary form of Matrix::writeBinary().
+// Convert a data set once and programs can then load it with
+// readBinary() or mapBinary() instead of parsing the text every run.
+//
+// usage: matconvert [-l] [-f] out.matb < in.txt      text to binary
+//        matconvert -t in.matb > out.txt              binary to text
+//
+//   -l   the text has a label at the start of each row
+//   -f   store floats rather than doubles (half the size)
+//   -t   convert a binary file back to text (labels are kept)
+//
+#include <stdio.h>
+#include <string.h>
+#include "mat.h"
+
+static void usage()
+{
+    printf("usage: matconvert [-l] [-f] out.matb < in.txt\n");
+    printf("       matconvert -t in.matb > out.txt\n");
+    exit(1);
+}
+
+
+// print in the text form so read() or readLabeledRow() gets back the same numbers
+static void writeText(Matrix &x, char **labels)
+{
+    printf("%d %d\n", x.numRows(), x.numCols());
+    for (int r=0; r<x.numRows(); r++) {
+        for (int c=0; c<x.numCols(); c++) {
+            if (labels!=NULL && c==0) printf("%s", labels[int(x.get(r, 0))]);
+            else printf("%.17lg", x.get(r, c));
+            printf(c<x.numCols()-1 ? " " : "\n");
+        }
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    bool labeled, floats, toText;
+    char *filename;
+    char **labels;
+
+    labeled = floats = toText = false;
+    filename = NULL;
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-l")==0) labeled = true;
+        else if (strcmp(argv[i], "-f")==0) floats = true;
+        else if (strcmp(argv[i], "-t")==0) toText = true;
+        else if (argv[i][0]!='-' && filename==NULL) filename = argv[i];
+        else usage();
+    }
+    if (filename==NULL || (toText && (labeled || floats))) usage();
+
+    if (toText) {
+        Matrix x;
+
+        labels = x.readBinary(filename);
+        writeText(x, labels);
+    }
+    else {
+        Matrix x;
+
+        labels = labeled ? x.readLabeledRow() : NULL;
+        if (!labeled) x.read();
+
+        if (floats) {
+            MatrixF f(x);
+
+            f.writeBinary(filename, labels);
+        }
+        else {
+            x.writeBinary(filename, labels);
+        }
+    }
+
+    return 0;
+}
@@ -39,7 +39,7 @@ int main ()
 	Matrix _T;
 	// training 
 	do{
-		Y=s.dot(W);
+		s.dotInto(W, Y);
 		for (int i=0;i<max_r;i++)
 		{
 			for(int j=0; j<results_cols;j++)
@@ -54,7 +54,8 @@ int main ()
 		{
 			//W+ = αXT(T − Y )
 			_T=T;
-			W.add(s.Tdot(_T.sub(Y)).scalarMult(eat));
+			_T.sub(Y);
+			s.TdotInto(_T, W, eat, 1.0);
 		}
 		else
 			break;
@@ -4,9 +4,8 @@
 #include "mat.h"
 #include "rand.h"
 
-//double f(double x) { return 2*(1.0/double (1.0 + exp(-2*x))-1); };
-double f(double x) { return (1.0/double (1.0 + exp(-4.0*x))); };
-double g(double x){ return (x <0.5 ? 0.0 : 1.0);  }
+// activation f(x) = 1/(1 + exp(-4x)) is done with mapLogistic(4.0)
+// and the output threshold g(x) = (x < 0.5 ? 0 : 1) with mapStep(0.5)
 double  eat=0.1;
 
 int main ()
@@ -41,35 +40,29 @@ int main ()
      V.rand(-0.2,0.2);
      //initialize withe bisa
      H_.constant(-1.0);
-     Matrix temp1, temp2,temp3, temp4, temp5;
+     Matrix temp4, temp5;
+     MatrixWorkspace ws;   // each pass reuses the storage of the temporaries of the last
      for (int i =0; i<10000; i++){
         // H = f(XV)   
-        H = (S.dot(V)).map(f);
-        //H.map(f);
+        S.dotInto(V, H);
+        H.mapLogistic(4.0);
         H_.insert(H, 0 ,0);
         // Y = f(H_W)       
-        Y= (H_.dot(W)).map(f);
-        //Y.map(f);
+        H_.dotInto(W, Y);
+        Y.mapLogistic(4.0);
         // delate_W = (Y-T)*Y*(1-Y)
         
-        temp1= Y;
-         temp1.sub(T);
-        temp2= Y;
-         temp2.scalarPreSub(1);
-        delat_W = (temp1.mult(Y)).mult(temp2);
+        delat_W = (Y - T) * Y * (1 - Y);
         // delate_H = H_ *(1-H_)*(delate_W Wt)
-        temp3 = H_;
-        temp3.scalarPreSub(1);
-        temp4 =delat_W;
-        temp4 = temp4.dotT(W);
-        delat_H = (temp3.mult(H_)).mult(temp4);
+        delat_W.dotTInto(W, temp4);
+        delat_H = (1 - H_) * H_ * temp4;
         // W-= eat*H_t delat_W
-        W.sub((H_.Tdot(delat_W)).scalarMult(eat));
+        H_.TdotInto(delat_W, W, -eat, 1.0);
           //V − = αX+T delat_H−
           //delat_H.print();
           //delat_H.extract(0,0,max_r,h).print();
          temp5=delat_H.extract(0,0,max_r,h);
-        V.sub((S.Tdot(temp5)).scalarMult(eat));
+        S.TdotInto(temp5, V, -eat, 1.0);
      }
      // H = f(XV)
         Matrix NX, NXX;
@@ -85,13 +78,13 @@ int main ()
         NS.insert(NX,0,0);
         NH.constant(0.0);
         NH = NS.dot(V);
-        NH.map(f);
+        NH.mapLogistic(4.0);
         NH_.constant(-1.0);
         NH_.insert(NH, 0 ,0);
         // Y = f(H_W)
         NY= NH_.dot(W);
-        NY.map(f);
-        //NY.map(g);
+        NY.mapLogistic(4.0);
+        //NY.mapStep(0.5);
         double m=0;
         int locat;
         for (int i=0; i < NX.maxRows(); i++)